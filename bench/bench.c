@@ -0,0 +1,95 @@
+#if !defined(_WIN32)
+    #define _POSIX_C_SOURCE 199309L
+    #include <time.h>
+#else
+    #include <windows.h>
+#endif
+
+#include <stdlib.h>
+
+#include "bench.h"
+
+
+static int compare_doubles(const void* a, const void* b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+double bench_now(void){
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+dast_u64 bench_rand(dast_u64* state){
+    dast_u64 z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void bench_fill_keys(char* buf, dast_sz n, dast_sz key_len, dast_u64 seed){
+    dast_u64 state = seed;
+    for(dast_sz i = 0; i != n * key_len; i += sizeof(dast_u64)){
+        dast_u64 r = bench_rand(&state);
+        dast_sz left = n * key_len - i;
+        dast_memcpy(buf + i, &r, left < sizeof(r) ? left : sizeof(r));
+    }
+}
+
+dast_sz bench_rss(void){
+#if defined(__linux__)
+    unsigned long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if(!f) return 0;
+    if(fscanf(f, "%lu %lu", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return (dast_sz)resident * 4096;
+#else
+    return 0;
+#endif
+}
+
+dast_sz bench_peak_rss(void){
+#if defined(__linux__)
+    char line[128];
+    unsigned long kib = 0;
+    FILE* f = fopen("/proc/self/status", "r");
+    if(!f) return 0;
+    while(fgets(line, sizeof(line), f)){
+        if(sscanf(line, "VmHWM: %lu kB", &kib) == 1) break;
+    }
+    fclose(f);
+    return (dast_sz)kib * 1024;
+#else
+    return 0;
+#endif
+}
+
+void bench_reset_peak_rss(void){
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if(!f) return;
+    fputs("5", f);
+    fclose(f);
+#endif
+}
+
+void bench_report(const char* label, dast_sz ops, double seconds){
+    printf("  %-36s %10.2f Mop/s  (%.3f s)\n", label, (double)ops / seconds * 1e-6, seconds);
+}
+
+void bench_report_latency(const char* label, double* samples, dast_sz n){
+    if(n == 0) return;
+    qsort(samples, n, sizeof(double), compare_doubles);
+    printf("  %-36s p50 %8.3f us  p99.9 %10.3f us  max %10.3f us\n", label,
+        samples[n / 2] * 1e6, samples[n - 1 - n / 1000] * 1e6, samples[n - 1] * 1e6);
+}
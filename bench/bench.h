@@ -0,0 +1,50 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+#include "dast.h"
+
+/** @typedef Benchmark function. `n` is the number of keys to work with */
+typedef void (*bench_fn_t)(dast_sz n);
+
+/** @struct bench_t
+ * @brief Named benchmark, registered in `bench/main.c`
+ */
+typedef struct bench {
+    const char* name;
+    bench_fn_t  fn;
+} bench_t;
+
+#define BENCH(FN) { #FN, FN }
+
+/** @brief Returns a monotonic timestamp in seconds */
+double bench_now(void);
+
+/** @brief Fills `n` keys of `key_len` bytes each with pseudo-random data.
+ * Keys are stored contiguously, key `i` starting at `buf + i * key_len`.
+ * The same seed always produces the same keys.
+ */
+void bench_fill_keys(char* buf, dast_sz n, dast_sz key_len, dast_u64 seed);
+
+/** @brief Returns the next value of a splitmix64 generator */
+dast_u64 bench_rand(dast_u64* state);
+
+/** @brief Returns the resident set size of the process in bytes, or 0 where it cannot be read */
+dast_sz bench_rss(void);
+
+/** @brief Returns the peak resident set size of the process in bytes, or 0 where it cannot be read */
+dast_sz bench_peak_rss(void);
+
+/** @brief Resets the peak resident set size to the current one, where supported */
+void bench_reset_peak_rss(void);
+
+/** @brief Prints a throughput result as millions of operations per second */
+void bench_report(const char* label, dast_sz ops, double seconds);
+
+/** @brief Prints the median, 99.9th percentile and maximum of a set of latencies in seconds.
+ * The samples are sorted in place.
+ */
+void bench_report_latency(const char* label, double* samples, dast_sz n);
+
+#endif /* BENCH_H */
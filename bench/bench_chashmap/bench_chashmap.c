@@ -0,0 +1,132 @@
+#if defined(__unix__)
+    #define _POSIX_C_SOURCE 200112L /* pthreads, sysconf */
+#endif
+
+#include <stdlib.h>
+
+#include "bench_chashmap.h"
+
+#if defined(__unix__)
+    #include <pthread.h>
+    #include <unistd.h>
+    #define BENCH_CHASHMAP_THREADS
+#endif
+
+
+#define KEY_LEN 16
+#define MAX_THREADS 64
+
+
+#ifdef BENCH_CHASHMAP_THREADS
+
+/* STATIC FUNCTIONS */
+
+/** Work shared by the threads of a run */
+typedef struct bench_chashmap_run {
+    chashmap_t*      cmap;    /* Concurrent map, or NULL to use `map` behind `lock` */
+    hashmap_t*       map;
+    pthread_mutex_t* lock;
+    const char*      keys;    /* Key space, twice the number of keys loaded beforehand */
+    dast_sz          n_keys;
+    dast_sz          ops;     /* Operations per thread */
+    dast_u32         read_pct;
+} bench_chashmap_run_t;
+
+typedef struct bench_chashmap_worker {
+    bench_chashmap_run_t* run;
+    dast_u64              seed;
+} bench_chashmap_worker_t;
+
+/** Runs random lookups, and inserts and removals in equal number, over the key space */
+static void* bench_chashmap_worker(void* arg){
+    bench_chashmap_worker_t* worker = arg;
+    bench_chashmap_run_t* run = worker->run;
+    dast_u64 state = worker->seed;
+
+    for(dast_sz i = 0; i != run->ops; ++i){
+        dast_u64 r = bench_rand(&state);
+        const char* key = run->keys + (r % (run->n_keys * 2)) * KEY_LEN;
+        dast_u32 op = (dast_u32)((r >> 40) % 100);
+
+        if(run->cmap){
+            if(op < run->read_pct)  chashmap_getb(run->cmap, key, KEY_LEN);
+            else if(op & 1)         chashmap_setb(run->cmap, key, KEY_LEN, (void*)key);
+            else                    chashmap_removeb(run->cmap, key, KEY_LEN, dast_null);
+            continue;
+        }
+
+        pthread_mutex_lock(run->lock);
+        if(op < run->read_pct)  hashmap_getb(run->map, key, KEY_LEN);
+        else if(op & 1)         hashmap_setb(run->map, key, KEY_LEN, (void*)key);
+        else                    hashmap_removeb(run->map, key, KEY_LEN, dast_null);
+        pthread_mutex_unlock(run->lock);
+    }
+    return dast_null;
+}
+
+/** Runs `threads` workers at once, returning the elapsed time */
+static double bench_chashmap_threads(bench_chashmap_run_t* run, dast_sz threads){
+    pthread_t ids[MAX_THREADS];
+    bench_chashmap_worker_t workers[MAX_THREADS];
+
+    double t0 = bench_now();
+    for(dast_sz t = 0; t != threads; ++t){
+        workers[t] = (bench_chashmap_worker_t){ run, t + 1 };
+        pthread_create(&ids[t], dast_null, bench_chashmap_worker, &workers[t]);
+    }
+    for(dast_sz t = 0; t != threads; ++t){
+        pthread_join(ids[t], dast_null);
+    }
+    return bench_now() - t0;
+}
+
+#endif
+
+
+/* BENCHMARKS */
+
+/* Aggregate throughput of 1 to N threads doing a mix of lookups and writes on `n` keys,
+   for the concurrent map against a `hashmap_t` behind a single mutex */
+void bench_chashmap_scaling(dast_sz n){
+#ifdef BENCH_CHASHMAP_THREADS
+    const dast_u32 read_pcts[] = { 100, 90, 50 };
+    char* keys = malloc(n * 2 * KEY_LEN);
+    char label[64];
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    dast_sz max_threads = cpus > 4 ? (dast_sz)cpus : 4;
+    if(max_threads > MAX_THREADS) max_threads = MAX_THREADS;
+
+    bench_fill_keys(keys, n * 2, KEY_LEN, 1);
+    printf("  %ld CPUs online\n", cpus);
+
+    for(dast_sz r = 0; r != sizeof(read_pcts)/sizeof(read_pcts[0]); ++r){
+        for(dast_sz threads = 1; threads <= max_threads; threads *= 2){
+            chashmap_t cmap;
+            hashmap_t map;
+            pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+            bench_chashmap_run_t run = { dast_null, &map, &lock, keys, n, n / threads + 1, read_pcts[r] };
+            double seconds;
+
+            hashmap_init(&map, n * 2);
+            for(dast_sz i = 0; i != n; ++i) hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, dast_null);
+            seconds = bench_chashmap_threads(&run, threads);
+            snprintf(label, sizeof(label), "%u%% reads, %zu threads, mutex", (unsigned)read_pcts[r], (size_t)threads);
+            bench_report(label, run.ops * threads, seconds);
+            hashmap_uninit(&map);
+
+            chashmap_init(&cmap, n * 2);
+            for(dast_sz i = 0; i != n; ++i) chashmap_setb(&cmap, keys + i * KEY_LEN, KEY_LEN, dast_null);
+            run.cmap = &cmap;
+            seconds = bench_chashmap_threads(&run, threads);
+            snprintf(label, sizeof(label), "%u%% reads, %zu threads, chashmap", (unsigned)read_pcts[r], (size_t)threads);
+            bench_report(label, run.ops * threads, seconds);
+            chashmap_uninit(&cmap);
+        }
+    }
+
+    free(keys);
+#else
+    (void)n;
+    printf("  needs POSIX threads\n");
+#endif
+}
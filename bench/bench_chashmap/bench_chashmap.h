@@ -0,0 +1,15 @@
+#ifndef BENCH_CHASHMAP_H
+#define BENCH_CHASHMAP_H
+
+#include "bench.h"
+#include "chashmap.h"
+
+
+#define BENCH_GROUP_CHASHMAP \
+    BENCH(bench_chashmap_scaling)
+
+
+void bench_chashmap_scaling(dast_sz n);
+
+
+#endif /* BENCH_CHASHMAP_H */
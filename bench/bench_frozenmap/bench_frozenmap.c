@@ -0,0 +1,103 @@
+#include <stdlib.h>
+
+#include "bench_frozenmap.h"
+
+
+#define BENCH_FROZENMAP_KEY_SIZE 16
+
+
+/* STATIC FUNCTIONS */
+
+/* Times lookups in a map of `n` keys of `key_size` bytes, and then in the map frozen from it */
+static void bench_frozenmap_run(const char* mode, hashmap_config_t config, const char* keys, const char* lookups,
+                                dast_sz n, dast_sz key_size, double* samples, dast_sz samples_n){
+    hashmap_t map;
+    hashmap_stats_t stats;
+    frozenmap_t frozen;
+    dast_sz found = 0;
+    char label[64];
+    double t0, t1;
+
+    hashmap_init_config(&map, config);
+    for(dast_sz i = 0; i != n; ++i) hashmap_setb(&map, keys + i * key_size, key_size, (void*)(keys + i * key_size));
+
+    t0 = bench_now();
+    for(dast_sz i = 0; i != n; ++i) found += hashmap_getb(&map, lookups + i * key_size, key_size) != dast_null;
+    t1 = bench_now();
+    snprintf(label, sizeof(label), "getb, %s", mode);
+    bench_report(label, n, t1 - t0);
+    for(dast_sz i = 0; i != samples_n; ++i){
+        t0 = bench_now();
+        found += hashmap_getb(&map, lookups + i * key_size, key_size) != dast_null;
+        samples[i] = bench_now() - t0;
+    }
+    bench_report_latency(label, samples, samples_n);
+    hashmap_stats(&map, &stats);
+    printf("  %-36s %10.1f MiB\n", "bytes", (double)stats.total_bytes / (1 << 20));
+
+    t0 = bench_now();
+    frozenmap_t* result = hashmap_freeze(&frozen, &map);
+    t1 = bench_now();
+    hashmap_uninit(&map);
+    if(!result){
+        printf("  freeze, %s: failed, skipping frozen lookups\n", mode);
+        return;
+    }
+    snprintf(label, sizeof(label), "freeze, %s", mode);
+    bench_report(label, n, t1 - t0);
+    if(frozen.hash_keys) printf("  %-36s %10s\n", "placed by", "key bytes");
+
+    t0 = bench_now();
+    for(dast_sz i = 0; i != n; ++i) found -= frozenmap_getb(&frozen, lookups + i * key_size, key_size) != dast_null;
+    t1 = bench_now();
+    bench_report("getb, frozen", n, t1 - t0);
+    for(dast_sz i = 0; i != samples_n; ++i){
+        t0 = bench_now();
+        found -= frozenmap_getb(&frozen, lookups + i * key_size, key_size) != dast_null;
+        samples[i] = bench_now() - t0;
+    }
+    bench_report_latency("getb, frozen", samples, samples_n);
+    printf("  %-36s %10.1f MiB\n", "bytes", (double)frozen.bytes / (1 << 20));
+    printf("  %-36s %10zu\n", "mismatches", (size_t)found);
+    frozenmap_uninit(&frozen);
+}
+
+
+/* PUBLIC FUNCTIONS */
+
+/* Frozen map against the chained and open-addressing maps it is built from,
+   with half of the lookups missing. Reports the time to freeze, lookup throughput and latency, and bytes held.
+   Random keys are hashed with wyhash, and sequential integer keys with the default hash */
+void bench_frozenmap_lookup(dast_sz n){
+    char* keys = malloc(n * BENCH_FROZENMAP_KEY_SIZE);
+    char* lookups = malloc(n * BENCH_FROZENMAP_KEY_SIZE);
+    dast_sz samples_n = n < 100000 ? n : 100000;
+    double* samples = malloc(samples_n * sizeof(double));
+    dast_u64 state = 9;
+
+    bench_fill_keys(keys, n, BENCH_FROZENMAP_KEY_SIZE, 1);
+    bench_fill_keys(lookups, n, BENCH_FROZENMAP_KEY_SIZE, 2);
+    for(dast_sz i = 0; i < n; i += 2){
+        dast_memcpy(lookups + i * BENCH_FROZENMAP_KEY_SIZE, keys + (bench_rand(&state) % n) * BENCH_FROZENMAP_KEY_SIZE, BENCH_FROZENMAP_KEY_SIZE);
+    }
+    for(int engine = 0; engine != 2; ++engine){
+        bench_frozenmap_run(engine ? "open" : "chained", (hashmap_config_t){
+            .engine = engine ? HASHMAP_ENGINE_OPEN : HASHMAP_ENGINE_CHAINED,
+            .hash_fn = hashmap_wyhash64_hash, .pool_slab_entries = 4096
+        }, keys, lookups, n, BENCH_FROZENMAP_KEY_SIZE, samples, samples_n);
+    }
+
+    /* Integers 0 to n, looked up with misses from n to 2n */
+    dast_u64* ints = (dast_u64*)keys;
+    dast_u64* int_lookups = (dast_u64*)lookups;
+    for(dast_sz i = 0; i != n; ++i){
+        ints[i] = i;
+        int_lookups[i] = (i % 2 == 0) ? bench_rand(&state) % n : n + i;
+    }
+    bench_frozenmap_run("chained, sequential", (hashmap_config_t){.pool_slab_entries = 4096},
+                        keys, lookups, n, sizeof(dast_u64), samples, samples_n);
+
+    free(samples);
+    free(lookups);
+    free(keys);
+}
@@ -0,0 +1,15 @@
+#ifndef BENCH_FROZENMAP_H
+#define BENCH_FROZENMAP_H
+
+#include "bench.h"
+#include "frozenmap.h"
+
+
+#define BENCH_GROUP_FROZENMAP \
+    BENCH(bench_frozenmap_lookup)
+
+
+void bench_frozenmap_lookup(dast_sz n);
+
+
+#endif /* BENCH_FROZENMAP_H */
@@ -0,0 +1,90 @@
+#include <stdlib.h>
+
+#include "bench_hashimage.h"
+
+
+#define KEY_LEN 16
+#define IMAGE_PATH "bench_hashimage.dat"
+
+
+/* STATIC FUNCTIONS */
+
+static dast_sz bench_u64_size(const void* value){ (void)value; return sizeof(dast_u64); }
+
+
+/* PUBLIC FUNCTIONS */
+
+/* Time to rebuild a map from its keys against the time to open a saved image of it, and lookups on both */
+void bench_hashimage_load(dast_sz n){
+    char* keys = malloc(n * KEY_LEN);
+    dast_u64* values = malloc(n * sizeof(dast_u64));
+    const char** lookups = malloc(n * sizeof(char*));
+    dast_u64 state = 2;
+    hashmap_t map;
+    hashimage_t image;
+    double t0, t1;
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+    for(dast_sz i = 0; i != n; ++i) values[i] = i;
+
+    /* Keys are looked up in random order, so that neither side benefits from the order they were added in */
+    for(dast_sz i = 0; i != n; ++i) lookups[i] = keys + i * KEY_LEN;
+    for(dast_sz i = n; i > 1; --i){
+        dast_sz j = (dast_sz)(bench_rand(&state) % i);
+        const char* tmp = lookups[i - 1];
+        lookups[i - 1] = lookups[j];
+        lookups[j] = tmp;
+    }
+
+    t0 = bench_now();
+    hashmap_init(&map, n / HASHMAP_LOADING_FACTOR);
+    for(dast_sz i = 0; i != n; ++i){
+        hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, &values[i]);
+    }
+    t1 = bench_now();
+    printf("  %-36s %10.3f ms\n", "rebuild map", (t1 - t0) * 1e3);
+
+    t0 = bench_now();
+    dast_bool saved = hashimage_save(&map, bench_u64_size, IMAGE_PATH);
+    t1 = bench_now();
+    printf("  %-36s %10.3f ms\n", "save image", (t1 - t0) * 1e3);
+
+    t0 = bench_now();
+    hashimage_t* opened = saved ? hashimage_map(&image, IMAGE_PATH, dast_null, dast_null) : dast_null;
+    t1 = bench_now();
+    printf("  %-36s %10.3f ms\n", "map image", (t1 - t0) * 1e3);
+
+    if(opened){
+        dast_u64 sum = 0;
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i){
+            sum += *(const dast_u64*)hashimage_getb(&image, lookups[i], KEY_LEN);
+        }
+        t1 = bench_now();
+        bench_report("getb, image (first touch)", n, t1 - t0);
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i){
+            sum += *(const dast_u64*)hashimage_getb(&image, lookups[i], KEY_LEN);
+        }
+        t1 = bench_now();
+        bench_report("getb, image", n, t1 - t0);
+        if(sum != (dast_u64)n * (n - 1)) printf("  wrong values\n");
+        hashimage_close(&image);
+    }
+
+    dast_u64 sum = 0;
+    t0 = bench_now();
+    for(dast_sz i = 0; i != n; ++i){
+        sum += *(const dast_u64*)hashmap_getb(&map, lookups[i], KEY_LEN);
+    }
+    t1 = bench_now();
+    bench_report("getb, map", n, t1 - t0);
+    if(sum != (dast_u64)n * (n - 1) / 2) printf("  wrong values\n");
+
+    remove(IMAGE_PATH);
+    hashmap_uninit(&map);
+    free(lookups);
+    free(values);
+    free(keys);
+}
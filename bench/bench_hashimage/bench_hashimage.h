@@ -0,0 +1,15 @@
+#ifndef BENCH_HASHIMAGE_H
+#define BENCH_HASHIMAGE_H
+
+#include "bench.h"
+#include "hashimage.h"
+
+
+#define BENCH_GROUP_HASHIMAGE \
+    BENCH(bench_hashimage_load)
+
+
+void bench_hashimage_load(dast_sz n);
+
+
+#endif /* BENCH_HASHIMAGE_H */
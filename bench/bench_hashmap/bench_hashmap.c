@@ -0,0 +1,596 @@
+#include <stdlib.h>
+
+#include "bench_hashmap.h"
+
+
+#define KEY_LEN 16
+
+
+/* STATIC FUNCTIONS */
+
+static const char* engine_name(hashmap_engine_t engine){
+    return engine == HASHMAP_ENGINE_OPEN ? "open" : "chained";
+}
+
+static const struct { const char* name; hashmap_hashfn_t fn; } hash_fns[] = {
+    { "fnv1a",   hashmap_FNV1a64_hash  },
+    { "wyhash",  hashmap_wyhash64_hash },
+    { "crc32c",  hashmap_crc32c_hash   }
+};
+#define HASH_FN_COUNT (sizeof(hash_fns)/sizeof(hash_fns[0]))
+
+/** Inserts `n` keys into a map initialised from `config`, then looks each one up,
+ * followed by `n` lookups of keys that are not in the map. */
+static void bench_insert_lookup(const char* label, hashmap_config_t config, const char* keys, const char* missing, dast_sz n){
+    char name[64];
+    hashmap_t map;
+    double t0, t1;
+    dast_sz found = 0;
+
+    hashmap_init_config(&map, config);
+
+    t0 = bench_now();
+    for(dast_sz i = 0; i != n; ++i){
+        hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, (void*)(keys + i * KEY_LEN));
+    }
+    t1 = bench_now();
+    snprintf(name, sizeof(name), "%s insert", label);
+    bench_report(name, n, t1 - t0);
+
+    t0 = bench_now();
+    for(dast_sz i = 0; i != n; ++i){
+        found += hashmap_getb(&map, keys + i * KEY_LEN, KEY_LEN) != dast_null;
+    }
+    t1 = bench_now();
+    snprintf(name, sizeof(name), "%s lookup hit", label);
+    bench_report(name, n, t1 - t0);
+
+    t0 = bench_now();
+    for(dast_sz i = 0; i != n; ++i){
+        found += hashmap_getb(&map, missing + i * KEY_LEN, KEY_LEN) != dast_null;
+    }
+    t1 = bench_now();
+    snprintf(name, sizeof(name), "%s lookup miss", label);
+    bench_report(name, n, t1 - t0);
+
+    if(found != n) printf("  (!) %zu keys found, expected %zu\n", (size_t)found, (size_t)n);
+    hashmap_uninit(&map);
+}
+
+
+/* BENCHMARKS */
+
+/* Insert and lookup throughput of the chained and open-addressing engines */
+void bench_hashmap_engines(dast_sz n){
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    char* keys    = malloc(n * KEY_LEN);
+    char* missing = malloc(n * KEY_LEN);
+    char label[64];
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+    bench_fill_keys(missing, n, KEY_LEN, 2);
+
+    for(dast_sz e = 0; e != sizeof(engines)/sizeof(engines[0]); ++e){
+        snprintf(label, sizeof(label), "%s, presized", engine_name(engines[e]));
+        bench_insert_lookup(label, (hashmap_config_t){ .size_hint = n * 2, .engine = engines[e] }, keys, missing, n);
+
+        snprintf(label, sizeof(label), "%s, growing", engine_name(engines[e]));
+        bench_insert_lookup(label, (hashmap_config_t){ .engine = engines[e] }, keys, missing, n);
+    }
+
+    free(keys);
+    free(missing);
+}
+
+/* Per-insert latency of a growing chained map, rehashing all at once or incrementally */
+void bench_hashmap_insert_latency(dast_sz n){
+    const dast_sz budgets[] = { 0, 2, 16, 256 };
+    char* keys = malloc(n * KEY_LEN);
+    double* samples = malloc(n * sizeof(double));
+    char label[64];
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+
+    for(dast_sz b = 0; b != sizeof(budgets)/sizeof(budgets[0]); ++b){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){ .rehash_budget = budgets[b] });
+
+        double start = bench_now(), t0 = start, t1;
+        for(dast_sz i = 0; i != n; ++i){
+            hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, dast_null);
+            t1 = bench_now();
+            samples[i] = t1 - t0;
+            t0 = t1;
+        }
+
+        if(budgets[b]) snprintf(label, sizeof(label), "rehash budget %zu", (size_t)budgets[b]);
+        else           snprintf(label, sizeof(label), "full rehash");
+        bench_report(label, n, t0 - start);
+        bench_report_latency(label, samples, n);
+        hashmap_uninit(&map);
+    }
+
+    free(keys);
+    free(samples);
+}
+
+/* Lookup and resize cost of prime-sized tables against power-of-two tables.
+   Tables start with `2n` buckets, so pass 5000000 or more for 10M+ buckets. */
+void bench_hashmap_sizing(dast_sz n){
+    const hashmap_sizing_t policies[] = { HASHMAP_SIZING_PRIME, HASHMAP_SIZING_POW2 };
+    const char* names[] = { "prime", "pow2" };
+    char* keys = malloc(n * KEY_LEN);
+    char label[64];
+    dast_sz found = 0;
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+
+    for(dast_sz p = 0; p != sizeof(policies)/sizeof(policies[0]); ++p){
+        hashmap_t map;
+        double t0, t1;
+
+        t0 = bench_now();
+        hashmap_init_config(&map, (hashmap_config_t){ .size_hint = n * 2, .sizing = policies[p] });
+        t1 = bench_now();
+        printf("  %s: %zu buckets, init %.3f ms\n", names[p], (size_t)map.size, (t1 - t0) * 1e3);
+
+        for(dast_sz i = 0; i != n; ++i){
+            hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, dast_null);
+        }
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i){
+            found += hashmap_has_keyb(&map, keys + i * KEY_LEN, KEY_LEN);
+        }
+        t1 = bench_now();
+        snprintf(label, sizeof(label), "%s lookup", names[p]);
+        bench_report(label, n, t1 - t0);
+        printf("  %-36s %10.2f ns/lookup\n", "", (t1 - t0) / (double)n * 1e9);
+
+        t0 = bench_now();
+        hashmap_resize(&map);
+        t1 = bench_now();
+        printf("  %-36s %10.3f ms to %zu buckets\n", "resize", (t1 - t0) * 1e3, (size_t)map.size);
+
+        hashmap_uninit(&map);
+    }
+
+    if(found != n * 2) printf("  (!) %zu keys found, expected %zu\n", (size_t)found, (size_t)(n * 2));
+    free(keys);
+}
+
+/* Hashing throughput of each hash function by key length.
+   Every length hashes `n` keys, so throughput is comparable across lengths. */
+void bench_hashmap_hash_throughput(dast_sz n){
+    const dast_sz lengths[] = { 8, 16, 32, 64, 128, 256, 1024 };
+    const dast_sz nkeys = 1024;
+    char label[64];
+
+    for(dast_sz l = 0; l != sizeof(lengths)/sizeof(lengths[0]); ++l){
+        char* keys = malloc(nkeys * lengths[l]);
+        bench_fill_keys(keys, nkeys, lengths[l], 1);
+
+        for(dast_sz f = 0; f != HASH_FN_COUNT; ++f){
+            dast_u64 sink = 0;
+            double t0 = bench_now();
+            for(dast_sz i = 0; i != n; ++i){
+                sink += hash_fns[f].fn(keys + (i % nkeys) * lengths[l], lengths[l]);
+            }
+            double t1 = bench_now();
+            snprintf(label, sizeof(label), "%s, %zu bytes", hash_fns[f].name, (size_t)lengths[l]);
+            bench_report(label, n, t1 - t0);
+            printf("  %-36s %10.2f GB/s  (%llx)\n", "", (double)(n * lengths[l]) / (t1 - t0) * 1e-9, (unsigned long long)(sink & 0xF));
+        }
+        free(keys);
+    }
+}
+
+/* Distribution of each hash function over 65536 power-of-two buckets (chi-square, ideally close to 1),
+   for sequential integer keys and random 16-byte keys, plus the worst single-bit avalanche bias
+   (the probability of an output bit flipping when one input bit flips, ideally 0.5). */
+void bench_hashmap_hash_quality(dast_sz n){
+    const dast_sz nbuckets = 1 << 16;
+    dast_sz* counts = malloc(nbuckets * sizeof(dast_sz));
+    char* keys = malloc(n * KEY_LEN);
+    const dast_sz samples = n < 10000 ? n : 10000;
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+
+    for(dast_sz f = 0; f != HASH_FN_COUNT; ++f){
+        double chi[2];
+        for(int kind = 0; kind != 2; ++kind){
+            for(dast_sz b = 0; b != nbuckets; ++b) counts[b] = 0;
+            for(dast_u64 i = 0; i != n; ++i){
+                dast_u64 h = kind ? hash_fns[f].fn(keys + i * KEY_LEN, KEY_LEN) : hash_fns[f].fn(&i, sizeof(i));
+                counts[h & (nbuckets - 1)]++;
+            }
+            double expected = (double)n / (double)nbuckets, sum = 0;
+            for(dast_sz b = 0; b != nbuckets; ++b){
+                double d = (double)counts[b] - expected;
+                sum += d * d / expected;
+            }
+            chi[kind] = sum / (double)(nbuckets - 1);
+        }
+
+        /* flips[i][o]: how often output bit o flipped when input bit i was flipped */
+        static dast_sz flips[KEY_LEN * 8][64];
+        for(dast_sz i = 0; i != KEY_LEN * 8; ++i) for(dast_sz o = 0; o != 64; ++o) flips[i][o] = 0;
+        for(dast_sz s = 0; s != samples; ++s){
+            char key[KEY_LEN];
+            dast_memcpy(key, keys + s * KEY_LEN, KEY_LEN);
+            dast_u64 h = hash_fns[f].fn(key, KEY_LEN);
+            for(dast_sz i = 0; i != KEY_LEN * 8; ++i){
+                key[i / 8] ^= (char)(1 << (i % 8));
+                dast_u64 diff = h ^ hash_fns[f].fn(key, KEY_LEN);
+                key[i / 8] ^= (char)(1 << (i % 8));
+                for(dast_sz o = 0; o != 64; ++o) flips[i][o] += (diff >> o) & 1;
+            }
+        }
+        double worst = 0;
+        for(dast_sz i = 0; i != KEY_LEN * 8; ++i){
+            for(dast_sz o = 0; o != 64; ++o){
+                double bias = (double)flips[i][o] / (double)samples - 0.5;
+                if(bias < 0) bias = -bias;
+                if(bias > worst) worst = bias;
+            }
+        }
+
+        printf("  %-8s chi2/df sequential %7.3f  random %7.3f  worst avalanche bias %.3f\n",
+            hash_fns[f].name, chi[0], chi[1], worst);
+    }
+
+    free(counts);
+    free(keys);
+}
+
+/* Full scan of a map, looking up the previous key on each step with `hashmap_iterb`
+   against keeping a position with `hashmap_cursor_next` */
+void bench_hashmap_iteration(dast_sz n){
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    char* keys = malloc(n * KEY_LEN);
+    char label[64];
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+
+    for(dast_sz e = 0; e != sizeof(engines)/sizeof(engines[0]); ++e){
+        hashmap_t map;
+        double t0, t1;
+        dast_sz visited = 0;
+
+        hashmap_init_config(&map, (hashmap_config_t){ .engine = engines[e] });
+        for(dast_sz i = 0; i != n; ++i){
+            hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, dast_null);
+        }
+
+        char* k = dast_null;
+        dast_sz len = 0;
+        t0 = bench_now();
+        while( (k = hashmap_iterb(&map, k, &len)) ) visited++;
+        t1 = bench_now();
+        snprintf(label, sizeof(label), "%s iterb", engine_name(engines[e]));
+        bench_report(label, visited, t1 - t0);
+
+        hashmap_cursor_t cursor = {0};
+        t0 = bench_now();
+        while( hashmap_cursor_next(&map, &cursor) ) visited++;
+        t1 = bench_now();
+        snprintf(label, sizeof(label), "%s cursor", engine_name(engines[e]));
+        bench_report(label, n, t1 - t0);
+
+        if(visited != n * 2) printf("  (!) %zu entries visited, expected %zu\n", (size_t)visited, (size_t)(n * 2));
+        hashmap_uninit(&map);
+    }
+
+    free(keys);
+}
+
+/* Random lookups in batches of 32 keys, one `hashmap_getb` call at a time against `hashmap_getb_many`.
+   The table should be larger than the last-level cache, e.g. 10000000 keys. */
+void bench_hashmap_batch_lookup(dast_sz n){
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    const dast_sz batch = 32;
+    char* keys = malloc(n * KEY_LEN);
+    const void** bkeys = malloc(n * sizeof(*bkeys));
+    dast_sz* lens = malloc(n * sizeof(*lens));
+    void* values[32];
+    char label[64];
+    dast_u64 rng = 3;
+
+    n -= n % batch;
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+    for(dast_sz i = 0; i != n; ++i){
+        bkeys[i] = keys + (bench_rand(&rng) % n) * KEY_LEN;
+        lens[i] = KEY_LEN;
+    }
+
+    for(dast_sz e = 0; e != sizeof(engines)/sizeof(engines[0]); ++e){
+        hashmap_t map;
+        double t0, t1;
+        dast_sz found = 0;
+
+        hashmap_init_config(&map, (hashmap_config_t){ .size_hint = n * 2, .engine = engines[e] });
+        for(dast_sz i = 0; i != n; ++i){
+            hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, keys + i * KEY_LEN);
+        }
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; i += batch){
+            for(dast_sz j = 0; j != batch; ++j){
+                values[j] = hashmap_getb(&map, bkeys[i + j], KEY_LEN);
+                found += values[j] != dast_null;
+            }
+        }
+        t1 = bench_now();
+        snprintf(label, sizeof(label), "%s getb loop", engine_name(engines[e]));
+        bench_report(label, n, t1 - t0);
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; i += batch){
+            found += hashmap_getb_many(&map, batch, bkeys + i, lens + i, values);
+        }
+        t1 = bench_now();
+        snprintf(label, sizeof(label), "%s getb_many", engine_name(engines[e]));
+        bench_report(label, n, t1 - t0);
+
+        if(found != n * 2) printf("  (!) %zu keys found, expected %zu\n", (size_t)found, (size_t)(n * 2));
+        hashmap_uninit(&map);
+    }
+
+    free(keys);
+    free(bkeys);
+    free(lens);
+}
+
+/* Counting occurrences of `n` keys drawn from n/8 distinct ones,
+   with `hashmap_getb` followed by `hashmap_setb` against a single `hashmap_upsertb` */
+void bench_hashmap_upsert(dast_sz n){
+    const dast_sz distinct = n / 8 ? n / 8 : 1;
+    char* keys = malloc(distinct * KEY_LEN);
+    dast_sz* order = malloc(n * sizeof(dast_sz));
+    dast_u64 rng = 5;
+
+    bench_fill_keys(keys, distinct, KEY_LEN, 1);
+    for(dast_sz i = 0; i != n; ++i) order[i] = bench_rand(&rng) % distinct;
+
+    hashmap_t map;
+    double t0, t1;
+
+    hashmap_init(&map, 0);
+    t0 = bench_now();
+    for(dast_sz i = 0; i != n; ++i){
+        const char* key = keys + order[i] * KEY_LEN;
+        dast_sz count = (dast_sz)hashmap_getb(&map, key, KEY_LEN);
+        hashmap_setb(&map, key, KEY_LEN, (void*)(count + 1));
+    }
+    t1 = bench_now();
+    bench_report("getb + setb", n, t1 - t0);
+    hashmap_uninit(&map);
+
+    hashmap_init(&map, 0);
+    t0 = bench_now();
+    for(dast_sz i = 0; i != n; ++i){
+        void** value = hashmap_upsertb(&map, keys + order[i] * KEY_LEN, KEY_LEN, dast_null);
+        *value = (void*)((dast_sz)*value + 1);
+    }
+    t1 = bench_now();
+    bench_report("upsertb", n, t1 - t0);
+    hashmap_uninit(&map);
+
+    free(keys);
+    free(order);
+}
+
+/* Insert throughput, resident memory and teardown time of a chained map
+   allocating each entry on its own against carving them from an entry pool.
+   Memory freed by the first run may be reused by the second, so pooled maps run first. */
+void bench_hashmap_pool(dast_sz n){
+    const dast_sz slabs[] = { 4096, 0 };
+    char* keys = malloc(n * KEY_LEN);
+    char label[64];
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+
+    for(dast_sz p = 0; p != sizeof(slabs)/sizeof(slabs[0]); ++p){
+        hashmap_t map;
+        double t0, t1;
+        dast_sz rss0 = bench_rss();
+
+        hashmap_init_config(&map, (hashmap_config_t){ .size_hint = n * 2, .pool_slab_entries = slabs[p] });
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i){
+            hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, dast_null);
+        }
+        t1 = bench_now();
+        if(slabs[p]) snprintf(label, sizeof(label), "pool of %zu, insert", (size_t)slabs[p]);
+        else         snprintf(label, sizeof(label), "malloc, insert");
+        bench_report(label, n, t1 - t0);
+        printf("  %-36s %10.1f MiB\n", "rss growth", ((double)bench_rss() - (double)rss0) / (1024.0 * 1024.0));
+
+        t0 = bench_now();
+        hashmap_uninit(&map);
+        t1 = bench_now();
+        printf("  %-36s %10.3f ms\n", "uninit", (t1 - t0) * 1e3);
+    }
+
+    free(keys);
+}
+
+/* Loading `n` keys into an empty map with `hashmap_setb` calls, after `hashmap_reserve`,
+   and with `hashmap_setb_many` on a map with an entry pool and key arena */
+void bench_hashmap_bulk_load(dast_sz n){
+    char* keys = malloc(n * KEY_LEN);
+    const void** bkeys = malloc(n * sizeof(*bkeys));
+    dast_sz* lens = malloc(n * sizeof(*lens));
+    void** values = malloc(n * sizeof(*values));
+    hashmap_t map;
+    double t0, t1;
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+    for(dast_sz i = 0; i != n; ++i){
+        bkeys[i] = keys + i * KEY_LEN;
+        lens[i] = KEY_LEN;
+        values[i] = keys + i * KEY_LEN;
+    }
+
+    t0 = bench_now();
+    hashmap_init(&map, 0);
+    for(dast_sz i = 0; i != n; ++i) hashmap_setb(&map, bkeys[i], KEY_LEN, values[i]);
+    t1 = bench_now();
+    bench_report("setb, growing", n, t1 - t0);
+    hashmap_uninit(&map);
+
+    t0 = bench_now();
+    hashmap_init(&map, 0);
+    hashmap_reserve(&map, n);
+    for(dast_sz i = 0; i != n; ++i) hashmap_setb(&map, bkeys[i], KEY_LEN, values[i]);
+    t1 = bench_now();
+    bench_report("reserve + setb", n, t1 - t0);
+    hashmap_uninit(&map);
+
+    t0 = bench_now();
+    hashmap_init_config(&map, (hashmap_config_t){ .pool_slab_entries = 4096, .key_arena_chunk = 1 << 16 });
+    hashmap_setb_many(&map, n, bkeys, lens, values);
+    t1 = bench_now();
+    bench_report("setb_many, pool + arena", n, t1 - t0);
+    hashmap_uninit(&map);
+
+    free(keys);
+    free(bkeys);
+    free(lens);
+    free(values);
+}
+
+/* Time and peak memory of a full resize of a chained map holding `n` keys, e.g. 10000000 */
+void bench_hashmap_resize(dast_sz n){
+    char* keys = malloc(n * KEY_LEN);
+    hashmap_t map;
+    double t0, t1;
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+    hashmap_init(&map, n * HASHMAP_LOADING_FACTOR * 2);
+    for(dast_sz i = 0; i != n; ++i){
+        hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, dast_null);
+    }
+
+    dast_sz rss = bench_rss();
+    bench_reset_peak_rss();
+    t0 = bench_now();
+    hashmap_resize(&map);
+    t1 = bench_now();
+    dast_sz peak = bench_peak_rss();
+
+    printf("  %-36s %10.3f ms to %zu buckets\n", "resize", (t1 - t0) * 1e3, (size_t)map.size);
+    printf("  %-36s %10.1f MiB before, %.1f MiB peak\n", "rss", (double)rss / (1024.0 * 1024.0), (double)peak / (1024.0 * 1024.0));
+
+    hashmap_uninit(&map);
+    free(keys);
+}
+
+/* Time of a bulk load and of a full resize of a chained map against the number of threads */
+void bench_hashmap_parallel(dast_sz n){
+    const dast_sz thread_counts[] = { 1, 2, 4, 8 };
+    char* keys = malloc(n * KEY_LEN);
+    const void** bkeys = malloc(n * sizeof(void*));
+    dast_sz* lens = malloc(n * sizeof(dast_sz));
+    void** values = malloc(n * sizeof(void*));
+    char label[64];
+    double t0, t1;
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+    for(dast_sz i = 0; i != n; ++i){
+        bkeys[i] = keys + i * KEY_LEN;
+        lens[i] = KEY_LEN;
+        values[i] = (void*)bkeys[i];
+    }
+
+    for(dast_sz t = 0; t != sizeof(thread_counts)/sizeof(thread_counts[0]); ++t){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){ .pool_slab_entries = 4096, .threads = thread_counts[t] });
+
+        t0 = bench_now();
+        hashmap_setb_many(&map, n, bkeys, lens, values);
+        t1 = bench_now();
+        snprintf(label, sizeof(label), "setb_many, %zu threads", (size_t)thread_counts[t]);
+        bench_report(label, n, t1 - t0);
+
+        t0 = bench_now();
+        hashmap_resize(&map);
+        t1 = bench_now();
+        snprintf(label, sizeof(label), "resize, %zu threads", (size_t)thread_counts[t]);
+        bench_report(label, n, t1 - t0);
+
+        hashmap_uninit(&map);
+    }
+
+    free(keys);
+    free(bkeys);
+    free(lens);
+    free(values);
+}
+
+/* Time to load, look up and free 16-byte values, each allocated on its own or stored inside its entry */
+void bench_hashmap_value_size(dast_sz n){
+    typedef struct { dast_u64 count, sum; } record_t;
+    char* keys = malloc(n * KEY_LEN);
+    dast_sz* order = malloc(n * sizeof(dast_sz));
+    dast_u64 state = 2;
+    char label[64];
+    double t0, t1;
+
+    bench_fill_keys(keys, n, KEY_LEN, 1);
+
+    /* Lookups in random order, so that values allocated one after another are not read one after another */
+    for(dast_sz i = 0; i != n; ++i) order[i] = i;
+    for(dast_sz i = n; i > 1; --i){
+        dast_sz j = (dast_sz)(bench_rand(&state) % i);
+        dast_sz tmp = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = tmp;
+    }
+
+    for(int inline_values = 0; inline_values != 2; ++inline_values){
+        const char* mode = inline_values ? "inline" : "allocated";
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .size_hint = n, .pool_slab_entries = 4096, .value_size = inline_values ? sizeof(record_t) : 0
+        });
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i){
+            record_t record = { 1, i };
+            if(inline_values){
+                hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, &record);
+            } else {
+                record_t* value = malloc(sizeof(record_t));
+                *value = record;
+                hashmap_setb(&map, keys + i * KEY_LEN, KEY_LEN, value);
+            }
+        }
+        t1 = bench_now();
+        snprintf(label, sizeof(label), "load, %s", mode);
+        bench_report(label, n, t1 - t0);
+
+        dast_u64 sum = 0;
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i){
+            record_t* value = hashmap_getb(&map, keys + order[i] * KEY_LEN, KEY_LEN);
+            sum += value->count + value->sum;
+        }
+        t1 = bench_now();
+        snprintf(label, sizeof(label), "getb, %s", mode);
+        bench_report(label, n, t1 - t0);
+        if(sum != (dast_u64)n + (dast_u64)n * (n - 1) / 2) printf("  wrong values\n");
+
+        t0 = bench_now();
+        if(!inline_values){
+            hashmap_cursor_t cursor = {0};
+            while(hashmap_cursor_next(&map, &cursor)) free(cursor.value);
+        }
+        hashmap_uninit(&map);
+        t1 = bench_now();
+        printf("  %-36s %10.3f ms\n", inline_values ? "free, inline" : "free, allocated", (t1 - t0) * 1e3);
+    }
+
+    free(order);
+    free(keys);
+}
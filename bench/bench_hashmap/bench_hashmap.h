@@ -0,0 +1,39 @@
+#ifndef BENCH_HASHMAP_H
+#define BENCH_HASHMAP_H
+
+#include "bench.h"
+#include "hashmap.h"
+
+
+#define BENCH_GROUP_HASHMAP \
+    BENCH(bench_hashmap_engines), \
+    BENCH(bench_hashmap_insert_latency), \
+    BENCH(bench_hashmap_sizing), \
+    BENCH(bench_hashmap_hash_throughput), \
+    BENCH(bench_hashmap_hash_quality), \
+    BENCH(bench_hashmap_iteration), \
+    BENCH(bench_hashmap_batch_lookup), \
+    BENCH(bench_hashmap_upsert), \
+    BENCH(bench_hashmap_pool), \
+    BENCH(bench_hashmap_bulk_load), \
+    BENCH(bench_hashmap_resize), \
+    BENCH(bench_hashmap_parallel), \
+    BENCH(bench_hashmap_value_size)
+
+
+void bench_hashmap_engines(dast_sz n);
+void bench_hashmap_insert_latency(dast_sz n);
+void bench_hashmap_sizing(dast_sz n);
+void bench_hashmap_hash_throughput(dast_sz n);
+void bench_hashmap_hash_quality(dast_sz n);
+void bench_hashmap_iteration(dast_sz n);
+void bench_hashmap_batch_lookup(dast_sz n);
+void bench_hashmap_upsert(dast_sz n);
+void bench_hashmap_pool(dast_sz n);
+void bench_hashmap_bulk_load(dast_sz n);
+void bench_hashmap_resize(dast_sz n);
+void bench_hashmap_parallel(dast_sz n);
+void bench_hashmap_value_size(dast_sz n);
+
+
+#endif /* BENCH_HASHMAP_H */
@@ -0,0 +1,130 @@
+#include <stdlib.h>
+
+#include "bench_hashset.h"
+
+
+#define BENCH_HASHSET_KEY_SIZE 16
+
+
+/* PUBLIC FUNCTIONS */
+
+/* Set against an open-addressing `hashmap_t` holding NULL values, with half of the lookups missing */
+void bench_hashset_membership(dast_sz n){
+    char* keys = malloc(n * BENCH_HASHSET_KEY_SIZE);
+    char* lookups = malloc(n * BENCH_HASHSET_KEY_SIZE);
+    dast_u64 state = 5;
+    dast_sz found;
+    double t0, t1;
+
+    bench_fill_keys(keys, n, BENCH_HASHSET_KEY_SIZE, 1);
+    bench_fill_keys(lookups, n, BENCH_HASHSET_KEY_SIZE, 2);
+    for(dast_sz i = 0; i < n; i += 2){
+        dast_memcpy(lookups + i * BENCH_HASHSET_KEY_SIZE, keys + (bench_rand(&state) % n) * BENCH_HASHSET_KEY_SIZE, BENCH_HASHSET_KEY_SIZE);
+    }
+
+    {
+        hashset_t set;
+        hashset_init(&set, 0);
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i) hashset_insertb(&set, keys + i * BENCH_HASHSET_KEY_SIZE, BENCH_HASHSET_KEY_SIZE);
+        t1 = bench_now();
+        bench_report("insertb, set", n, t1 - t0);
+
+        found = 0;
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i) found += hashset_containsb(&set, lookups + i * BENCH_HASHSET_KEY_SIZE, BENCH_HASHSET_KEY_SIZE);
+        t1 = bench_now();
+        bench_report("containsb, set", n, t1 - t0);
+        printf("  %-36s %10zu\n", "found", (size_t)found);
+        printf("  %-36s %10.1f MiB\n", "table", (double)(set.size * (sizeof(hashset_entry_t) + 1)) / (1 << 20));
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i) hashset_removeb(&set, keys + i * BENCH_HASHSET_KEY_SIZE, BENCH_HASHSET_KEY_SIZE);
+        t1 = bench_now();
+        bench_report("removeb, set", n, t1 - t0);
+        hashset_uninit(&set);
+    }
+
+    {
+        hashmap_t map;
+        hashmap_stats_t stats;
+        hashmap_init_config(&map, (hashmap_config_t){.engine = HASHMAP_ENGINE_OPEN});
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i) hashmap_setb(&map, keys + i * BENCH_HASHSET_KEY_SIZE, BENCH_HASHSET_KEY_SIZE, dast_null);
+        t1 = bench_now();
+        bench_report("setb, map of NULL values", n, t1 - t0);
+
+        found = 0;
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i) found += hashmap_has_keyb(&map, lookups + i * BENCH_HASHSET_KEY_SIZE, BENCH_HASHSET_KEY_SIZE);
+        t1 = bench_now();
+        bench_report("has_keyb, map of NULL values", n, t1 - t0);
+        printf("  %-36s %10zu\n", "found", (size_t)found);
+        hashmap_stats(&map, &stats);
+        printf("  %-36s %10.1f MiB\n", "table", (double)stats.total_bytes / (1 << 20));
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i) hashmap_removeb(&map, keys + i * BENCH_HASHSET_KEY_SIZE, BENCH_HASHSET_KEY_SIZE, dast_null);
+        t1 = bench_now();
+        bench_report("removeb, map of NULL values", n, t1 - t0);
+        hashmap_uninit(&map);
+    }
+
+    free(lookups);
+    free(keys);
+}
+
+/* Union, intersection and difference of two sets sharing half of their keys,
+   against looking up and inserting each key of one set into the other */
+void bench_hashset_operations(dast_sz n){
+    char* keys = malloc(n * 3 / 2 * BENCH_HASHSET_KEY_SIZE);
+    hashset_t a, b, c;
+    double t0, t1;
+
+    bench_fill_keys(keys, n * 3 / 2, BENCH_HASHSET_KEY_SIZE, 3);
+    hashset_init(&a, 0);
+    hashset_init(&b, 0);
+    for(dast_sz i = 0; i != n; ++i){
+        hashset_insertb(&a, keys + i * BENCH_HASHSET_KEY_SIZE, BENCH_HASHSET_KEY_SIZE);
+        hashset_insertb(&b, keys + (i + n / 2) * BENCH_HASHSET_KEY_SIZE, BENCH_HASHSET_KEY_SIZE);
+    }
+
+    hashset_copy(&c, &a);
+    t0 = bench_now();
+    hashset_union(&c, &b);
+    t1 = bench_now();
+    bench_report("union", n, t1 - t0);
+    hashset_uninit(&c);
+
+    hashset_copy(&c, &a);
+    t0 = bench_now();
+    {
+        hashset_cursor_t cursor = {0};
+        while(hashset_cursor_next(&b, &cursor)) hashset_insertb(&c, cursor.key, cursor.len);
+    }
+    t1 = bench_now();
+    bench_report("union, key by key", n, t1 - t0);
+    hashset_uninit(&c);
+
+    hashset_copy(&c, &a);
+    t0 = bench_now();
+    hashset_intersect(&c, &b);
+    t1 = bench_now();
+    bench_report("intersect", n, t1 - t0);
+    printf("  %-36s %10zu\n", "keys", (size_t)hashset_count(&c));
+    hashset_uninit(&c);
+
+    hashset_copy(&c, &a);
+    t0 = bench_now();
+    hashset_difference(&c, &b);
+    t1 = bench_now();
+    bench_report("difference", n, t1 - t0);
+    printf("  %-36s %10zu\n", "keys", (size_t)hashset_count(&c));
+    hashset_uninit(&c);
+
+    hashset_uninit(&a);
+    hashset_uninit(&b);
+    free(keys);
+}
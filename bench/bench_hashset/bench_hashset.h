@@ -0,0 +1,17 @@
+#ifndef BENCH_HASHSET_H
+#define BENCH_HASHSET_H
+
+#include "bench.h"
+#include "hashset.h"
+
+
+#define BENCH_GROUP_HASHSET \
+    BENCH(bench_hashset_membership), \
+    BENCH(bench_hashset_operations)
+
+
+void bench_hashset_membership(dast_sz n);
+void bench_hashset_operations(dast_sz n);
+
+
+#endif /* BENCH_HASHSET_H */
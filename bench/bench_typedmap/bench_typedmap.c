@@ -0,0 +1,103 @@
+#include <stdlib.h>
+
+#include "bench_typedmap.h"
+
+
+DAST_HASHMAP_DEFINE(bench_u64map, dast_u64, dast_u64, typedmap_hash_u64, typedmap_eq)
+
+
+/* STATIC FUNCTIONS */
+
+/* Hashes 8-byte keys the same way as the typed map, so that only the calls and comparisons differ */
+static dast_hash_t bench_u64_hash(const void* key, dast_sz len){
+    (void)len;
+    dast_u64 k;
+    dast_memcpy(&k, key, sizeof(k));
+    return k * TYPEDMAP_FIBONACCI_MULTIPLIER;
+}
+
+
+/* PUBLIC FUNCTIONS */
+
+/* Integer keys on a typed map against a `hashmap_t` with inline values, with both hashes and with the default one */
+void bench_typedmap_u64(dast_sz n){
+    dast_u64* keys = malloc(n * sizeof(dast_u64));
+    dast_u64* lookups = malloc(n * sizeof(dast_u64));
+    dast_u64 state = 3;
+    char label[64];
+    double t0, t1;
+
+    for(dast_sz i = 0; i != n; ++i) keys[i] = bench_rand(&state);
+
+    /* Half of the lookups miss */
+    for(dast_sz i = 0; i != n; ++i) lookups[i] = (i & 1) ? bench_rand(&state) : keys[bench_rand(&state) % n];
+
+    {
+        bench_u64map_t map;
+        dast_u64 sum = 0;
+        bench_u64map_init(&map, 0);
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i) bench_u64map_set(&map, keys[i], i);
+        t1 = bench_now();
+        bench_report("set, typed", n, t1 - t0);
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i){
+            dast_u64* value = bench_u64map_get(&map, lookups[i]);
+            if(value) sum += *value;
+        }
+        t1 = bench_now();
+        bench_report("get, typed", n, t1 - t0);
+        printf("  %-36s %10llu\n", "checksum", (unsigned long long)sum);
+
+        t0 = bench_now();
+        for(dast_sz i = 0; i != n; ++i) bench_u64map_remove(&map, keys[i], dast_null);
+        t1 = bench_now();
+        bench_report("remove, typed", n, t1 - t0);
+        bench_u64map_uninit(&map);
+    }
+
+    for(int engine = 0; engine != 2; ++engine){
+        for(int fibonacci = 0; fibonacci != 2; ++fibonacci){
+            const char* mode = engine ? "open" : "chained";
+            const char* hash = fibonacci ? "same hash" : "FNV-1A";
+            hashmap_t map;
+            dast_u64 sum = 0;
+            hashmap_init_config(&map, (hashmap_config_t){
+                .engine = engine ? HASHMAP_ENGINE_OPEN : HASHMAP_ENGINE_CHAINED,
+                .hash_fn = fibonacci ? bench_u64_hash : dast_null,
+                .pool_slab_entries = 4096, .value_size = sizeof(dast_u64)
+            });
+
+            t0 = bench_now();
+            for(dast_sz i = 0; i != n; ++i){
+                dast_u64 value = i;
+                hashmap_setb(&map, &keys[i], sizeof(dast_u64), &value);
+            }
+            t1 = bench_now();
+            snprintf(label, sizeof(label), "setb, %s, %s", mode, hash);
+            bench_report(label, n, t1 - t0);
+
+            t0 = bench_now();
+            for(dast_sz i = 0; i != n; ++i){
+                dast_u64* value = hashmap_getb(&map, &lookups[i], sizeof(dast_u64));
+                if(value) sum += *value;
+            }
+            t1 = bench_now();
+            snprintf(label, sizeof(label), "getb, %s, %s", mode, hash);
+            bench_report(label, n, t1 - t0);
+            printf("  %-36s %10llu\n", "checksum", (unsigned long long)sum);
+
+            t0 = bench_now();
+            for(dast_sz i = 0; i != n; ++i) hashmap_removeb(&map, &keys[i], sizeof(dast_u64), dast_null);
+            t1 = bench_now();
+            snprintf(label, sizeof(label), "removeb, %s, %s", mode, hash);
+            bench_report(label, n, t1 - t0);
+            hashmap_uninit(&map);
+        }
+    }
+
+    free(lookups);
+    free(keys);
+}
@@ -0,0 +1,15 @@
+#ifndef BENCH_TYPEDMAP_H
+#define BENCH_TYPEDMAP_H
+
+#include "bench.h"
+#include "typedmap.h"
+
+
+#define BENCH_GROUP_TYPEDMAP \
+    BENCH(bench_typedmap_u64)
+
+
+void bench_typedmap_u64(dast_sz n);
+
+
+#endif /* BENCH_TYPEDMAP_H */
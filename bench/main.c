@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "bench_hashmap/bench_hashmap.h"
+#include "bench_chashmap/bench_chashmap.h"
+#include "bench_hashimage/bench_hashimage.h"
+#include "bench_typedmap/bench_typedmap.h"
+#include "bench_hashset/bench_hashset.h"
+#include "bench_frozenmap/bench_frozenmap.h"
+
+#define BENCH_DEFAULT_KEYS 1000000
+
+
+/* Usage: bench [filter] [number of keys]
+   Runs every benchmark whose name contains `filter` */
+int main(int argc, const char* argv[]){
+    const char* filter = argc > 1 ? argv[1] : "";
+    dast_sz n = argc > 2 ? (dast_sz)strtoull(argv[2], NULL, 10) : BENCH_DEFAULT_KEYS;
+
+    static const bench_t benches[] = {
+        BENCH_GROUP_HASHMAP,
+        BENCH_GROUP_CHASHMAP,
+        BENCH_GROUP_HASHIMAGE,
+        BENCH_GROUP_TYPEDMAP,
+        BENCH_GROUP_HASHSET,
+        BENCH_GROUP_FROZENMAP
+    };
+
+    for(dast_sz i = 0; i != sizeof(benches)/sizeof(benches[0]); ++i){
+        if(!strstr(benches[i].name, filter)) continue;
+        printf("%s (%zu keys)\n", benches[i].name, (size_t)n);
+        benches[i].fn(n);
+    }
+    return 0;
+}
@@ -5,12 +5,36 @@
 #include "dast.h"
 #include "hashmap.h"
 
-#include <windows.h>
-
 
 #define NKEYS 100000
 #define KEYLEN 30
 
+/* Prints the layout of a map, and the lookup counters when compiled with DAST_STATS */
+static void print_stats(const char* label, hashmap_t* map){
+    hashmap_stats_t stats;
+    hashmap_stats(map, &stats);
+
+    printf("%s\n", label);
+    printf("  Keys %zu in %zu buckets (load factor %.2f), %zu resizes\n",
+        (size_t)stats.entries, (size_t)stats.buckets, stats.load_factor, (size_t)stats.resizes);
+    printf("  Longest chain %zu, average chain %.3f\n", (size_t)stats.max_chain, stats.avg_chain);
+    printf("  Chain lengths:");
+    for(dast_sz i = 0; i != HASHMAP_STATS_BINS; ++i){
+        if(stats.histogram[i]) printf(" %zu%s:%zu", (size_t)i, i == HASHMAP_STATS_BINS - 1 ? "+" : "", (size_t)stats.histogram[i]);
+    }
+    printf("\n");
+    printf("  Bytes: table %zu, entries %zu, keys %zu, total %zu\n",
+        (size_t)stats.table_bytes, (size_t)stats.entry_bytes, (size_t)stats.key_bytes, (size_t)stats.total_bytes);
+#ifdef DAST_STATS
+    if(stats.counters.lookups){
+        printf("  Lookups %zu, probes per lookup %.3f, key comparisons per lookup %.3f\n",
+            (size_t)stats.counters.lookups,
+            (double)stats.counters.probes / (double)stats.counters.lookups,
+            (double)stats.counters.eq_calls / (double)stats.counters.lookups);
+    }
+#endif
+}
+
 void test_hashmap_collisions(void){
 
     // Generate keys
@@ -25,7 +49,7 @@ void test_hashmap_collisions(void){
     printf("Keys generated\n");
 
     hashmap_t map;
-    void* p = hashmap_init(&map, NKEYS*10);
+    hashmap_init(&map, NKEYS*10);
     printf("Map initialised\n");
 
     // Insert keys
@@ -34,49 +58,27 @@ void test_hashmap_collisions(void){
     }
     printf("Keys inserted\n");
 
-    // Scan for collisions
-    hashmap_entry_t* entry;
-    uint32_t collisions = 0;
-    for(uint64_t i = 0; i != map.size; ++i){
-        entry = map.table[i];
-        if(entry && entry->next){
-            printf("Collision of %s with ", entry->key);
-            entry = entry->next;
-            while (entry) {
-                printf(" %s, ", entry->key);
-                entry = entry->next;
-            }
-            printf("\n");
-            collisions++;
-        }
+    // Look every key up once, for the lookup counters
+    hashmap_reset_counters(&map);
+    for(uint32_t i = 0; i != NKEYS; ++i){
+        hashmap_getb(&map, keys[i], KEYLEN+1);
     }
 
-    // Stats
-    dast_sz mapsz = map.size;
-    double loadf = (double)NKEYS / (double)mapsz;
-    printf("Keys %u and map size %u (loading factor %.2g)\n", NKEYS, (unsigned int)map.size, loadf);
-    printf("Collisions: %u\n", collisions);
-
+    print_stats("FNV-1A, size hint 10x keys", &map);
     hashmap_uninit(&map);
-
-    // Hashing test
-    dast_u64 h1 = hashmap_FNV1a64_hash("danhuugadk", KEYLEN+1) % mapsz;
-    dast_u64 h2 = hashmap_FNV1a64_hash("ympzximqqj", KEYLEN+1) % mapsz;
-    printf("%llu = %llu (%d)\n", h1, h2, h1==h2);
 }
 
 dast_bool _key_u64_cmp(const void*a, const void* b, dast_sz len){
+    (void)len;
     return *(dast_u64*)a == *(dast_u64*)b;
 }
 
 void test_string_vs_int_keys(){
 
-    LARGE_INTEGER frequency;
-    LARGE_INTEGER start;
-    LARGE_INTEGER end;
+    clock_t start;
+    clock_t end;
     double interval;
 
-    QueryPerformanceFrequency(&frequency);
     srand((unsigned int)time(NULL));
 
     //// String keys
@@ -101,16 +103,18 @@ void test_string_vs_int_keys(){
     
     // Fetch values
     printf("STR Fetching keys\n");
+    hashmap_reset_counters(&a);
 
-    QueryPerformanceCounter(&start);
+    start = clock();
     for(uint32_t i = 0; i != NKEYS; ++i){
         hashmap_getb(&a, keys[i], KEYLEN+1);
     }
-    QueryPerformanceCounter(&end);
+    end = clock();
 
+    print_stats("STR map", &a);
     hashmap_uninit(&a);
 
-    interval = (double) (end.QuadPart - start.QuadPart) / frequency.QuadPart;
+    interval = (double)(end - start) / CLOCKS_PER_SEC;
     printf("STR Keys: %f s\n", interval);
 
     //// Integer keys
@@ -132,22 +136,24 @@ void test_string_vs_int_keys(){
     
     // Fetch values
     printf("INT Fetching keys\n");
-    
-    QueryPerformanceCounter(&start);
+    hashmap_reset_counters(&b);
+
+    start = clock();
     for(uint32_t i = 0; i != NKEYS; ++i){
         hashmap_getb(&b, &ikeys[i], sizeof(uint64_t));
     }
-    QueryPerformanceCounter(&end);
+    end = clock();
 
+    print_stats("INT map", &b);
     hashmap_uninit(&b);
     
-    interval = (double) (end.QuadPart - start.QuadPart) / frequency.QuadPart;
+    interval = (double)(end - start) / CLOCKS_PER_SEC;
     printf("INT Keys: %f s\n", interval);
 }
 
 
 int main(){
-    //test_hashmap_collisions();
+    test_hashmap_collisions();
     test_string_vs_int_keys();
     return 0;
-}
\ No newline at end of file
+}
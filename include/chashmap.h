@@ -0,0 +1,222 @@
+/** @file chashmap.h
+* `chashmap.h` is a thread-safe variant of `hashmap_t`, with the same get/set/has semantics,
+* that can be used from many threads at once without any external locking.
+*
+* Writers lock one of `CHASHMAP_STRIPES` stripes, chosen from the hash of the key,
+* so writers of different stripes proceed in parallel.
+* Readers take no locks: they follow the chains of the table with atomic loads,
+* and only announce themselves on one of `CHASHMAP_READER_SLOTS` counters while they do.
+* Removed entries and replaced tables are reclaimed once every reader that could still see them is done.
+*
+* The table grows by copying every chain into a larger table, which is then published in one atomic store.
+* Readers keep following whichever table they started on, so they never wait for a resize.
+*
+* Example code:
+* ```c
+*     chashmap_t map;
+*     chashmap_init(&map, 1024); // Starting capacity
+*
+*     // Any thread
+*     chashmap_set(&map, string_scoped_lit("int"), &x);
+*     int* a = chashmap_get(&map, string_scoped_lit("int"));
+*
+*     chashmap_uninit(&map); // Once no other thread uses the map. Does not free stored values
+* ```
+*/
+
+
+#ifndef CHASHMAP_H
+#define CHASHMAP_H
+
+#include "defs.h"
+#include "mem.h"
+#include "str.h"
+#include "hashmap.h"
+
+
+/** Number of locks shared by the buckets of a concurrent map. Must be a power of two */
+#define CHASHMAP_STRIPES 64
+
+/** Number of counters readers are spread over. Must be a power of two */
+#define CHASHMAP_READER_SLOTS 32
+
+/** Size of a cache line, which stripes and reader counters are padded to */
+#define CHASHMAP_CACHE_LINE 64
+
+/** Number of retired entries and tables after which writers try to free them */
+#define CHASHMAP_RECLAIM_THRESHOLD 64
+
+
+/** @struct chashmap_node
+ * @brief Entry of a concurrent map. The key is stored right after the entry.
+ * Only `next` and `value` change once an entry is in the map, and they are accessed atomically.
+ */
+typedef struct chashmap_node {
+	struct chashmap_node* volatile next;  /**< Linked list for hash collisions */
+	void*    volatile value;              /**< Data associated with the key    */
+	dast_hash_t hash;                     /**< Hash of the key                 */
+	dast_sz  len;                         /**< Number of bytes in the key      */
+	char     key[];                       /**< Key (may be string or binary)   */
+} chashmap_node_t;
+
+/** @struct chashmap_table
+ * @brief Bucket array of a concurrent map, replaced as a whole when the map grows.
+ */
+typedef struct chashmap_table {
+	dast_sz          size;      /**< Number of buckets, a power of two */
+	dast_u32         shift;     /**< 64 minus the base-2 logarithm of `size`, for Fibonacci hashing */
+	chashmap_node_t* volatile buckets[]; /**< Head of the chain of each bucket */
+} chashmap_table_t;
+
+/** @struct chashmap_stripe
+ * @brief Lock shared by the buckets of a stripe, padded to its own cache line.
+ */
+typedef struct chashmap_stripe {
+	volatile dast_sz lock;    /**< Non-zero while a writer holds the stripe */
+	volatile dast_sz entries; /**< Number of keys in the buckets of the stripe */
+	char pad[CHASHMAP_CACHE_LINE - 2 * sizeof(dast_sz)];
+} chashmap_stripe_t;
+
+/** @struct chashmap_readers
+ * @brief Number of readers using a slot, for each parity of the epoch they started in.
+ */
+typedef struct chashmap_readers {
+	volatile dast_sz active[2]; /**< Readers that started in an even and an odd epoch */
+	char pad[CHASHMAP_CACHE_LINE - 2 * sizeof(dast_sz)];
+} chashmap_readers_t;
+
+/** @struct chashmap_limbo
+ * @brief Entries and tables removed from a map but possibly still seen by readers.
+ */
+typedef struct chashmap_limbo {
+	void**  items; /**< Retired allocations. Tables have their lowest address bit set */
+	dast_sz len;   /**< Number of retired allocations */
+	dast_sz cap;   /**< Capacity of `items` */
+} chashmap_limbo_t;
+
+/** @struct chashmap_t
+ * @brief Thread-safe hash map. Holds key-value pairs accessed via hashes.
+ */
+typedef struct chashmap {
+	chashmap_table_t* volatile table;      /**< Current bucket array */
+	chashmap_stripe_t  stripes[CHASHMAP_STRIPES];       /**< Writer locks */
+	chashmap_readers_t readers[CHASHMAP_READER_SLOTS];  /**< Reader counters */
+
+	volatile dast_sz  epoch;     /**< Advanced once every reader of the previous epoch is done */
+	volatile dast_sz  limbo_lock;/**< Held while retiring or freeing allocations */
+	chashmap_limbo_t  limbo[2];  /**< Allocations retired in an even and an odd epoch */
+
+	dast_allocator_t  alloc;     /**< Memory allocator       */
+	hashmap_hashfn_t  hash_fn;   /**< Hashing function       */
+	hashmap_eqfn_t    eq_fn;     /**< Key equality function  */
+} chashmap_t;
+
+
+/** @brief Initialise a concurrent hashmap via user-managed object.
+ * Should be deleted using `chashmap_uninit`.
+ * @param map Concurrent hashmap to initialise
+ * @param size_hint starting number of buckets, rounded up to a power of two no smaller than `CHASHMAP_STRIPES`
+ * @returns the input map on success, and NULL otherwise
+ */
+chashmap_t* chashmap_init(chashmap_t* map, dast_sz size_hint);
+
+/** @brief Initialise a concurrent hashmap via user-managed object with custom allocator and/or hash function.
+ * Should be deleted with `chashmap_uninit`.
+ * @param map Concurrent hashmap to initialise
+ * @param size_hint Starting number of buckets
+ * @param alloc Memory allocation functions, which must be thread-safe
+ * @param hash_fn Hash function. If NULL, defaults to `HASHMAP_DEFAULT_HASH`.
+ * @param eq_fn Key equality function. If NULL, defaults to comparing the raw bytes of the two keys.
+ * @returns the input map on success, and NULL otherwise
+ */
+chashmap_t* chashmap_init_custom(
+	chashmap_t*       map,
+	dast_sz           size_hint,
+	dast_allocator_t  alloc,
+	hashmap_hashfn_t  hash_fn,
+	hashmap_eqfn_t    eq_fn
+);
+
+/** @brief Clears a concurrent hashmap and frees all its entries and keys.
+ * Stored values are not freed, as these are managed by the user.
+ * @param map Concurrent hashmap to uninitialise
+ * @warning Not thread-safe: no other thread may be using the map.
+ */
+void chashmap_uninit(chashmap_t* map);
+
+/** @brief Checks if a concurrent map has a given key. Takes no locks.
+ * @param map Concurrent hashmap
+ * @param bkey key to find, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if key exists in the map, and `dast_false` otherwise
+ */
+dast_bool chashmap_has_keyb(chashmap_t* map, const void* bkey, dast_sz key_len);
+
+/** @brief Checks if a concurrent map has a given string key. Takes no locks.
+ * @param map Concurrent hashmap
+ * @param key string key
+ * @returns `dast_true` if key exists in the map, and `dast_false` otherwise
+ */
+dast_bool chashmap_has_key(chashmap_t* map, string_t key);
+
+/** @brief Retrieves the data associated with a key. Takes no locks.
+ * @param map Concurrent hashmap
+ * @param bkey key to search for, which can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns the value of the key, or NULL if the key does not exist
+ * @note A lookup running alongside a write of the same key returns either the old or the new value.
+ */
+void* chashmap_getb(chashmap_t* map, const void* bkey, dast_sz key_len);
+
+/** @brief Retrieves the data associated with a string key. Takes no locks.
+ * @param map Concurrent hashmap
+ * @param key string key
+ * @returns the value of the key, or NULL if the key does not exist
+ */
+void* chashmap_get(chashmap_t* map, string_t key);
+
+/** @brief Adds a new key-value pair to a concurrent map. If the key already exists, the value is replaced.
+ * Locks the stripe of the key, and all stripes if the map has to grow.
+ * @param map Concurrent hashmap
+ * @param bkey key to insert, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @param value pointer to value to insert
+ * @returns pointer to map if insert is successful, or NULL otherwise
+ * @note As with `hashmap_setb`, only a pointer to the value is stored, and a copy of the key is made.
+ */
+chashmap_t* chashmap_setb(chashmap_t* map, const void* bkey, dast_sz key_len, void* value);
+
+/** @brief Adds a new key-value pair with a string key to a concurrent map.
+ * If the key already exists, the value is replaced.
+ * @param map Concurrent hashmap
+ * @param key string key
+ * @param value pointer to value to insert
+ * @returns pointer to map if insert is successful, or NULL otherwise
+ */
+chashmap_t* chashmap_set(chashmap_t* map, string_t key, void* value);
+
+/** @brief Removes a key from a concurrent map. Its entry is freed once no reader can still see it.
+ * @param map Concurrent hashmap
+ * @param bkey key to remove, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @param value if not NULL, set to the value of the removed key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the map
+ */
+dast_bool chashmap_removeb(chashmap_t* map, const void* bkey, dast_sz key_len, void** value);
+
+/** @brief Removes a string key from a concurrent map.
+ * @param map Concurrent hashmap
+ * @param key string key
+ * @param value if not NULL, set to the value of the removed key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the map
+ */
+dast_bool chashmap_remove(chashmap_t* map, string_t key, void** value);
+
+/** @brief Returns the number of keys in a concurrent map.
+ * @param map Concurrent hashmap
+ * @returns the number of keys, which may already be out of date if other threads are writing
+ */
+dast_sz chashmap_count(chashmap_t* map);
+
+
+#endif /* CHASHMAP_H */
@@ -6,5 +6,11 @@
 #include "array.h"
 #include "str.h"
 #include "hashmap.h"
+#include "chashmap.h"
+#include "snapmap.h"
+#include "hashimage.h"
+#include "typedmap.h"
+#include "hashset.h"
+#include "frozenmap.h"
 
 #endif /* DAST_H */
\ No newline at end of file
@@ -10,7 +10,8 @@
  * | DAST_ALLOC      | Custom global memory alloc             |
  * | DAST_REALLOC    | Custom global memory realloc           |
  * | DAST_FREE       | Custom global memory free              |
- * | DAST_HASH_64BIT | Enables 64-bit hashes                  |
+ * | DAST_HASH_64BIT | Enables 64-bit hashes (default)        |
+ * | DAST_HASH_32BIT | Compact 32-bit hashes instead          |
  * | 
  * 
  */
@@ -108,6 +109,44 @@ typedef dast_u32 dast_bool; /**< Boolean type */
 #define dast_true  (dast_bool)1 /**< Boolean true */
 #define dast_false (dast_bool)0 /**< Boolean false */
 
+/* Hints the CPU to start loading the memory at an address into cache */
+#if defined(__GNUC__) || defined(__clang__)
+    #define DAST_PREFETCH(ADDR) __builtin_prefetch((ADDR))
+#else
+    #define DAST_PREFETCH(ADDR) ((void)(ADDR))
+#endif
+
+/* Atomic operations on variables shared between threads, which should be declared volatile.
+ * Loads acquire, stores release, and read-modify-write operations are sequentially consistent.
+ * On MSVC, volatile loads and stores already have acquire and release semantics on x86. */
+#if defined(__GNUC__) || defined(__clang__)
+    #define DAST_ATOMIC_LOAD(P)         __atomic_load_n((P), __ATOMIC_ACQUIRE)
+    #define DAST_ATOMIC_STORE(P, V)     __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+    #define DAST_ATOMIC_FETCH_ADD(P, V) __atomic_fetch_add((P), (V), __ATOMIC_SEQ_CST)
+    #define DAST_ATOMIC_EXCHANGE(P, V)  __atomic_exchange_n((P), (V), __ATOMIC_SEQ_CST)
+    #define DAST_ATOMIC_FENCE()         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+    #if defined(__x86_64__) || defined(__i386__)
+        #define DAST_CPU_PAUSE()        __builtin_ia32_pause()
+    #else
+        #define DAST_CPU_PAUSE()        ((void)0)
+    #endif
+    #define DAST_ATOMICS
+#elif defined(_MSC_VER)
+    #include <intrin.h>
+    #if defined(DAST_64BIT)
+        #define DAST_ATOMIC_FETCH_ADD(P, V) (dast_sz)_InterlockedExchangeAdd64((volatile __int64*)(P), (__int64)(V))
+        #define DAST_ATOMIC_EXCHANGE(P, V)  (dast_sz)_InterlockedExchange64((volatile __int64*)(P), (__int64)(V))
+    #else
+        #define DAST_ATOMIC_FETCH_ADD(P, V) (dast_sz)_InterlockedExchangeAdd((volatile long*)(P), (long)(V))
+        #define DAST_ATOMIC_EXCHANGE(P, V)  (dast_sz)_InterlockedExchange((volatile long*)(P), (long)(V))
+    #endif
+    #define DAST_ATOMIC_LOAD(P)         (*(P))
+    #define DAST_ATOMIC_STORE(P, V)     (*(P) = (V))
+    #define DAST_ATOMIC_FENCE()         _mm_mfence()
+    #define DAST_CPU_PAUSE()            _mm_pause()
+    #define DAST_ATOMICS
+#endif
+
 /* Memory allocation */
 typedef void* (*dast_alloc_t)  (dast_sz size);                 /**< Typedef for memory allocation function */ 
 typedef void* (*dast_realloc_t)(void* block, dast_sz newsize); /**< Typedef for memory reallocation function */
@@ -127,7 +166,11 @@ typedef struct dast_allocator {
     #define DAST_DEFAULT_ALLOCATOR (dast_allocator_t){malloc, realloc, free}
 #endif
 
-/* Hashing */
+/* Hashing. Hashes are 64-bit unless compiled with `DAST_HASH_32BIT` */
+#if !defined(DAST_HASH_32BIT) && !defined(DAST_HASH_64BIT)
+    #define DAST_HASH_64BIT
+#endif
+
 #ifdef DAST_HASH_64BIT
     typedef dast_u64 dast_hash_t; /**< 64-bit hash type */
 #else
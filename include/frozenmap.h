@@ -0,0 +1,142 @@
+/** @file frozenmap.h
+* `frozenmap.h` turns a populated `hashmap_t` into a read-only map (`hashmap_freeze`)
+* for data built once and then only looked up.
+*
+* Keys are placed with a minimal perfect hash: `n` keys fill exactly `n` slots, with no empty ones.
+* Keys are split into buckets of about `FROZENMAP_BUCKET_KEYS` keys each, and every bucket has a pilot,
+* a number chosen while freezing so that the keys of the bucket land on slots no other key takes.
+* A lookup reads the pilot of the bucket of its hash, computes the slot, and compares the key stored there,
+* so it makes at most one key comparison. Each slot also keeps one byte of the hash of its key,
+* which rejects most absent keys before their key is read.
+*
+* Slots hold no full hash and no pointer other than the value: keys are packed back to back,
+* and each slot only stores where its key starts.
+*
+* Example code:
+* ```c
+*     hashmap_set(&map, string_scoped_lit("int"), &x);
+*
+*     frozenmap_t frozen;
+*     hashmap_freeze(&frozen, &map);
+*     hashmap_uninit(&map); // The frozen map has its own copy of the keys
+*
+*     int* a = frozenmap_get(&frozen, string_scoped_lit("int"));
+*     frozenmap_uninit(&frozen);
+* ```
+*/
+
+
+#ifndef FROZENMAP_H
+#define FROZENMAP_H
+
+#include "defs.h"
+#include "mem.h"
+#include "str.h"
+#include "hashmap.h"
+
+
+/** Average number of keys per bucket, and so per pilot.
+ * Larger buckets take less memory, but take longer to place when freezing. */
+#define FROZENMAP_BUCKET_KEYS 4
+
+/** Number of seeds tried before giving up on freezing a map */
+#define FROZENMAP_MAX_SEEDS 8
+
+
+/** @struct frozenmap_t
+ * @brief Read-only map built by `hashmap_freeze`, held in a single allocation.
+ */
+typedef struct frozenmap {
+	dast_sz    entries;     /**< Number of keys, and of slots */
+	dast_sz    buckets;     /**< Number of pilots */
+	dast_u64   seed;        /**< Mixed into every hash, changed when keys cannot be placed */
+	dast_bool  hash_keys;   /**< Keys are placed by a seeded wyhash of their bytes instead of by `hash_fn`,
+	                             as the map had keys with the same hash */
+	dast_u32*  pilots;      /**< Pilot of each bucket */
+	dast_u32*  key_offsets; /**< Offset of the key of each slot in `keys`, plus the end of the last key */
+	dast_u8*   fingerprints;/**< Byte of the hash of the key of each slot, checked before comparing keys */
+	char*      keys;        /**< Keys, back to back, in slot order */
+	void*      values;      /**< Value pointer of each slot, or `value_size` bytes per slot */
+	dast_sz    value_size;  /**< Bytes of each value copied from a map with a `value_size`, or zero if values are pointers */
+	dast_sz    value_stride;/**< Bytes between consecutive values */
+	dast_sz    bytes;       /**< Bytes allocated by the frozen map */
+
+	dast_allocator_t  alloc;    /**< Memory allocator       */
+	hashmap_hashfn_t  hash_fn;  /**< Hashing function       */
+	hashmap_eqfn_t    eq_fn;    /**< Key equality function  */
+} frozenmap_t;
+
+
+/** @brief Builds a read-only copy of a map, with the allocator and functions of the map.
+ * Keys are not hashed again: the hashes stored in the entries of the map are used,
+ * unless two of them are the same, in which case every key is hashed again with a seeded wyhash of its bytes.
+ * Lookups then hash keys with it instead of `hash_fn`, and still compare a single key.
+ * Values are copied as they are: maps with a `value_size` have their values copied,
+ * and other maps have their value pointers copied.
+ * The map is left unchanged, and can be uninitialised once frozen.
+ * Should be deleted with `frozenmap_uninit`.
+ * @param frozen frozen map to initialise
+ * @param map populated hashmap
+ * @returns the input frozen map on success, and NULL otherwise
+ * @note Hashes are often not unique: `hashmap_FNV1a64_hash` gives the same hash to some short binary keys,
+ * and 32-bit hashes repeat past tens of thousands of keys. Such maps freeze with hashes of the key bytes,
+ * which needs keys to be equal only when their bytes are. Maps with another key equality function
+ * and keys with the same hash cannot be frozen.
+ * Maps with 2^32 keys or more, or with keys adding up to 4 GiB or more, cannot be frozen either.
+ */
+frozenmap_t* hashmap_freeze(frozenmap_t* frozen, hashmap_t* map);
+
+/** @brief Frees a frozen map. It does not free the values pointed to.
+ * @param frozen frozen map
+ */
+void frozenmap_uninit(frozenmap_t* frozen);
+
+/** @brief Returns the number of keys of a frozen map.
+ * @param frozen frozen map
+ * @returns the number of keys
+ */
+dast_sz frozenmap_count(frozenmap_t* frozen);
+
+/** @brief Checks if a frozen map has a given key
+ * @param frozen frozen map
+ * @param bkey key to find, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if the key is in the map, and `dast_false` otherwise
+ */
+dast_bool frozenmap_has_keyb(frozenmap_t* frozen, const void* bkey, dast_sz key_len);
+
+/** @brief Checks if a frozen map has a given string key
+ * @param frozen frozen map
+ * @param key string key
+ * @returns `dast_true` if the key is in the map, and `dast_false` otherwise
+ */
+dast_bool frozenmap_has_key(frozenmap_t* frozen, string_t key);
+
+/** @brief Retrieves the data associated with a key.
+ * @param frozen frozen map
+ * @param bkey key to search for, which can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns the value of the key, which points into the frozen map if it was copied from a map with a `value_size`,
+ * or NULL if the key does not exist
+ */
+void* frozenmap_getb(frozenmap_t* frozen, const void* bkey, dast_sz key_len);
+
+/** @brief Retrieves the data associated with a string key.
+ * @param frozen frozen map
+ * @param key string key
+ * @returns the value of the key, or NULL if the key does not exist
+ */
+void* frozenmap_get(frozenmap_t* frozen, string_t key);
+
+/** @brief Returns the key and value of a slot, to iterate over a frozen map
+ * by calling it for every slot below `frozenmap_count`.
+ * @param frozen frozen map
+ * @param slot slot index, below the number of keys
+ * @param key_len if not NULL, set to the number of bytes in the key
+ * @param value if not NULL, set to the value of the key
+ * @returns the key of the slot, or NULL if the slot is out of range
+ */
+const char* frozenmap_slot(frozenmap_t* frozen, dast_sz slot, dast_sz* key_len, void** value);
+
+
+#endif /* FROZENMAP_H */
@@ -0,0 +1,209 @@
+/** @file hashimage.h
+* `hashimage.h` saves a `hashmap_t` as a read-only image, e.g. a file, that can be queried
+* in place, without rebuilding the map or making any allocation per key.
+*
+* An image holds the keys, a copy of the data each value points to, and a table of their positions.
+* Every position in it is an offset from its start, so it can be memory-mapped at any address,
+* and mapped pages are shared between the processes that map the same file.
+* Lookups hash keys with the same hashing function the map was built with.
+*
+* Layout, in native byte order:
+* - Header (`hashimage_header_t`)
+* - Table of records (`hashimage_record_t`), with linear probing. Empty slots are zeroed.
+* - Data: for each record, its key and then its value, each padded to 8 bytes
+*
+* A lookup reads the records from the slot of the hash until it finds the key or an empty slot,
+* and then the key and value, which are next to each other.
+*
+* Example code:
+* ```c
+*     // Every value of the map points to an int
+*     dast_sz int_size(const void* value){ (void)value; return sizeof(int); }
+*
+*     // When the data changes
+*     hashimage_save(&map, int_size, "table.dat");
+*
+*     // On startup, in any number of processes
+*     hashimage_t image;
+*     hashimage_map(&image, "table.dat", dast_null, dast_null);
+*     const int* x = hashimage_get(&image, string_scoped_lit("int"));
+*     hashimage_close(&image);
+* ```
+*/
+
+
+#ifndef HASHIMAGE_H
+#define HASHIMAGE_H
+
+#include "defs.h"
+#include "mem.h"
+#include "str.h"
+#include "hashmap.h"
+
+
+/** Identifies a file as a hashmap image */
+#define HASHIMAGE_MAGIC "DASTHMAP"
+
+/** Version of the image layout */
+#define HASHIMAGE_VERSION 1
+
+/** Written as a 32-bit number, to reject images saved with a different byte order */
+#define HASHIMAGE_BYTE_ORDER 0x01020304u
+
+
+/** @typedef Function returning the number of bytes of the data a value points to,
+ * which is copied into the image. It must return the same size every time for the same value. */
+typedef dast_sz (*hashimage_sizefn_t)(const void* value);
+
+/** @struct hashimage_header
+ * @brief First bytes of an image.
+ */
+typedef struct hashimage_header {
+	char     magic[8];       /**< `HASHIMAGE_MAGIC`, not null-terminated */
+	dast_u32 version;        /**< `HASHIMAGE_VERSION` */
+	dast_u32 byte_order;     /**< `HASHIMAGE_BYTE_ORDER` */
+	dast_u64 hash_check;     /**< Hash of `HASHIMAGE_MAGIC`, to reject a different hashing function */
+	dast_u64 entries;        /**< Number of keys */
+	dast_u64 slots;          /**< Number of records in the table, a power of two, at least a third more than `entries` */
+	dast_u64 records_offset; /**< Offset of the table of records */
+	dast_u64 size;           /**< Total number of bytes in the image */
+} hashimage_header_t;
+
+/** @struct hashimage_record
+ * @brief Key-value pair of an image.
+ */
+typedef struct hashimage_record {
+	dast_u64 hash;      /**< Hash of the key */
+	dast_u64 offset;    /**< Offset of the key, or zero for empty slots. The value follows it, at the next multiple of 8 bytes */
+	dast_u32 key_len;   /**< Number of bytes in the key */
+	dast_u32 value_len; /**< Number of bytes in the value. Zero for NULL values */
+} hashimage_record_t;
+
+/** @struct hashimage_t
+ * @brief Read-only view of an image.
+ */
+typedef struct hashimage {
+	const dast_u8*            data;    /**< Start of the image */
+	dast_sz                   size;    /**< Number of bytes in the image */
+	const hashimage_record_t* records; /**< Table of records */
+	dast_sz                   entries; /**< Number of keys */
+	dast_sz                   slots;   /**< Number of records in the table, a power of two */
+	dast_u32                  shift;   /**< 64 minus the base-2 logarithm of `slots`, for Fibonacci hashing */
+
+	hashmap_hashfn_t  hash_fn;  /**< Hashing function       */
+	hashmap_eqfn_t    eq_fn;    /**< Key equality function  */
+	dast_bool         mapped;   /**< Whether the image was mapped or read from a file by `hashimage_map` */
+	void*             handle;   /**< File mapping handle, on Windows */
+} hashimage_t;
+
+
+/** @brief Computes the number of bytes of the image of a map.
+ * @param map hashmap
+ * @param size_fn Number of bytes each value points to. If NULL, maps with a `value_size` save that many bytes,
+ * and other maps do not save their values, which are looked up as NULL.
+ * @returns the size of the image, or zero on failure
+ */
+dast_sz hashimage_size(hashmap_t* map, hashimage_sizefn_t size_fn);
+
+/** @brief Writes the image of a map into a buffer.
+ * @param map hashmap
+ * @param size_fn Number of bytes each value points to. If NULL, maps with a `value_size` save that many bytes,
+ * and other maps do not save their values, which are looked up as NULL.
+ * @param buf buffer, which should be aligned to 8 bytes to be opened with `hashimage_open`
+ * @param cap number of bytes in the buffer, at least `hashimage_size`
+ * @returns the number of bytes written, or zero on failure
+ * @note Keys and values longer than 4 GiB cannot be saved.
+ */
+dast_sz hashimage_write(hashmap_t* map, hashimage_sizefn_t size_fn, void* buf, dast_sz cap);
+
+/** @brief Opens an image held in memory. The image is not copied, and must outlive the view.
+ * Only the header is read, so opening takes the same time for any number of keys.
+ * @param image view to initialise
+ * @param data image, aligned to 8 bytes
+ * @param size number of bytes of the image
+ * @param hash_fn Hash function the map was built with. If NULL, defaults to `HASHMAP_DEFAULT_HASH`.
+ * @param eq_fn Key equality function. If NULL, defaults to comparing the raw bytes of the two keys.
+ * @returns the input view on success, and NULL if the image is not valid or was built with another hashing function
+ */
+hashimage_t* hashimage_open(hashimage_t* image, const void* data, dast_sz size, hashmap_hashfn_t hash_fn, hashmap_eqfn_t eq_fn);
+
+#ifndef DAST_NO_STDLIB
+
+/** @brief Saves the image of a map to a file, writing it as it goes
+ * instead of building the whole image in memory first.
+ * @param map hashmap
+ * @param size_fn Number of bytes each value points to. If NULL, maps with a `value_size` save that many bytes,
+ * and other maps do not save their values, which are looked up as NULL.
+ * @param path path of the file, which is overwritten
+ * @returns `dast_true` on success, and `dast_false` otherwise
+ */
+dast_bool hashimage_save(hashmap_t* map, hashimage_sizefn_t size_fn, const char* path);
+
+/** @brief Opens an image file by mapping it read-only into memory. Pages are read as lookups touch them.
+ * Should be closed with `hashimage_close`.
+ * @param image view to initialise
+ * @param path path of the file
+ * @param hash_fn Hash function the map was built with. If NULL, defaults to `HASHMAP_DEFAULT_HASH`.
+ * @param eq_fn Key equality function. If NULL, defaults to comparing the raw bytes of the two keys.
+ * @returns the input view on success, and NULL otherwise
+ * @note On systems without `mmap` or `MapViewOfFile`, the file is read into memory instead.
+ */
+hashimage_t* hashimage_map(hashimage_t* image, const char* path, hashmap_hashfn_t hash_fn, hashmap_eqfn_t eq_fn);
+
+#endif /* DAST_NO_STDLIB */
+
+/** @brief Closes a view, unmapping the file if it was opened with `hashimage_map`.
+ * Images opened with `hashimage_open` are left to the user.
+ * @param image view
+ */
+void hashimage_close(hashimage_t* image);
+
+/** @brief Returns the number of keys of an image.
+ * @param image view
+ * @returns the number of keys
+ */
+dast_sz hashimage_count(hashimage_t* image);
+
+/** @brief Checks if an image has a given key
+ * @param image view
+ * @param bkey key to find, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if key exists in the image, and `dast_false` otherwise
+ */
+dast_bool hashimage_has_keyb(hashimage_t* image, const void* bkey, dast_sz key_len);
+
+/** @brief Checks if an image has a given string key
+ * @param image view
+ * @param key string key
+ * @returns `dast_true` if key exists in the image, and `dast_false` otherwise
+ */
+dast_bool hashimage_has_key(hashimage_t* image, string_t key);
+
+/** @brief Retrieves the data associated with a key, and its size.
+ * @param image view
+ * @param bkey key to search for, which can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @param value_len if not NULL, set to the number of bytes of the value
+ * @returns the value of the key within the image, aligned to 8 bytes, or NULL if the key does not exist
+ * @note The function also returns NULL if the key was saved with a NULL or empty value.
+ */
+const void* hashimage_getb_sized(hashimage_t* image, const void* bkey, dast_sz key_len, dast_sz* value_len);
+
+/** @brief Retrieves the data associated with a key.
+ * @param image view
+ * @param bkey key to search for, which can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns the value of the key within the image, or NULL if the key does not exist
+ * @note See `hashimage_getb_sized`.
+ */
+const void* hashimage_getb(hashimage_t* image, const void* bkey, dast_sz key_len);
+
+/** @brief Retrieves the data associated with a string key.
+ * @param image view
+ * @param key string key
+ * @returns the value of the key within the image, or NULL if the key does not exist
+ */
+const void* hashimage_get(hashimage_t* image, string_t key);
+
+
+#endif /* HASHIMAGE_H */
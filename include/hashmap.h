@@ -2,6 +2,9 @@
 * `hashmap.h` is an implementation of a dictionary, which is data structure that holds
 * key-value pairs, using a hashmap.
 * Hash collisions are handled using linked lists on each bucket.
+* Alternatively, maps can be initialised with an open-addressing engine
+* (see `hashmap_init_config`), which stores entries in a flat array of slots
+* and probes groups of one-byte control tags before touching any entry.
 * 
 * Example code:
 * ```c
@@ -35,30 +38,211 @@
 
 #define HASHMAP_LOADING_FACTOR 2
 
+/** Keys of up to this many bytes are stored inside their entry, saving an allocation */
+#define HASHMAP_SMALL_KEY_SIZE 32
 
-/** @typedef Type for hashing function */
-typedef dast_u64 (*hashmap_hashfn_t)(const void* data, dast_sz len);
+/** Smallest number of buckets moved per insert during an incremental resize.
+ * Tables double in size, so two buckets per insert always finish moving
+ * the old table before the new one needs to grow. */
+#define HASHMAP_MIN_REHASH_BUDGET 2
+
+/** Number of control bytes inspected at once by the open-addressing engine */
+#define HASHMAP_GROUP_WIDTH 8
+
+/** Open-addressing tables grow once `used * DEN >= size * NUM` */
+#define HASHMAP_OPEN_MAX_LOAD_NUM 7
+#define HASHMAP_OPEN_MAX_LOAD_DEN 8
+
+/** Tables shrink once their load drops below `1 / HASHMAP_SHRINK_RATIO` of the maximum */
+#define HASHMAP_SHRINK_RATIO 8
+
+/** Number of keys hashed and prefetched together by `hashmap_getb_many` */
+#define HASHMAP_BATCH_SIZE 16
+
+/** Entries each thread of a parallel resize or bulk load must get, below which fewer threads are used */
+#define HASHMAP_PARALLEL_MIN_ENTRIES 65536
+
+/** Largest number of threads used by a parallel resize or bulk load */
+#define HASHMAP_MAX_THREADS 64
+
+/** Number of bins of the histogram of `hashmap_stats_t`. The last bin also counts every larger value */
+#define HASHMAP_STATS_BINS 16
+
+
+/** @typedef Type for hashing function. Returns 64-bit hashes, or 32-bit ones with `DAST_HASH_32BIT` */
+typedef dast_hash_t (*hashmap_hashfn_t)(const void* data, dast_sz len);
+
+/** @typedef Number of bytes of a key stored in its entry.
+ * With `DAST_HASH_32BIT`, it is 32-bit, so that it packs with the hash and entries take 64 bytes instead of 72,
+ * and keys of 4 GiB or more cannot be added. */
+#ifdef DAST_HASH_64BIT
+	typedef dast_sz hashmap_len_t;
+#else
+	typedef dast_u32 hashmap_len_t;
+#endif
+
+/** Hashing function of maps initialised without one */
+#ifdef DAST_HASH_64BIT
+	#define HASHMAP_DEFAULT_HASH hashmap_FNV1a64_hash
+#else
+	#define HASHMAP_DEFAULT_HASH hashmap_FNV1a32_hash
+#endif
 
 /** @typedef Type for key equality function */
 typedef dast_bool (*hashmap_eqfn_t)(const void* a, const void* b, dast_sz len);
 
 /** @struct hashmap_entry
  * @brief Hashmap entry. Holds a key-value pair.
+ * Keys no longer than `HASHMAP_SMALL_KEY_SIZE` are copied into `small_key`,
+ * in which case `key` points to it. Longer keys are allocated separately.
+ * In maps with a `value_size`, values are copied right after the entry, and `value` points to them.
  */
 typedef struct hashmap_entry {
-	char*    key;               /**< Key (may be string or binary)   */
-	dast_sz  len;				/**< Number of bytes in the key	     */
-	void*    value;             /**< Data associated with the key    */
+	char*         key;          /**< Key (may be string or binary)   */
+	void*         value;        /**< Data associated with the key    */
 	struct hashmap_entry* next; /**< Linked list for hash collisions */
+	hashmap_len_t len;          /**< Number of bytes in the key      */
+	dast_hash_t   hash;         /**< Hash of the key, kept to skip key comparisons and rehashing */
+	char          small_key[HASHMAP_SMALL_KEY_SIZE]; /**< Storage for short keys */
 } hashmap_entry_t;
 
+/** @enum hashmap_engine
+ * @brief Storage strategy used by a hashmap.
+ */
+typedef enum hashmap_engine {
+	HASHMAP_ENGINE_CHAINED = 0, /**< Array of buckets, each a linked list of entries (default) */
+	HASHMAP_ENGINE_OPEN         /**< Open addressing: flat array of entries indexed by control bytes */
+} hashmap_engine_t;
+
+/** @enum hashmap_sizing
+ * @brief Policy for the number of buckets of a chained map, and how hashes are mapped to them.
+ */
+typedef enum hashmap_sizing {
+	HASHMAP_SIZING_PRIME = 0, /**< Prime number of buckets, indexed by the hash modulo the size (default) */
+	HASHMAP_SIZING_POW2       /**< Power-of-two number of buckets, indexed by Fibonacci hashing.
+	                               Avoids a division per lookup and the search for a prime when resizing. */
+} hashmap_sizing_t;
+
+/** @struct hashmap_config
+ * @brief Initialisation options for `hashmap_init_config`.
+ * Zero-initialised fields select the defaults.
+ */
+typedef struct hashmap_config {
+	dast_sz           size_hint; /**< Starting number of buckets                          */
+	dast_allocator_t  alloc;     /**< Memory allocator. Defaults to the standard library  */
+	hashmap_hashfn_t  hash_fn;   /**< Hashing function. Defaults to `HASHMAP_DEFAULT_HASH` */
+	hashmap_eqfn_t    eq_fn;     /**< Key equality function. Defaults to `dast_memeq`     */
+	hashmap_engine_t  engine;    /**< Storage engine. Defaults to `HASHMAP_ENGINE_CHAINED` */
+	dast_sz           rehash_budget; /**< Buckets moved per insert while growing incrementally.
+	                                      Zero rehashes the whole table at once. Chained engine only.
+	                                      Raised to at least `HASHMAP_MIN_REHASH_BUDGET`. */
+	hashmap_sizing_t  sizing;        /**< Bucket count policy. Defaults to `HASHMAP_SIZING_PRIME`.
+	                                      Open-addressing maps always use a power of two. */
+	dast_sz           pool_slab_entries; /**< Entries carved from each slab of the entry pool.
+	                                      Zero allocates each entry on its own. Chained engine only. */
+	dast_sz           key_arena_chunk;   /**< Bytes per chunk of the key arena, where keys too long to be stored
+	                                      inside their entry are appended. Zero allocates each key on its own. */
+	dast_sz           threads;           /**< Threads that rebuild the table of a large chained map when it is resized,
+	                                      and that add keys in `hashmap_setb_many`. Zero or one uses the calling thread only.
+	                                      The allocator, hashing and equality functions must then be thread-safe. */
+	dast_sz           value_size;        /**< Bytes of each value, which are then copied into the entry of its key
+	                                      and freed with it. Zero stores the value pointers given instead. */
+} hashmap_config_t;
+
+/** @struct hashmap_arena
+ * @brief Append-only storage for keys too long to be stored inside their entry.
+ * Removed keys leave gaps, which are reclaimed by compaction.
+ */
+typedef struct hashmap_arena {
+	struct hashmap_arena_chunk* chunks; /**< Chunks allocated so far, the one being filled first */
+	dast_sz chunk_size; /**< Bytes per chunk. Zero disables the arena */
+	dast_sz used;       /**< Bytes taken in the chunk being filled */
+	dast_sz live;       /**< Bytes of keys still in the map */
+	dast_sz total;      /**< Bytes of keys appended, including removed ones */
+} hashmap_arena_t;
+
+/** @struct hashmap_pool
+ * @brief Pool of chained entries, carved from large slabs and recycled through a free list.
+ */
+typedef struct hashmap_pool {
+	struct hashmap_slab* slabs;     /**< Slabs allocated so far, newest first */
+	hashmap_entry_t*     free_list; /**< Released entries, linked through `next` */
+	dast_sz              slab_entries; /**< Entries per slab. Zero disables the pool */
+	dast_sz              used;      /**< Entries carved from the newest slab */
+} hashmap_pool_t;
+
+/** @struct hashmap_cursor
+ * @brief Position of an iteration over a hashmap, advanced by `hashmap_cursor_next`.
+ * Zero-initialise to start iterating.
+ */
+typedef struct hashmap_cursor {
+	const char*      key;    /**< Key of the current entry                  */
+	dast_sz          len;    /**< Number of bytes in the key                */
+	void*            value;  /**< Value of the current entry                */
+	hashmap_entry_t* entry;  /**< Current entry. Its value may be replaced  */
+	dast_sz          bucket; /**< Next bucket or slot to scan               */
+	dast_bool        in_old_table; /**< Whether `bucket` refers to the table of a pending incremental resize */
+} hashmap_cursor_t;
+
+/** @struct hashmap_counters
+ * @brief Work done by the lookups of a map, counted only when the library is compiled with `DAST_STATS`.
+ * Every function that finds, adds or removes a key does a lookup.
+ */
+typedef struct hashmap_counters {
+	dast_sz lookups;  /**< Keys looked up */
+	dast_sz probes;   /**< Entries visited (chained engine) or control groups loaded (open engine) by lookups */
+	dast_sz eq_calls; /**< Calls to the key equality function */
+} hashmap_counters_t;
+
+/** @struct hashmap_stats
+ * @brief Layout and memory use of a map at one point in time, filled by `hashmap_stats`.
+ * For the chained engine, a chain is the list of entries of a bucket.
+ * For the open engine, the chain of a key is the number of control groups a lookup of it loads.
+ */
+typedef struct hashmap_stats {
+	dast_sz  entries;     /**< Number of keys */
+	dast_sz  buckets;     /**< Number of buckets or slots, including those of a pending incremental resize not yet moved */
+	double   load_factor; /**< Keys per bucket or slot */
+	dast_sz  used_buckets; /**< Buckets holding at least one key, or slots holding a key */
+	dast_sz  max_chain;   /**< Length of the longest chain */
+	double   avg_chain;   /**< Average length of the non-empty chains (chained engine),
+	                           or groups loaded to find each key, on average (open engine) */
+	dast_sz  histogram[HASHMAP_STATS_BINS]; /**< Chained engine: number of buckets holding `i` keys.
+	                           Open engine: number of keys stored `i` groups past the first group they hash to */
+	dast_sz  resizes;     /**< Times the table was rebuilt, to grow, shrink or clean up removed slots */
+	dast_sz  table_bytes; /**< Bytes of bucket arrays (chained engine) or control bytes (open engine) */
+	dast_sz  entry_bytes; /**< Bytes of entries, including pool slabs and inline values */
+	dast_sz  key_bytes;   /**< Bytes of keys too long to be stored inside their entry, including the key arena */
+	dast_sz  total_bytes; /**< Bytes allocated by the map, the sum of the above */
+	hashmap_counters_t counters; /**< Lookup counters, zero unless compiled with `DAST_STATS` */
+} hashmap_stats_t;
+
 /** @struct hashmap_t
  * @brief Hash map data structure. Holds key-value pairs accessed via hashes.
  */
 typedef struct hashmap {
 	dast_sz           size;     /**< Total number of buckets  */
     dast_sz           entries;  /**< Number of filled buckets */
-	hashmap_entry_t** table;    /**< Hash table of entries    */
+	hashmap_entry_t** table;    /**< Hash table of entries (chained engine) */
+
+	hashmap_engine_t  engine;   /**< Storage engine */
+	dast_u8*          ctrl;     /**< Control byte per slot, plus a mirrored group (open engine) */
+	hashmap_entry_t*  slots;    /**< Flat array of entries (open engine) */
+
+	hashmap_entry_t** old_table;     /**< Buckets not yet moved by an incremental resize */
+	dast_sz           old_size;      /**< Number of buckets in `old_table` */
+	dast_sz           migrated;      /**< Number of buckets of `old_table` already moved */
+	dast_sz           rehash_budget; /**< Buckets moved per insert during an incremental resize */
+	hashmap_sizing_t  sizing;        /**< Bucket count policy (chained engine) */
+	dast_sz           deleted;       /**< Number of DELETED control bytes (open engine) */
+	dast_sz           min_size;      /**< Size hint the map was initialised with, below which it never shrinks */
+	hashmap_pool_t    pool;          /**< Entry pool (chained engine) */
+	hashmap_arena_t   arena;         /**< Key arena */
+	dast_sz           threads;       /**< Threads used by parallel resizes and bulk loads (chained engine) */
+	dast_sz           value_size;    /**< Bytes of each value stored inside its entry, or zero if values are pointers */
+	dast_sz           entry_size;    /**< Bytes between consecutive entries of a slab or slot array, including the value */
+	dast_sz           resizes;       /**< Times the table was rebuilt */
+	hashmap_counters_t counters;     /**< Lookup counters, updated only when compiled with `DAST_STATS` */
 
 	dast_allocator_t  alloc;    /**< Memory allocator       */
 	hashmap_hashfn_t  hash_fn;  /**< Hashing function       */
@@ -66,8 +250,26 @@ typedef struct hashmap {
 } hashmap_t;
 
 
-/** @brief FNV1-a 64-bit hashing algorithm */
-dast_u64 hashmap_FNV1a64_hash(const void* data, dast_sz len);
+/** @brief FNV1-a 64-bit hashing algorithm. With `DAST_HASH_32BIT`, the two halves of the hash are xored together */
+dast_hash_t hashmap_FNV1a64_hash(const void* data, dast_sz len);
+
+/** @brief FNV1-a 32-bit hashing algorithm, the default with `DAST_HASH_32BIT` */
+dast_hash_t hashmap_FNV1a32_hash(const void* data, dast_sz len);
+
+/** @brief wyhash 64-bit hashing algorithm. Reads 8 bytes at a time,
+ * and is much faster than FNV1-a on keys longer than a few bytes.
+ * With `DAST_HASH_32BIT`, the two halves of the hash are xored together. */
+dast_hash_t hashmap_wyhash64_hash(const void* data, dast_sz len);
+
+/** @brief wyhash 64-bit hashing algorithm with a seed. Always returns all 64 bits, even with `DAST_HASH_32BIT`.
+ * A seed of zero gives the same hash as `hashmap_wyhash64_hash` in the default 64-bit build. */
+dast_u64 hashmap_wyhash64_seeded(const void* data, dast_sz len, dast_u64 seed);
+
+/** @brief 64-bit hash built from two CRC32-C checksums.
+ * Uses the SSE4.2 `crc32` instruction on x86-64 CPUs that support it,
+ * and a lookup table with identical results elsewhere.
+ * With `DAST_HASH_32BIT`, the two checksums are mixed into 32 bits. */
+dast_hash_t hashmap_crc32c_hash(const void* data, dast_sz len);
 
 
 /** @brief Initialise hashmap via user-managed object.
@@ -83,7 +285,7 @@ hashmap_t* hashmap_init(hashmap_t* map, dast_sz size_hint);
  * @param map Hashmap to initialised
  * @param size_hint Starting number of buckets
  * @param alloc Memory allocation functions
- * @param hash_fn Hash function. If NULL, defaults to 64-bit FNV-1A.
+ * @param hash_fn Hash function. If NULL, defaults to 64-bit FNV-1A (32-bit with `DAST_HASH_32BIT`).
  * @param eq_fn Key equality function. Needed when hashes collide and keys need to be compared. If NULL, defaults to comparing the raw bytes of the two keys.
 */
 hashmap_t* hashmap_init_custom(
@@ -94,15 +296,45 @@ hashmap_t* hashmap_init_custom(
 	hashmap_eqfn_t    eq_fn
 );
 
+/** @brief Initialise hashmap via user-managed object from a set of options.
+ * Should be deleted with `hashmap_uninit`.
+ * @param map Hashmap to initialise
+ * @param config Options. Zeroed fields fall back to the defaults used by `hashmap_init_custom`.
+ * @returns the input map on success, and NULL otherwise
+ * @note With `HASHMAP_ENGINE_OPEN`, the number of slots is rounded up to a power of two
+ * no smaller than `HASHMAP_GROUP_WIDTH`.
+ */
+hashmap_t* hashmap_init_config(hashmap_t* map, hashmap_config_t config);
+
 
 /** @brief Clears a hashmap and removes all stored data.
- * It does not free the pointers to values, as these are managed by the user.
+ * It does not free the pointers to values, as these are managed by the user,
+ * except for the copies stored by maps with a `value_size`.
  * You must free the values yourself before uninitialising the hashmap.
  * You can do this by iterating over the keys and freeing each value in turn.
  * @param map hashmap to uninitialise
  */
 void hashmap_uninit(hashmap_t* map);
 
+/** @brief Computes the hash of a key with the hashing function of a map.
+ * The result can be passed to the `_hashed` functions of this map,
+ * or of any other map using the same hashing function, so that a key is hashed only once.
+ * @param map initialised hashmap
+ * @param bkey key to hash, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns the hash of the key, or zero if the map or key are NULL
+ */
+dast_hash_t hashmap_hashb(hashmap_t* map, const void* bkey, dast_sz key_len);
+
+/** @brief Computes the hash of a string key with the hashing function of a map.
+ * Use with the `_hashed` functions and `key.str` and `key.len + 1` as the key,
+ * as string keys include their null-terminating character.
+ * @param map initialised hashmap
+ * @param key string key
+ * @returns the hash of the key
+ */
+dast_hash_t hashmap_hash(hashmap_t* map, string_t key);
+
 /** @brief Checks if a map has a given key
  * @param map initialised hashmap
  * @param bkey key to find, can be any set of bytes
@@ -111,6 +343,16 @@ void hashmap_uninit(hashmap_t* map);
  */
 dast_bool hashmap_has_keyb(hashmap_t* map, const void* bkey, dast_sz key_len);
 
+/** @brief Checks if a map has a given key, using a hash computed beforehand.
+ * @param map initialised hashmap
+ * @param bkey key to find, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @param hash hash of the key, as returned by `hashmap_hashb`
+ * @returns `dast_true` if key exists in the map, and `dast_false` otherwise
+ * @warning A hash not computed with the hashing function of the map gives wrong results.
+ */
+dast_bool hashmap_has_keyb_hashed(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash);
+
 /** @brief Checks if a map has a given string key
  * @param map initialised hashmap
  * @param key string key
@@ -123,9 +365,20 @@ dast_bool hashmap_has_key(hashmap_t* map, string_t key);
  * @param bkey key to search for, which can be any set of bytes
  * @param key_len number of bytes in the key
  * @returns map element associated to the input key, or NULL if the key does not exist
+ * @note In maps with a `value_size`, this is a pointer to the copy of the value stored in the map.
  */
 void* hashmap_getb(hashmap_t* map, const void* bkey, dast_sz key_len);
 
+/** @brief Retrieves the data associated with a key, using a hash computed beforehand.
+ * @param hashmap to query
+ * @param bkey key to search for, which can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @param hash hash of the key, as returned by `hashmap_hashb`
+ * @returns map element associated to the input key, or NULL if the key does not exist
+ * @warning A hash not computed with the hashing function of the map gives wrong results.
+ */
+void* hashmap_getb_hashed(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash);
+
 /** @brief Retrieves the data associated with a key.
  * @param hashmap to query
  * @param bkey key to search for, which can be any set of bytes
@@ -134,6 +387,27 @@ void* hashmap_getb(hashmap_t* map, const void* bkey, dast_sz key_len);
  */
 void* hashmap_get(hashmap_t* map, string_t key);
 
+/** @brief Retrieves the data associated with many keys at once.
+ * All keys of a batch are hashed and their buckets prefetched before any is resolved,
+ * so that their cache misses overlap instead of happening one after another.
+ * @param map hashmap
+ * @param n number of keys
+ * @param bkeys array of `n` keys. NULL keys are never found.
+ * @param key_lens array of `n` key lengths in bytes
+ * @param values array of `n` pointers, filled with the value of each key, or NULL if it is not in the map
+ * @returns the number of keys found
+ */
+dast_sz hashmap_getb_many(hashmap_t* map, dast_sz n, const void* const* bkeys, const dast_sz* key_lens, void** values);
+
+/** @brief Retrieves the data associated with many string keys at once.
+ * @param map hashmap
+ * @param n number of keys
+ * @param keys array of `n` string keys
+ * @param values array of `n` pointers, filled with the value of each key, or NULL if it is not in the map
+ * @returns the number of keys found
+ */
+dast_sz hashmap_get_many(hashmap_t* map, dast_sz n, const string_t* keys, void** values);
+
 /** @brief Adds a new key-value pair to a hashmap. If the key already exists, the value is replaced.
  * @param map hashmap to which to insert value
  * @param bkey key to insert, can be any set of bytes
@@ -145,9 +419,25 @@ void* hashmap_get(hashmap_t* map, string_t key);
  * lasts for the lifetime of the corresponding hashmap key-value pair.
  * If this function is used to replace a value with the same key, the previous value pointer is dropped!!
  * Moreover, unlike the value, a copy of the key IS stored.
+ * Maps initialised with a `value_size` copy that many bytes from `value` instead (or zero them if it is NULL),
+ * and lookups return a pointer to the copy, which lives as long as the key.
  */
 hashmap_t* hashmap_setb(hashmap_t* map, const void* bkey, dast_sz key_len, void* value);
 
+/** @brief Adds a new key-value pair to a hashmap using a hash computed beforehand.
+ * If the key already exists, the value is replaced.
+ * @param map hashmap to which to insert value
+ * @param bkey key to insert, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @param hash hash of the key, as returned by `hashmap_hashb`
+ * @param value pointer to value to insert
+ * @returns pointer to map if insert is successful, or NULL otherwise
+ * @note See `hashmap_setb`.
+ * @warning A hash not computed with the hashing function of the map corrupts it:
+ * the key is stored where lookups will not find it.
+ */
+hashmap_t* hashmap_setb_hashed(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash, void* value);
+
 /** @brief Adds a new key-value pair to a hashmap. If the key already exists, the value is replaced.
  * @param map hashmap to which to insert value
  * @param key string key
@@ -161,20 +451,145 @@ hashmap_t* hashmap_setb(hashmap_t* map, const void* bkey, dast_sz key_len, void*
  */
 hashmap_t* hashmap_set(hashmap_t* map, string_t key, void* value); 
 
+/** @brief Returns a pointer to the value of a key, inserting the key first if it is not in the map.
+ * Needs a single hash and a single probe, e.g. to update counters:
+ * 	```c
+ * 	dast_bool inserted;
+ * 	void** value = hashmap_upsertb(map, word, len, &inserted);
+ * 	*value = (void*)((dast_sz)*value + 1); // New keys start with a NULL value
+ * 	```
+ * @param map hashmap
+ * @param bkey key to find or insert, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @param inserted if not NULL, set to `dast_true` if the key was inserted and `dast_false` if it already existed
+ * @returns a pointer to the value of the key, which is NULL for new keys, or NULL if the key could not be inserted
+ * @note The pointer is only valid until the map is next modified.
+ * In maps with a `value_size`, the value points to the copy stored in the entry, zeroed for new keys,
+ * which can be modified in place but must not be replaced:
+ * 	```c
+ * 	(*(dast_u64*)*hashmap_upsertb(map, word, len, dast_null))++;
+ * 	```
+ */
+void** hashmap_upsertb(hashmap_t* map, const void* bkey, dast_sz key_len, dast_bool* inserted);
+
+/** @brief Returns a pointer to the value of a key using a hash computed beforehand,
+ * inserting the key first if it is not in the map.
+ * @param hash hash of the key, as returned by `hashmap_hashb`
+ * @note See `hashmap_upsertb` and `hashmap_setb_hashed`.
+ */
+void** hashmap_upsertb_hashed(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash, dast_bool* inserted);
+
+/** @brief Returns a pointer to the value of a string key, inserting the key first if it is not in the map.
+ * @param map hashmap
+ * @param key string key
+ * @param inserted if not NULL, set to `dast_true` if the key was inserted and `dast_false` if it already existed
+ * @returns a pointer to the value of the key, or NULL if the key could not be inserted
+ * @note See `hashmap_upsertb`.
+ */
+void** hashmap_upsert(hashmap_t* map, string_t key, dast_bool* inserted);
+
+/** @brief Removes a key from a hashmap, freeing its entry and its copy of the key.
+ * The value is not freed, but can be retrieved with `value` to be disposed of.
+ * Maps shrink after a removal once their load drops below `1 / HASHMAP_SHRINK_RATIO` of the maximum,
+ * but never below the size they were initialised with.
+ * @param map hashmap
+ * @param bkey key to remove, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @param value if not NULL, set to the value of the removed key. Set to NULL in maps with a `value_size`,
+ * whose values are freed with their entry.
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the map
+ * @note Pointers returned by `hashmap_upsertb` and cursors on the removed entry become invalid.
+ * A removal that shrinks the map moves every entry, which invalidates all such pointers and cursors.
+ * Maps with a key arena compact it once most of it is taken by removed keys, which moves the other keys.
+ */
+dast_bool hashmap_removeb(hashmap_t* map, const void* bkey, dast_sz key_len, void** value);
+
+/** @brief Removes a string key from a hashmap, freeing its entry and its copy of the key.
+ * @param map hashmap
+ * @param key string key
+ * @param value if not NULL, set to the value of the removed key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the map
+ * @note See `hashmap_removeb`.
+ */
+dast_bool hashmap_remove(hashmap_t* map, string_t key, void** value);
+
 /** @brief Extends the hash table to a size equal to the next prime number from its current size.
  * @param map hashmap to extend
  * @returns mthe input map if successful, and NULL otherwise
- * @note This is a CPU intensive operation, as the whole table is rehashed.
+ * @note This is a CPU intensive operation, as every entry is moved to a new bucket.
+ * Entries are relinked using their stored hashes, so only the new bucket array is allocated.
  * The table should resize itself automatically when the number of keys
  * reaches some fraction of the number of buckets.
+ * Maps using `HASHMAP_SIZING_POW2` round the new size up to a power of two instead,
+ * and maps using `HASHMAP_ENGINE_OPEN` double their number of slots.
+ * Chained maps initialised with `threads` split the table among that many threads,
+ * as long as each gets at least `HASHMAP_PARALLEL_MIN_ENTRIES` entries.
  */
 hashmap_t* hashmap_resize(hashmap_t* map);
 
+/** @brief Sizes the table of a map to hold a number of keys without growing.
+ * The table is rebuilt at most once, instead of on every growth step while the keys are added.
+ * Has no effect if the table is already large enough.
+ * @param map hashmap
+ * @param n_keys total number of keys the map should be able to hold
+ * @returns the input map on success, and NULL otherwise
+ */
+hashmap_t* hashmap_reserve(hashmap_t* map, dast_sz n_keys);
+
+/** @brief Adds many key-value pairs to a hashmap at once, e.g. to load a dataset of known size.
+ * The table is sized for all keys beforehand. Maps with an entry pool (`pool_slab_entries`)
+ * get one slab for every new entry, and maps with a key arena (`key_arena_chunk`)
+ * one chunk for every new long key, so the load makes a handful of allocations in total.
+ * Keys that already exist have their value replaced, as with `hashmap_setb`.
+ * Chained maps initialised with `threads` hash the keys and add them using several threads,
+ * each adding the keys of its own part of the table, once there are `HASHMAP_PARALLEL_MIN_ENTRIES` keys per thread.
+ * @param map hashmap
+ * @param n number of keys
+ * @param bkeys array of `n` keys, each any set of bytes
+ * @param key_lens array of `n` key lengths in bytes
+ * @param values array of `n` values
+ * @returns the input map on success, and NULL otherwise, in which case only some keys may have been added
+ */
+hashmap_t* hashmap_setb_many(hashmap_t* map, dast_sz n, const void* const* bkeys, const dast_sz* key_lens, void* const* values);
+
+/** @brief Adds many key-value pairs with string keys to a hashmap at once.
+ * @param map hashmap
+ * @param n number of keys
+ * @param keys array of `n` string keys
+ * @param values array of `n` values
+ * @returns the input map on success, and NULL otherwise
+ * @note See `hashmap_setb_many`.
+ */
+hashmap_t* hashmap_set_many(hashmap_t* map, dast_sz n, const string_t* keys, void* const* values);
+
+/** @brief Moves buckets of a pending incremental resize into the new table.
+ * Maps initialised with a non-zero `rehash_budget` grow by allocating a larger table
+ * and then moving a few buckets on each insert, instead of all at once.
+ * Meanwhile, lookups check both tables. This function can be used to move
+ * buckets at a convenient time, e.g. when idle.
+ * @note The new table is still allocated and zeroed in one go when a resize starts.
+ * @param map hashmap
+ * @param buckets maximum number of buckets to move
+ * @returns `dast_true` if buckets remain to be moved, and `dast_false` otherwise
+ */
+dast_bool hashmap_rehash_step(hashmap_t* map, dast_sz buckets);
+
+/** @brief Compacts the key arena of a map, copying the keys still in the map into a single chunk.
+ * Removed keys leave gaps in the arena. Maps compact their arena on their own when they resize
+ * and most of it is taken by gaps; this function can be used to do it at a convenient time.
+ * Has no effect on maps without a key arena (see `key_arena_chunk` in `hashmap_config_t`).
+ * @param map hashmap
+ * @returns the input map on success, and NULL otherwise
+ * @note Pointers to keys, e.g. returned by `hashmap_iterb`, become invalid.
+ */
+hashmap_t* hashmap_compact_keys(hashmap_t* map);
+
 /** @brief Returns the next key in a hashmap.
  * @param bkey Previous key, which can be any set of bytes. To start iterating, input NULL.
  * @param key_len number of bytes in the key. Must point to valid memory.
  * @returns the next key in the hashmap, with it length stored in the input `key_len`.
  * @note When the functions returns NULL, there are no more keys to fetch.
+ * Each call looks up the previous key again; `hashmap_cursor_next` avoids this.
  * Example:
  * 	```c
  * 	char* key = NULL;
@@ -201,5 +616,39 @@ void* hashmap_iterb(hashmap_t* map, const char* bkey, dast_sz* key_len);
 */
 string_t* hashmap_iter(hashmap_t* map, string_t* key);
 
+/** @brief Advances a cursor to the next entry of a hashmap.
+ * Unlike `hashmap_iterb`, the cursor remembers its position,
+ * so each step costs no hashing or key lookup.
+ * @param map hashmap
+ * @param cursor Position in the map. Zero-initialise to start iterating.
+ * @returns `dast_true` if the cursor now holds the key, length and value of an entry,
+ * and `dast_false` once all entries have been visited.
+ * @note Keys must not be added to the map while iterating.
+ * Example:
+ * 	```c
+ * 	hashmap_cursor_t cursor = {0};
+ * 	while( hashmap_cursor_next(map, &cursor) ){
+ * 		... cursor.key, cursor.len, cursor.value ...
+ * 	}
+ * 	```
+ */
+dast_bool hashmap_cursor_next(hashmap_t* map, hashmap_cursor_t* cursor);
+
+/** @brief Measures the layout and memory use of a map, e.g. to tune `size_hint` and `hash_fn` for a set of keys.
+ * Walks every bucket or slot, so it takes time proportional to the size of the map.
+ * @param map hashmap
+ * @param stats filled with the measurements and the lookup counters of the map
+ * @returns `stats` on success, and NULL if the map or `stats` are NULL
+ * @note Lookup counters are only updated when the library is compiled with `DAST_STATS`.
+ * They are then added to atomically, as lookups may run on several threads at once, e.g. on the maps of a `snapmap_t`,
+ * so that concurrent readers contend on them.
+ */
+hashmap_stats_t* hashmap_stats(hashmap_t* map, hashmap_stats_t* stats);
+
+/** @brief Zeroes the lookup counters of a map, e.g. before measuring a workload.
+ * @param map hashmap
+ */
+void hashmap_reset_counters(hashmap_t* map);
+
 
 #endif /* HASHMAP_H */
@@ -0,0 +1,206 @@
+/** @file hashset.h
+* `hashset.h` is an implementation of a set of keys, using the hashing and equality functions of `hashmap.h`.
+* It is laid out like an open-addressing `hashmap_t` (see `HASHMAP_ENGINE_OPEN`),
+* but its entries have no value and no chain pointer,
+* so sets take less memory than maps whose values are all NULL.
+*
+* Entries keep the hash of their key, so that union, intersection and difference
+* of sets sharing a hashing function never hash a key again.
+*
+* Example code:
+* ```c
+*     hashset_t set;
+*     hashset_init(&set, 5); // Starting capacity
+*
+*     hashset_insert(&set, string_scoped_lit("apple"));
+*     hashset_insert(&set, string_scoped_lit("pear"));
+*
+*     assert(hashset_contains(&set, string_scoped_lit("pear")));
+*     assert(!hashset_contains(&set, string_scoped_lit("plum")));
+*
+*     hashset_uninit(&set);
+* ```
+*/
+
+
+#ifndef HASHSET_H
+#define HASHSET_H
+
+#include "defs.h"
+#include "mem.h"
+#include "str.h"
+#include "hashmap.h"
+
+
+/** @struct hashset_entry
+ * @brief Key of a set.
+ * Keys no longer than `HASHMAP_SMALL_KEY_SIZE` are copied into `small_key`,
+ * in which case `key` points to it. Longer keys are allocated separately.
+ */
+typedef struct hashset_entry {
+	char*         key;   /**< Key (may be string or binary) */
+	hashmap_len_t len;   /**< Number of bytes in the key    */
+	dast_hash_t   hash;  /**< Hash of the key, kept to skip key comparisons and rehashing */
+	char          small_key[HASHMAP_SMALL_KEY_SIZE]; /**< Storage for short keys */
+} hashset_entry_t;
+
+/** @struct hashset_cursor
+ * @brief Position of an iteration over a set, advanced by `hashset_cursor_next`.
+ * Zero-initialise to start iterating.
+ */
+typedef struct hashset_cursor {
+	const char* key;  /**< Current key                 */
+	dast_sz     len;  /**< Number of bytes in the key  */
+	dast_sz     slot; /**< Next slot to scan           */
+} hashset_cursor_t;
+
+/** @struct hashset_t
+ * @brief Set of keys, stored in a flat array of slots indexed by control bytes.
+ */
+typedef struct hashset {
+	dast_sz          size;     /**< Number of slots, a power of two */
+	dast_sz          entries;  /**< Number of keys */
+	dast_sz          deleted;  /**< Number of DELETED control bytes */
+	dast_sz          min_size; /**< Size hint the set was initialised with, below which it never shrinks */
+	dast_u8*         ctrl;     /**< Control byte per slot, plus a mirrored group */
+	hashset_entry_t* slots;    /**< Flat array of entries */
+
+	dast_allocator_t alloc;    /**< Memory allocator       */
+	hashmap_hashfn_t hash_fn;  /**< Hashing function       */
+	hashmap_eqfn_t   eq_fn;    /**< Key equality function  */
+} hashset_t;
+
+
+/** @brief Initialise a set via user-managed object.
+ * Should be deleted using `hashset_uninit`.
+ * @param set Set to initialise
+ * @param size_hint starting number of slots, rounded up to a power of two no smaller than `HASHMAP_GROUP_WIDTH`
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_init(hashset_t* set, dast_sz size_hint);
+
+/** @brief Initialise a set via user-managed object with custom allocator and/or hash function.
+ * Should be deleted with `hashset_uninit`.
+ * @param set Set to initialise
+ * @param size_hint Starting number of slots
+ * @param alloc Memory allocation functions
+ * @param hash_fn Hash function. If NULL, defaults to `HASHMAP_DEFAULT_HASH`.
+ * @param eq_fn Key equality function. If NULL, defaults to comparing the raw bytes of the two keys.
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_init_custom(
+	hashset_t*        set,
+	dast_sz           size_hint,
+	dast_allocator_t  alloc,
+	hashmap_hashfn_t  hash_fn,
+	hashmap_eqfn_t    eq_fn
+);
+
+/** @brief Initialises a set with a copy of the keys of another, with the same allocator and functions.
+ * The slots are copied as they are, without looking up or hashing any key.
+ * Should be deleted with `hashset_uninit`.
+ * @param set Set to initialise
+ * @param src Set to copy
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_copy(hashset_t* set, hashset_t* src);
+
+/** @brief Frees a set and its copies of the keys.
+ * @param set set to uninitialise
+ */
+void hashset_uninit(hashset_t* set);
+
+/** @brief Returns the number of keys in a set.
+ * @param set set
+ * @returns the number of keys
+ */
+dast_sz hashset_count(hashset_t* set);
+
+/** @brief Adds a key to a set. Does nothing if the key is already in it.
+ * @param set set
+ * @param bkey key to add, can be any set of bytes. A copy of it is stored.
+ * @param key_len number of bytes in the key
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_insertb(hashset_t* set, const void* bkey, dast_sz key_len);
+
+/** @brief Adds a string key to a set. Does nothing if the key is already in it.
+ * @param set set
+ * @param key string key
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_insert(hashset_t* set, string_t key);
+
+/** @brief Checks if a set has a given key
+ * @param set set
+ * @param bkey key to find, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if the key is in the set, and `dast_false` otherwise
+ */
+dast_bool hashset_containsb(hashset_t* set, const void* bkey, dast_sz key_len);
+
+/** @brief Checks if a set has a given string key
+ * @param set set
+ * @param key string key
+ * @returns `dast_true` if the key is in the set, and `dast_false` otherwise
+ */
+dast_bool hashset_contains(hashset_t* set, string_t key);
+
+/** @brief Removes a key from a set, freeing its copy of the key.
+ * Sets shrink once mostly empty, never below their starting size.
+ * @param set set
+ * @param bkey key to remove
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the set
+ */
+dast_bool hashset_removeb(hashset_t* set, const void* bkey, dast_sz key_len);
+
+/** @brief Removes a string key from a set, freeing its copy of the key.
+ * @param set set
+ * @param key string key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the set
+ */
+dast_bool hashset_remove(hashset_t* set, string_t key);
+
+/** @brief Advances a cursor to the next key of a set.
+ * Keys may be removed while iterating, but adding keys may move them.
+ * Example:
+ * 	```c
+ * 	hashset_cursor_t cursor = {0};
+ * 	while( hashset_cursor_next(set, &cursor) ){
+ * 		use(cursor.key, cursor.len);
+ * 	}
+ * 	```
+ * @param set set
+ * @param cursor Zero-initialised to start iterating
+ * @returns `dast_true` if the cursor now holds a key, and `dast_false` once all keys have been visited
+ */
+dast_bool hashset_cursor_next(hashset_t* set, hashset_cursor_t* cursor);
+
+/** @brief Adds every key of `other` to `set`.
+ * @param set set to add keys to
+ * @param other keys to add, left unchanged
+ * @returns the input set on success, and NULL otherwise, in which case only some of the keys may have been added
+ * @note Keys are only hashed again if the two sets have different hashing functions.
+ */
+hashset_t* hashset_union(hashset_t* set, hashset_t* other);
+
+/** @brief Removes every key of `set` that is not in `other`.
+ * @param set set to remove keys from
+ * @param other keys to keep, left unchanged
+ * @returns the input set, or NULL if either set is NULL
+ * @note Keys are only hashed again if the two sets have different hashing functions.
+ */
+hashset_t* hashset_intersect(hashset_t* set, hashset_t* other);
+
+/** @brief Removes every key of `other` from `set`.
+ * Looks up the keys of whichever set is smaller in the other one.
+ * @param set set to remove keys from
+ * @param other keys to remove, left unchanged
+ * @returns the input set, or NULL if either set is NULL
+ * @note Keys are only hashed again if the two sets have different hashing functions.
+ */
+hashset_t* hashset_difference(hashset_t* set, hashset_t* other);
+
+
+#endif /* HASHSET_H */
@@ -0,0 +1,192 @@
+/** @file snapmap.h
+* `snapmap.h` publishes read-only snapshots of a `hashmap_t` to many reader threads,
+* for read-mostly tables (e.g. configuration or routing) that are rebuilt every so often.
+*
+* A writer builds a complete new map, and replaces the current one with `snapmap_publish`.
+* Readers fetch the current map with a single acquire load, and query it with the usual
+* `hashmap_t` lookup functions, taking no locks and writing no shared memory.
+* Libraries compiled with `DAST_STATS` are the exception: lookups then add atomically
+* to the counters of the map (see `hashmap_stats`), which readers contend on.
+*
+* Replaced maps are freed with quiescent-state-based reclamation: each reader thread registers
+* a `snapmap_reader_t`, and calls `snapmap_quiescent` whenever it holds no pointer to a map,
+* e.g. between requests. A replaced map is freed once every registered reader has done so.
+*
+* Example code:
+* ```c
+*     // Writer
+*     hashmap_t* map = snapmap_new_map(&snap, (hashmap_config_t){.size_hint = 100});
+*     hashmap_set(map, string_scoped_lit("route"), &value);
+*     snapmap_publish(&snap, map); // The previous map is freed once readers move on
+*
+*     // Reader thread
+*     snapmap_reader_t reader;
+*     snapmap_register(&snap, &reader);
+*     while(serving){
+*         void* v = snapmap_get(&snap, string_scoped_lit("route"));
+*         ...
+*         snapmap_quiescent(&snap, &reader); // No map pointers held past this point
+*     }
+*     snapmap_unregister(&snap, &reader);
+* ```
+*/
+
+
+#ifndef SNAPMAP_H
+#define SNAPMAP_H
+
+#include "defs.h"
+#include "mem.h"
+#include "str.h"
+#include "hashmap.h"
+
+
+/** Value of `snapmap_reader_t.seen` while a reader is offline */
+#define SNAPMAP_OFFLINE ((dast_sz)-1)
+
+
+/** @typedef Function called on a replaced map just before it is freed, e.g. to free its values */
+typedef void (*snapmap_reclaim_fn_t)(hashmap_t* map);
+
+/** @struct snapmap_reader
+ * @brief Registration of a reader thread. Owned by the reader, and linked into the snapmap.
+ */
+typedef struct snapmap_reader {
+	volatile dast_sz       seen; /**< Last epoch the reader passed a quiescent state in, or `SNAPMAP_OFFLINE` */
+	struct snapmap_reader* next; /**< Next registered reader */
+} snapmap_reader_t;
+
+/** @struct snapmap_retired
+ * @brief Replaced map waiting for readers to move on.
+ */
+typedef struct snapmap_retired {
+	hashmap_t* map;   /**< Replaced map */
+	dast_sz    epoch; /**< Epoch every reader must have seen before the map is freed */
+} snapmap_retired_t;
+
+/** @struct snapmap_t
+ * @brief Atomically published snapshot of a hashmap.
+ */
+typedef struct snapmap {
+	hashmap_t* volatile current; /**< Published map, or NULL before the first publication */
+	volatile dast_sz    epoch;   /**< Number of publications so far, plus one */
+
+	volatile dast_sz    lock;    /**< Held by writers, and while readers register */
+	snapmap_reader_t*   readers; /**< Registered readers */
+	snapmap_retired_t*  retired; /**< Replaced maps not yet freed */
+	dast_sz             retired_len; /**< Number of replaced maps not yet freed */
+	dast_sz             retired_cap; /**< Capacity of `retired` */
+
+	dast_allocator_t     alloc;      /**< Allocator of the maps and of `retired` */
+	snapmap_reclaim_fn_t on_reclaim; /**< Called on each map before it is freed, if not NULL */
+} snapmap_t;
+
+
+/** @brief Initialise a snapmap with no published map.
+ * Should be deleted with `snapmap_uninit`.
+ * @param snap snapmap to initialise
+ * @returns the input snapmap on success, and NULL otherwise
+ */
+snapmap_t* snapmap_init(snapmap_t* snap);
+
+/** @brief Initialise a snapmap with a custom allocator and/or a function to dispose of replaced maps.
+ * @param snap snapmap to initialise
+ * @param alloc Memory allocation functions, used for the maps created with `snapmap_new_map`.
+ * Must be thread-safe if maps are published and freed from different threads.
+ * @param on_reclaim Called on each replaced map before it is freed, e.g. to free its values. May be NULL.
+ * @returns the input snapmap on success, and NULL otherwise
+ */
+snapmap_t* snapmap_init_custom(snapmap_t* snap, dast_allocator_t alloc, snapmap_reclaim_fn_t on_reclaim);
+
+/** @brief Frees the published map and every replaced one.
+ * @param snap snapmap
+ * @warning Not thread-safe: no other thread may be using the snapmap.
+ */
+void snapmap_uninit(snapmap_t* snap);
+
+/** @brief Allocates and initialises a map to be filled and then published with `snapmap_publish`.
+ * @param snap snapmap
+ * @param config Options of the map. If no allocator is given, the allocator of the snapmap is used.
+ * @returns a new map, or NULL on failure
+ */
+hashmap_t* snapmap_new_map(snapmap_t* snap, hashmap_config_t config);
+
+/** @brief Replaces the map seen by readers. The previous map is freed once every reader has moved on.
+ * The map must not be modified after being published.
+ * @param snap snapmap
+ * @param map map created with `snapmap_new_map`, or NULL to unpublish the current map
+ * @returns the input snapmap on success, and NULL otherwise
+ * @note Readers that are registered but have not called `snapmap_quiescent` since keep the previous map alive.
+ * Readers that never register must not read the snapmap while maps are being replaced.
+ */
+snapmap_t* snapmap_publish(snapmap_t* snap, hashmap_t* map);
+
+/** @brief Frees the replaced maps that no reader can still be using.
+ * Called by `snapmap_publish`; can also be called at any other time, e.g. periodically.
+ * @param snap snapmap
+ * @returns the number of replaced maps still waiting for readers
+ */
+dast_sz snapmap_reclaim(snapmap_t* snap);
+
+/** @brief Waits until every replaced map has been freed.
+ * @param snap snapmap
+ * @warning Never returns if called from a registered, online reader thread.
+ */
+void snapmap_synchronize(snapmap_t* snap);
+
+/** @brief Returns the published map, which must only be read. A single acquire load.
+ * The map stays valid until the calling reader next calls `snapmap_quiescent`.
+ * @param snap snapmap
+ * @returns the published map, or NULL if none has been published
+ */
+hashmap_t* snapmap_current(snapmap_t* snap);
+
+/** @brief Retrieves the data associated with a key in the published map.
+ * @param snap snapmap
+ * @param bkey key to search for, which can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns the value of the key, or NULL if the key or a published map do not exist
+ */
+void* snapmap_getb(snapmap_t* snap, const void* bkey, dast_sz key_len);
+
+/** @brief Retrieves the data associated with a string key in the published map.
+ * @param snap snapmap
+ * @param key string key
+ * @returns the value of the key, or NULL if the key or a published map do not exist
+ */
+void* snapmap_get(snapmap_t* snap, string_t key);
+
+/** @brief Registers the calling thread as a reader. The reader starts online.
+ * @param snap snapmap
+ * @param reader registration, which must outlive the call to `snapmap_unregister`
+ */
+void snapmap_register(snapmap_t* snap, snapmap_reader_t* reader);
+
+/** @brief Unregisters a reader. It must hold no pointers to maps of the snapmap.
+ * @param snap snapmap
+ * @param reader registration passed to `snapmap_register`
+ */
+void snapmap_unregister(snapmap_t* snap, snapmap_reader_t* reader);
+
+/** @brief Announces that a reader holds no pointers to maps of the snapmap,
+ * allowing the maps replaced so far to be freed. One load and one store to memory owned by the reader.
+ * @param snap snapmap
+ * @param reader registration of the calling thread
+ */
+void snapmap_quiescent(snapmap_t* snap, snapmap_reader_t* reader);
+
+/** @brief Marks a reader as offline, e.g. before blocking, so it does not hold back reclamation.
+ * The reader must not read the snapmap until it calls `snapmap_online`.
+ * @param snap snapmap
+ * @param reader registration of the calling thread
+ */
+void snapmap_offline(snapmap_t* snap, snapmap_reader_t* reader);
+
+/** @brief Marks an offline reader as online again, so it can read the snapmap.
+ * @param snap snapmap
+ * @param reader registration of the calling thread
+ */
+void snapmap_online(snapmap_t* snap, snapmap_reader_t* reader);
+
+
+#endif /* SNAPMAP_H */
@@ -0,0 +1,270 @@
+/** @file typedmap.h
+* `typedmap.h` generates hashmaps specialised for a key type and a value type at compile time.
+* `DAST_HASHMAP_DEFINE(name, KeyT, ValT, hash, eq)` defines a map type `name_t` and its functions,
+* e.g. `name_set` and `name_get`, which store keys and values in place and call `hash` and `eq` directly,
+* so that the compiler can inline them instead of calling through function pointers.
+*
+* `hash(key)` must return a `dast_u64` for a `KeyT`, and `eq(a, b)` must return non-zero if two `KeyT` are equal.
+* Both can be functions or macros; `typedmap_hash_u64` and `typedmap_eq` suit integer and pointer keys.
+*
+* Maps use open addressing with linear probing, over a power-of-two array of slots
+* and a control byte per slot holding part of the hash of its key,
+* so that `eq` only runs on keys whose control byte matches.
+*
+* Example code:
+* ```c
+*     DAST_HASHMAP_DEFINE(intmap, dast_u64, float, typedmap_hash_u64, typedmap_eq)
+*
+*     intmap_t map;
+*     intmap_init(&map, 16);
+*     intmap_set(&map, 42, 0.5f);
+*     float* x = intmap_get(&map, 42);
+*     intmap_uninit(&map);
+* ```
+*
+* Generated functions:
+* | Function                                         | Description                                                  |
+* |--------------------------------------------------|--------------------------------------------------------------|
+* | `name_t* name_init(map, size_hint)`              | Initialise with the default allocator                        |
+* | `name_t* name_init_custom(map, size_hint, alloc)`| Initialise with a `dast_allocator_t`                         |
+* | `void name_uninit(map)`                          | Free the slots                                               |
+* | `dast_sz name_count(map)`                        | Number of keys                                               |
+* | `ValT* name_get(map, key)`                       | Pointer to the value of a key, or NULL                       |
+* | `dast_bool name_has(map, key)`                   | Whether a key is in the map                                  |
+* | `ValT* name_upsert(map, key, inserted)`          | Pointer to the value of a key, inserted zeroed if missing    |
+* | `name_t* name_set(map, key, value)`              | Add or replace a key                                         |
+* | `dast_bool name_remove(map, key, value)`         | Remove a key, copying its value out if `value` is not NULL   |
+* | `name_t* name_reserve(map, n)`                   | Size the map for `n` keys                                    |
+* | `dast_bool name_next(map, cursor, key, value)`   | Iterate, starting from a zeroed `dast_sz` cursor             |
+*
+* Pointers to keys and values are only valid until the map is next modified.
+*/
+
+
+#ifndef TYPEDMAP_H
+#define TYPEDMAP_H
+
+#include "defs.h"
+#include "mem.h"
+
+
+/** Maps grow once `(keys + removed slots) * DEN > slots * NUM` */
+#define TYPEDMAP_MAX_LOAD_NUM 3
+#define TYPEDMAP_MAX_LOAD_DEN 4
+
+/** Smallest number of slots of a map */
+#define TYPEDMAP_MIN_SLOTS 8
+
+/** Control byte of a slot that has never held a key */
+#define TYPEDMAP_CTRL_EMPTY   ((dast_u8)0x00)
+
+/** Control byte of a slot whose key was removed, which does not end probe sequences */
+#define TYPEDMAP_CTRL_DELETED ((dast_u8)0x01)
+
+#define TYPEDMAP_FIBONACCI_MULTIPLIER ((dast_u64)0x9E3779B97F4A7C15)
+
+
+/** @brief Hash of an integer key. The bits are mixed by the map, so the key is its own hash */
+#define typedmap_hash_u64(KEY) ((dast_u64)(KEY))
+
+/** @brief Equality of keys that can be compared with `==` */
+#define typedmap_eq(A, B) ((A) == (B))
+
+/** @brief Hash of a pointer key */
+#define typedmap_hash_ptr(KEY) ((dast_u64)(dast_sz)(KEY))
+
+
+/** @brief Defines a hashmap type `name##_t` mapping `KeyT` keys to `ValT` values, and its functions.
+ * @param name prefix of the type and functions
+ * @param KeyT key type, copied into the map
+ * @param ValT value type, copied into the map
+ * @param hash function or macro taking a `KeyT` and returning its `dast_u64` hash
+ * @param eq function or macro taking two `KeyT` and returning non-zero if they are equal
+ */
+#define DAST_HASHMAP_DEFINE(name, KeyT, ValT, hash, eq) \
+\
+typedef struct name##_slot { \
+	KeyT key;   /**< Key   */ \
+	ValT value; /**< Value */ \
+} name##_slot_t; \
+\
+typedef struct name { \
+	name##_slot_t*   slots;   /**< Array of `size` slots */ \
+	dast_u8*         ctrl;    /**< Control byte of each slot: empty, deleted, or a tag of the hash of its key */ \
+	dast_sz          size;    /**< Number of slots, a power of two */ \
+	dast_sz          entries; /**< Number of keys */ \
+	dast_sz          deleted; /**< Number of deleted control bytes */ \
+	dast_u32         shift;   /**< 64 minus the base-2 logarithm of `size`, for Fibonacci hashing */ \
+	dast_allocator_t alloc;   /**< Memory allocator */ \
+} name##_t; \
+\
+/* Mixed hash of a key. Its top bits pick the first slot, and bits below them the tag */ \
+static inline dast_u64 name##_mix(KeyT key){ \
+	return (dast_u64)(hash(key)) * TYPEDMAP_FIBONACCI_MULTIPLIER; \
+} \
+\
+static inline dast_u8 name##_tag(dast_u64 mixed){ \
+	return (dast_u8)(0x80 | ((mixed >> 24) & 0x7F)); \
+} \
+\
+/* Slot of a key, or `map->size` if it is not in the map */ \
+static inline dast_sz name##_find(const name##_t* map, KeyT key, dast_u64 mixed){ \
+	dast_sz mask = map->size - 1; \
+	dast_sz i = (dast_sz)(mixed >> map->shift); \
+	dast_u8 tag = name##_tag(mixed); \
+	for (;;) { \
+		dast_u8 c = map->ctrl[i]; \
+		if (c == TYPEDMAP_CTRL_EMPTY) return map->size; \
+		if (c == tag && (eq(map->slots[i].key, key))) return i; \
+		i = (i + 1) & mask; \
+	} \
+} \
+\
+/* Moves every key into a new array of `size` slots, dropping deleted control bytes */ \
+static inline name##_t* name##_rehash(name##_t* map, dast_sz size){ \
+	name##_slot_t* slots = map->alloc.alloc(size * sizeof(name##_slot_t)); \
+	dast_u8* ctrl = map->alloc.alloc(size); \
+	if (!slots || !ctrl) { \
+		if (slots) map->alloc.free(slots); \
+		if (ctrl)  map->alloc.free(ctrl); \
+		return dast_null; \
+	} \
+	dast_memset(ctrl, TYPEDMAP_CTRL_EMPTY, size); \
+	dast_u32 shift = 64; \
+	for (dast_sz s = size; s > 1; s >>= 1) shift--; \
+	for (dast_sz i = 0; i != map->size; ++i) { \
+		if (map->ctrl[i] < 0x80) continue; \
+		dast_u64 mixed = name##_mix(map->slots[i].key); \
+		dast_sz j = (dast_sz)(mixed >> shift); \
+		while (ctrl[j] != TYPEDMAP_CTRL_EMPTY) j = (j + 1) & (size - 1); \
+		ctrl[j] = map->ctrl[i]; \
+		slots[j] = map->slots[i]; \
+	} \
+	if (map->slots) map->alloc.free(map->slots); \
+	if (map->ctrl)  map->alloc.free(map->ctrl); \
+	map->slots = slots; \
+	map->ctrl = ctrl; \
+	map->size = size; \
+	map->shift = shift; \
+	map->deleted = 0; \
+	return map; \
+} \
+\
+/** @brief Initialise a map with a custom allocator. Should be deleted with `name##_uninit` */ \
+static inline name##_t* name##_init_custom(name##_t* map, dast_sz size_hint, dast_allocator_t alloc){ \
+	if (!map) return dast_null; \
+	*map = (name##_t){0}; \
+	if (!alloc.alloc || !alloc.realloc || !alloc.free) return dast_null; \
+	map->alloc = alloc; \
+	dast_sz size = TYPEDMAP_MIN_SLOTS; \
+	while (size * TYPEDMAP_MAX_LOAD_NUM < size_hint * TYPEDMAP_MAX_LOAD_DEN) size <<= 1; \
+	return name##_rehash(map, size); \
+} \
+\
+/** @brief Initialise a map with the default allocator. Should be deleted with `name##_uninit` */ \
+static inline name##_t* name##_init(name##_t* map, dast_sz size_hint){ \
+	return name##_init_custom(map, size_hint, DAST_DEFAULT_ALLOCATOR); \
+} \
+\
+/** @brief Frees the slots of a map, along with its keys and values */ \
+static inline void name##_uninit(name##_t* map){ \
+	if (!map || !map->slots) return; \
+	map->alloc.free(map->slots); \
+	map->alloc.free(map->ctrl); \
+	*map = (name##_t){0}; \
+} \
+\
+/** @brief Returns the number of keys in a map */ \
+static inline dast_sz name##_count(const name##_t* map){ \
+	return map ? map->entries : 0; \
+} \
+\
+/** @brief Returns a pointer to the value of a key, or NULL if it is not in the map */ \
+static inline ValT* name##_get(name##_t* map, KeyT key){ \
+	if (!map || !map->slots) return dast_null; \
+	dast_sz i = name##_find(map, key, name##_mix(key)); \
+	return (i != map->size) ? &map->slots[i].value : dast_null; \
+} \
+\
+/** @brief Checks if a map has a key */ \
+static inline dast_bool name##_has(name##_t* map, KeyT key){ \
+	return name##_get(map, key) != dast_null; \
+} \
+\
+/** @brief Returns a pointer to the value of a key, inserting the key with a zeroed value if it is not in the map. \
+ * Returns NULL if the key could not be inserted */ \
+static inline ValT* name##_upsert(name##_t* map, KeyT key, dast_bool* inserted){ \
+	if (!map || !map->slots) return dast_null; \
+	dast_u64 mixed = name##_mix(key); \
+	dast_sz i = name##_find(map, key, mixed); \
+	if (inserted) *inserted = (i == map->size); \
+	if (i != map->size) return &map->slots[i].value; \
+	\
+	/* Keep an empty slot at the end of every probe sequence. Mostly deleted slots are cleaned up without growing */ \
+	if ((map->entries + map->deleted + 1) * TYPEDMAP_MAX_LOAD_DEN > map->size * TYPEDMAP_MAX_LOAD_NUM) { \
+		dast_bool crowded = (map->entries + 1) * TYPEDMAP_MAX_LOAD_DEN * 2 > map->size * TYPEDMAP_MAX_LOAD_NUM; \
+		if (!name##_rehash(map, crowded ? map->size * 2 : map->size)) return dast_null; \
+	} \
+	\
+	i = (dast_sz)(mixed >> map->shift); \
+	while (map->ctrl[i] >= 0x80) i = (i + 1) & (map->size - 1); \
+	if (map->ctrl[i] == TYPEDMAP_CTRL_DELETED) map->deleted--; \
+	map->ctrl[i] = name##_tag(mixed); \
+	dast_memset(&map->slots[i], 0, sizeof(name##_slot_t)); \
+	map->slots[i].key = key; \
+	map->entries++; \
+	return &map->slots[i].value; \
+} \
+\
+/** @brief Adds a key-value pair to a map, replacing the value if the key already exists. \
+ * Returns NULL if the key could not be inserted */ \
+static inline name##_t* name##_set(name##_t* map, KeyT key, ValT value){ \
+	ValT* slot = name##_upsert(map, key, dast_null); \
+	if (!slot) return dast_null; \
+	*slot = value; \
+	return map; \
+} \
+\
+/** @brief Removes a key from a map, copying its value to `value` if not NULL. \
+ * Returns `dast_true` if the key was removed, and `dast_false` if it was not in the map */ \
+static inline dast_bool name##_remove(name##_t* map, KeyT key, ValT* value){ \
+	if (!map || !map->slots) return dast_false; \
+	dast_sz i = name##_find(map, key, name##_mix(key)); \
+	if (i == map->size) return dast_false; \
+	if (value) *value = map->slots[i].value; \
+	/* No probe sequence goes past a slot followed by an empty one */ \
+	if (map->ctrl[(i + 1) & (map->size - 1)] == TYPEDMAP_CTRL_EMPTY) { \
+		map->ctrl[i] = TYPEDMAP_CTRL_EMPTY; \
+	} else { \
+		map->ctrl[i] = TYPEDMAP_CTRL_DELETED; \
+		map->deleted++; \
+	} \
+	map->entries--; \
+	return dast_true; \
+} \
+\
+/** @brief Sizes a map to hold `n` keys without growing. Returns NULL on failure */ \
+static inline name##_t* name##_reserve(name##_t* map, dast_sz n){ \
+	if (!map || !map->slots) return dast_null; \
+	dast_sz size = map->size; \
+	while (size * TYPEDMAP_MAX_LOAD_NUM < n * TYPEDMAP_MAX_LOAD_DEN) size <<= 1; \
+	return (size == map->size) ? map : name##_rehash(map, size); \
+} \
+\
+/** @brief Advances a cursor to the next key of a map, starting from a zeroed cursor. \
+ * `key` and `value`, if not NULL, are set to point to the key and value. \
+ * Returns `dast_false` once every key has been visited */ \
+static inline dast_bool name##_next(name##_t* map, dast_sz* cursor, KeyT** key, ValT** value){ \
+	if (!map || !cursor) return dast_false; \
+	while (*cursor < map->size) { \
+		dast_sz i = (*cursor)++; \
+		if (map->ctrl[i] < 0x80) continue; \
+		if (key)   *key   = &map->slots[i].key; \
+		if (value) *value = &map->slots[i].value; \
+		return dast_true; \
+	} \
+	return dast_false; \
+}
+
+
+#endif /* TYPEDMAP_H */
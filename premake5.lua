@@ -31,7 +31,7 @@ project "dast"
     location "build/%{prj.name}"
     objdir ("obj/" .. OutputDir .. "/%{prj.name}" )
     targetdir ("bin/" .. OutputDir .. "/%{prj.name}" )
-    files { "src/**.c", "include/**.h" }
+    files { "src/**.c", "src/**.h", "include/**.h" }
     includedirs { "include" }
     filter { "system:linux", "action:gmake2" }
         buildoptions {"-pedantic" }
@@ -48,7 +48,7 @@ project "test"
     includedirs { "include" }
 
     filter "system:linux"
-        links {"cmocka"}
+        links {"cmocka", "pthread"}
     filter "system:windows"
         links {"cmocka.dll"}
 
@@ -62,3 +62,18 @@ project "extras"
     files { "extras/**.c", "extras/**.h" }
     links { "dast" }
     includedirs { "include" }
+
+project "bench"
+    kind "ConsoleApp"
+    language "C"
+    cdialect "C99"
+    optimize "Speed"
+    location "build/%{prj.name}"
+    objdir ("obj/" .. OutputDir .. "/%{prj.name}" )
+    targetdir ("bin/" .. OutputDir .. "/%{prj.name}" )
+    files { "bench/**.c", "bench/**.h" }
+    links { "dast" }
+    includedirs { "include", "bench" }
+
+    filter "system:linux"
+        links {"pthread"}
@@ -0,0 +1,502 @@
+#include "chashmap.h"
+
+#if !defined(DAST_NO_STDLIB) && defined(__unix__)
+    #include <sched.h> /* sched_yield */
+#endif
+
+
+#if !defined(DAST_ATOMICS)
+    #error "chashmap needs GCC, Clang or MSVC atomic builtins"
+#endif
+
+#if defined(_MSC_VER)
+    #define CHASHMAP_THREAD_LOCAL __declspec(thread)
+#else
+    #define CHASHMAP_THREAD_LOCAL __thread
+#endif
+
+#define CHASHMAP_FETCH_SUB(P, V) DAST_ATOMIC_FETCH_ADD((P), (dast_sz)0 - (V))
+
+
+/*
+ * ----------------
+ * Static Functions
+ * ----------------
+ */
+
+
+/** 2^64 divided by the golden ratio, used to spread hashes over power-of-two tables */
+#define CHASHMAP_FIBONACCI 11400714819323198485ull
+
+/** Base-2 logarithm of `CHASHMAP_STRIPES` */
+static dast_u32 chashmap_stripe_bits(void){
+    dast_u32 bits = 0;
+    while (((dast_sz)1 << bits) < CHASHMAP_STRIPES) bits++;
+    return bits;
+}
+
+/** Returns the stripe of a hash. Stripes take the top bits of the Fibonacci hash, as buckets do,
+ * so every bucket belongs to a single stripe whatever the size of the table */
+static chashmap_stripe_t* chashmap_stripe(chashmap_t* map, dast_hash_t hash){
+    return &map->stripes[((dast_u64)hash * CHASHMAP_FIBONACCI) >> (64 - chashmap_stripe_bits())];
+}
+
+/** Returns the bucket of a table where keys with the given hash are stored */
+static chashmap_node_t* volatile* chashmap_bucket(chashmap_table_t* table, dast_hash_t hash){
+    return &table->buckets[((dast_u64)hash * CHASHMAP_FIBONACCI) >> table->shift];
+}
+
+/** Waits for other threads, yielding the CPU after a while so a preempted lock holder can run */
+static void chashmap_backoff(dast_sz* spins){
+    if (++*spins < 64) { DAST_CPU_PAUSE(); return; }
+    *spins = 0;
+#if !defined(DAST_NO_STDLIB) && defined(__unix__)
+    sched_yield();
+#endif
+}
+
+/** Acquires a spinlock */
+static void chashmap_lock(volatile dast_sz* lock){
+    dast_sz spins = 0;
+    while (DAST_ATOMIC_EXCHANGE(lock, 1)) {
+        while (DAST_ATOMIC_LOAD(lock)) chashmap_backoff(&spins);
+    }
+}
+
+/** Releases a spinlock */
+static void chashmap_unlock(volatile dast_sz* lock){
+    DAST_ATOMIC_STORE(lock, 0);
+}
+
+/** Counter of reader slots handed out to threads so far */
+static volatile dast_sz chashmap_slots_taken = 0;
+
+/** Reader slot of the calling thread plus one, or zero until it is first needed */
+static CHASHMAP_THREAD_LOCAL dast_sz chashmap_thread_slot = 0;
+
+/** Returns the reader slot of the calling thread. Threads are spread over the slots in turn */
+static dast_sz chashmap_reader_slot(void){
+    if (!chashmap_thread_slot) {
+        chashmap_thread_slot = (DAST_ATOMIC_FETCH_ADD(&chashmap_slots_taken, 1) & (CHASHMAP_READER_SLOTS - 1)) + 1;
+    }
+    return chashmap_thread_slot - 1;
+}
+
+/** Announces a reader, returning the counter it was added to.
+ * The counter belongs to the current epoch, which is checked again afterwards so that
+ * allocations freed by an epoch change that raced with the announcement are never reached. */
+static volatile dast_sz* chashmap_read_begin(chashmap_t* map){
+    chashmap_readers_t* readers = &map->readers[chashmap_reader_slot()];
+    for (;;) {
+        dast_sz epoch = DAST_ATOMIC_LOAD(&map->epoch);
+        volatile dast_sz* active = &readers->active[epoch & 1];
+        DAST_ATOMIC_FETCH_ADD(active, 1);
+        if (DAST_ATOMIC_LOAD(&map->epoch) == epoch) return active;
+        CHASHMAP_FETCH_SUB(active, 1);
+    }
+}
+
+/** Withdraws a reader announced by `chashmap_read_begin` */
+static void chashmap_read_end(volatile dast_sz* active){
+    CHASHMAP_FETCH_SUB(active, 1);
+}
+
+/** Frees a retired allocation: an entry, or a table along with the entries of all its chains */
+static void chashmap_free_retired(chashmap_t* map, void* item){
+    if (!((dast_sz)item & 1)) {
+        map->alloc.free(item);
+        return;
+    }
+    chashmap_table_t* table = (chashmap_table_t*)((dast_sz)item & ~(dast_sz)1);
+    for (dast_sz i = 0; i != table->size; ++i) {
+        chashmap_node_t* node = table->buckets[i];
+        while (node) {
+            chashmap_node_t* next = node->next;
+            map->alloc.free(node);
+            node = next;
+        }
+    }
+    map->alloc.free(table);
+}
+
+/** Frees the allocations retired two epochs ago and advances the epoch,
+ * if every reader that started in the previous epoch is done. Needs `limbo_lock`.
+ * Allocations retired in an epoch were unlinked before the next one started,
+ * so only readers of that epoch and earlier can still be using them.
+ * @returns `dast_true` if the epoch was advanced */
+static dast_bool chashmap_try_advance(chashmap_t* map){
+    dast_sz epoch = DAST_ATOMIC_LOAD(&map->epoch);
+    dast_sz prev = (epoch + 1) & 1;
+    DAST_ATOMIC_FENCE();
+    for (dast_sz i = 0; i != CHASHMAP_READER_SLOTS; ++i) {
+        if (DAST_ATOMIC_LOAD(&map->readers[i].active[prev])) return dast_false;
+    }
+    chashmap_limbo_t* limbo = &map->limbo[prev];
+    for (dast_sz i = 0; i != limbo->len; ++i) {
+        chashmap_free_retired(map, limbo->items[i]);
+    }
+    limbo->len = 0;
+    DAST_ATOMIC_STORE(&map->epoch, epoch + 1);
+    DAST_ATOMIC_FENCE();
+    return dast_true;
+}
+
+/** Hands an allocation no longer reachable from the map over to be freed once no reader can see it.
+ * If the retired list cannot grow, waits for the readers instead. */
+static void chashmap_retire(chashmap_t* map, void* item){
+    DAST_ATOMIC_FENCE();
+    chashmap_lock(&map->limbo_lock);
+    chashmap_limbo_t* limbo = &map->limbo[DAST_ATOMIC_LOAD(&map->epoch) & 1];
+
+    if (limbo->len == limbo->cap) {
+        dast_sz cap = limbo->cap ? limbo->cap * 2 : CHASHMAP_RECLAIM_THRESHOLD;
+        void** items = map->alloc.realloc(limbo->items, cap * sizeof(void*));
+        if (!items) {
+            /* Two epoch changes outlast every reader that could see the allocation */
+            dast_sz spins = 0;
+            for (int changes = 0; changes != 2; ) {
+                if (chashmap_try_advance(map)) changes++;
+                else chashmap_backoff(&spins);
+            }
+            chashmap_unlock(&map->limbo_lock);
+            chashmap_free_retired(map, item);
+            return;
+        }
+        limbo->items = items;
+        limbo->cap = cap;
+    }
+    limbo->items[limbo->len++] = item;
+
+    if (map->limbo[0].len + map->limbo[1].len >= CHASHMAP_RECLAIM_THRESHOLD) {
+        chashmap_try_advance(map);
+    }
+    chashmap_unlock(&map->limbo_lock);
+}
+
+/** Allocates an empty table able to hold `n` buckets, rounded up to a power of two */
+static chashmap_table_t* chashmap_alloc_table(chashmap_t* map, dast_sz n){
+    dast_sz size = CHASHMAP_STRIPES;
+    dast_u32 bits = chashmap_stripe_bits();
+    while (size < n) { size <<= 1; bits++; }
+
+    chashmap_table_t* table = map->alloc.alloc(sizeof(chashmap_table_t) + size * sizeof(chashmap_node_t*));
+    if (!table) return dast_null;
+    table->size = size;
+    table->shift = 64 - bits;
+    dast_memset((void*)table->buckets, 0, size * sizeof(chashmap_node_t*));
+    return table;
+}
+
+/** Allocates an entry holding a copy of a key */
+static chashmap_node_t* chashmap_node_alloc(chashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash, void* value){
+    chashmap_node_t* node = map->alloc.alloc(sizeof(chashmap_node_t) + key_len);
+    if (!node) return dast_null;
+    node->next = dast_null;
+    node->value = value;
+    node->hash = hash;
+    node->len = key_len;
+    dast_memcpy(node->key, bkey, key_len);
+    return node;
+}
+
+/** Returns the entry of a key in a chain, following links with atomic loads */
+static chashmap_node_t* chashmap_search(chashmap_t* map, chashmap_node_t* node, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    for (; node; node = DAST_ATOMIC_LOAD(&node->next)) {
+        if (node->hash == hash && node->len == key_len && map->eq_fn(bkey, node->key, key_len)) {
+            return node;
+        }
+    }
+    return dast_null;
+}
+
+/** Locks every stripe, in order, so no other writer can run */
+static void chashmap_lock_all(chashmap_t* map){
+    for (dast_sz i = 0; i != CHASHMAP_STRIPES; ++i) chashmap_lock(&map->stripes[i].lock);
+}
+
+/** Releases every stripe */
+static void chashmap_unlock_all(chashmap_t* map){
+    for (dast_sz i = CHASHMAP_STRIPES; i != 0; --i) chashmap_unlock(&map->stripes[i - 1].lock);
+}
+
+/** Replaces a table of `seen_size` buckets with one twice as large, unless another writer already did.
+ * Readers may still be following the chains of the old table, so its entries are copied rather than
+ * relinked, and the old table is retired along with them once the new one has been published.
+ * On failure, the map keeps the old table. */
+static void chashmap_grow(chashmap_t* map, dast_sz seen_size){
+    chashmap_lock_all(map);
+    chashmap_table_t* old = map->table;
+    if (old->size != seen_size) {
+        chashmap_unlock_all(map);
+        return;
+    }
+
+    chashmap_table_t* table = chashmap_alloc_table(map, old->size * 2);
+    if (!table) {
+        chashmap_unlock_all(map);
+        return;
+    }
+
+    for (dast_sz i = 0; i != old->size; ++i) {
+        for (chashmap_node_t* node = old->buckets[i]; node; node = node->next) {
+            chashmap_node_t* copy = chashmap_node_alloc(map, node->key, node->len, node->hash, node->value);
+            if (!copy) {
+                /* Free only the copies made so far */
+                for (dast_sz j = 0; j != table->size; ++j) {
+                    chashmap_node_t* c = table->buckets[j];
+                    while (c) { chashmap_node_t* next = c->next; map->alloc.free(c); c = next; }
+                }
+                map->alloc.free(table);
+                chashmap_unlock_all(map);
+                return;
+            }
+            chashmap_node_t* volatile* bucket = chashmap_bucket(table, node->hash);
+            copy->next = *bucket;
+            *bucket = copy;
+        }
+    }
+
+    DAST_ATOMIC_STORE(&map->table, table);
+    chashmap_unlock_all(map);
+    chashmap_retire(map, (void*)((dast_sz)old | 1));
+}
+
+/** Frees every entry, table and retired allocation of a map */
+static void chashmap_free(chashmap_t* map){
+    for (int i = 0; i != 2; ++i) {
+        for (dast_sz j = 0; j != map->limbo[i].len; ++j) {
+            chashmap_free_retired(map, map->limbo[i].items[j]);
+        }
+        map->alloc.free(map->limbo[i].items);
+    }
+    chashmap_free_retired(map, (void*)((dast_sz)map->table | 1));
+}
+
+
+/*
+ * ----------------
+ * Public Functions
+ * ----------------
+ */
+
+
+/** @brief Initialise a concurrent hashmap via user-managed object with custom allocator and/or hash function.
+ * Should be deleted with `chashmap_uninit`.
+ * @param map Concurrent hashmap to initialise
+ * @param size_hint Starting number of buckets
+ * @param alloc Memory allocation functions, which must be thread-safe
+ * @param hash_fn Hash function. If NULL, defaults to `HASHMAP_DEFAULT_HASH`.
+ * @param eq_fn Key equality function. If NULL, defaults to comparing the raw bytes of the two keys.
+ * @returns the input map on success, and NULL otherwise
+ */
+chashmap_t* chashmap_init_custom(
+	chashmap_t*       map,
+	dast_sz           size_hint,
+	dast_allocator_t  alloc,
+	hashmap_hashfn_t  hash_fn,
+	hashmap_eqfn_t    eq_fn
+){
+    if(!map) return dast_null;
+    dast_memset(map, 0, sizeof(chashmap_t));
+
+    map->hash_fn = hash_fn ? hash_fn : HASHMAP_DEFAULT_HASH;
+    map->eq_fn   = eq_fn   ? eq_fn   : dast_memeq;
+
+    if(!alloc.alloc || !alloc.realloc || !alloc.free){
+#ifdef DAST_NO_STDLIB
+        return dast_null;
+#else
+        map->alloc = DAST_DEFAULT_ALLOCATOR;
+#endif
+    } else map->alloc = alloc;
+
+    map->table = chashmap_alloc_table(map, size_hint);
+    if(!map->table) return dast_null;
+    return map;
+}
+
+/** @brief Initialise a concurrent hashmap via user-managed object.
+ * Should be deleted using `chashmap_uninit`.
+ * @param map Concurrent hashmap to initialise
+ * @param size_hint starting number of buckets
+ * @returns the input map on success, and NULL otherwise
+ */
+chashmap_t* chashmap_init(chashmap_t* map, dast_sz size_hint){
+    return chashmap_init_custom(map, size_hint, DAST_DEFAULT_ALLOCATOR, dast_null, dast_null);
+}
+
+/** @brief Clears a concurrent hashmap and frees all its entries and keys.
+ * @param map Concurrent hashmap to uninitialise
+ */
+void chashmap_uninit(chashmap_t* map){
+    if(!map || !map->table) return;
+    chashmap_free(map);
+    dast_memset(map, 0, sizeof(chashmap_t));
+}
+
+/** @brief Checks if a concurrent map has a given key. Takes no locks.
+ * @param map Concurrent hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if key exists in the map, and `dast_false` otherwise
+ */
+dast_bool chashmap_has_keyb(chashmap_t* map, const void* bkey, dast_sz key_len){
+    if(!map || !bkey) return dast_false;
+    dast_hash_t hash = map->hash_fn(bkey, key_len);
+
+    volatile dast_sz* reader = chashmap_read_begin(map);
+    chashmap_table_t* table = DAST_ATOMIC_LOAD(&map->table);
+    chashmap_node_t* node = chashmap_search(map, DAST_ATOMIC_LOAD(chashmap_bucket(table, hash)), bkey, key_len, hash);
+    chashmap_read_end(reader);
+    return node != dast_null;
+}
+
+/** @brief Checks if a concurrent map has a given string key. Takes no locks.
+ * @param map Concurrent hashmap
+ * @param key string key
+ * @returns `dast_true` if key exists in the map, and `dast_false` otherwise
+ */
+dast_bool chashmap_has_key(chashmap_t* map, string_t key){
+    if (!key.str) return dast_false;
+    return chashmap_has_keyb(map, key.str, key.len + 1); /* Include null-terminating char */
+}
+
+/** @brief Retrieves the data associated with a key. Takes no locks.
+ * @param map Concurrent hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @returns the value of the key, or NULL if the key does not exist
+ */
+void* chashmap_getb(chashmap_t* map, const void* bkey, dast_sz key_len){
+    if(!map || !bkey) return dast_null;
+    dast_hash_t hash = map->hash_fn(bkey, key_len);
+    void* value = dast_null;
+
+    volatile dast_sz* reader = chashmap_read_begin(map);
+    chashmap_table_t* table = DAST_ATOMIC_LOAD(&map->table);
+    chashmap_node_t* node = chashmap_search(map, DAST_ATOMIC_LOAD(chashmap_bucket(table, hash)), bkey, key_len, hash);
+    if (node) value = DAST_ATOMIC_LOAD(&node->value);
+    chashmap_read_end(reader);
+    return value;
+}
+
+/** @brief Retrieves the data associated with a string key. Takes no locks.
+ * @param map Concurrent hashmap
+ * @param key string key
+ * @returns the value of the key, or NULL if the key does not exist
+ */
+void* chashmap_get(chashmap_t* map, string_t key){
+    if (!key.str) return dast_null;
+    return chashmap_getb(map, key.str, key.len + 1); /* Include null-terminating char */
+}
+
+/** @brief Adds a new key-value pair to a concurrent map. If the key already exists, the value is replaced.
+ * @param map Concurrent hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @param value pointer to value to insert
+ * @returns pointer to map if insert is successful, or NULL otherwise
+ */
+chashmap_t* chashmap_setb(chashmap_t* map, const void* bkey, dast_sz key_len, void* value){
+    if(!map || !bkey) return dast_null;
+    dast_hash_t hash = map->hash_fn(bkey, key_len);
+    chashmap_stripe_t* stripe = chashmap_stripe(map, hash);
+
+    /* The table cannot be replaced while a stripe is held */
+    chashmap_lock(&stripe->lock);
+    chashmap_table_t* table = map->table;
+    chashmap_node_t* volatile* bucket = chashmap_bucket(table, hash);
+
+    chashmap_node_t* node = chashmap_search(map, *bucket, bkey, key_len, hash);
+    if (node) {
+        DAST_ATOMIC_STORE(&node->value, value);
+        chashmap_unlock(&stripe->lock);
+        return map;
+    }
+
+    node = chashmap_node_alloc(map, bkey, key_len, hash, value);
+    if (!node) {
+        chashmap_unlock(&stripe->lock);
+        return dast_null;
+    }
+    node->next = *bucket;
+    DAST_ATOMIC_STORE(bucket, node); /* Publishes the entry with its key and value */
+
+    /* Extend once the stripe is at the load `hashmap_t` grows at. Stripes fill evenly, as buckets do.
+     * The table may be replaced and freed as soon as the stripe is released, so only its size is kept */
+    dast_sz entries = stripe->entries + 1;
+    dast_sz size = table->size;
+    DAST_ATOMIC_STORE(&stripe->entries, entries);
+    chashmap_unlock(&stripe->lock);
+
+    if (entries * HASHMAP_LOADING_FACTOR >= size / CHASHMAP_STRIPES) {
+        chashmap_grow(map, size);
+    }
+    return map;
+}
+
+/** @brief Adds a new key-value pair with a string key to a concurrent map.
+ * @param map Concurrent hashmap
+ * @param key string key
+ * @param value pointer to value to insert
+ * @returns pointer to map if insert is successful, or NULL otherwise
+ */
+chashmap_t* chashmap_set(chashmap_t* map, string_t key, void* value){
+    if (!key.str) return dast_null;
+    return chashmap_setb(map, key.str, key.len + 1, value); /* Include null-terminating char */
+}
+
+/** @brief Removes a key from a concurrent map. Its entry is freed once no reader can still see it.
+ * @param map Concurrent hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @param value if not NULL, set to the value of the removed key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the map
+ */
+dast_bool chashmap_removeb(chashmap_t* map, const void* bkey, dast_sz key_len, void** value){
+    if(!map || !bkey) return dast_false;
+    dast_hash_t hash = map->hash_fn(bkey, key_len);
+    chashmap_stripe_t* stripe = chashmap_stripe(map, hash);
+
+    chashmap_lock(&stripe->lock);
+    chashmap_node_t* volatile* link = chashmap_bucket(map->table, hash);
+    for (; *link; link = &(*link)->next) {
+        chashmap_node_t* node = *link;
+        if (node->hash == hash && node->len == key_len && map->eq_fn(bkey, node->key, key_len)) {
+            /* Readers on the entry still see its `next` link, which is left untouched */
+            DAST_ATOMIC_STORE(link, node->next);
+            DAST_ATOMIC_STORE(&stripe->entries, stripe->entries - 1);
+            chashmap_unlock(&stripe->lock);
+
+            if (value) *value = node->value;
+            chashmap_retire(map, node);
+            return dast_true;
+        }
+    }
+    chashmap_unlock(&stripe->lock);
+    return dast_false;
+}
+
+/** @brief Removes a string key from a concurrent map.
+ * @param map Concurrent hashmap
+ * @param key string key
+ * @param value if not NULL, set to the value of the removed key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the map
+ */
+dast_bool chashmap_remove(chashmap_t* map, string_t key, void** value){
+    if (!key.str) return dast_false;
+    return chashmap_removeb(map, key.str, key.len + 1, value); /* Include null-terminating char */
+}
+
+/** @brief Returns the number of keys in a concurrent map.
+ * @param map Concurrent hashmap
+ * @returns the number of keys
+ */
+dast_sz chashmap_count(chashmap_t* map){
+    if(!map) return 0;
+    dast_sz count = 0;
+    for (dast_sz i = 0; i != CHASHMAP_STRIPES; ++i) {
+        count += DAST_ATOMIC_LOAD(&map->stripes[i].entries);
+    }
+    return count;
+}
@@ -0,0 +1,375 @@
+#include "frozenmap.h"
+
+
+/* Spreads pilots over 64 bits before they are mixed with a hash */
+#define FROZENMAP_PILOT_MULTIPLIER ((dast_u64)0x9E3779B97F4A7C15)
+
+/* Byte of a mixed hash stored in the slot of its key. Bucket and slot are picked from the top 32 bits */
+#define FROZENMAP_FINGERPRINT(mixed) ((dast_u8)(mixed))
+
+/* Largest number of keys, so that slots can be picked from 32-bit numbers */
+#define FROZENMAP_MAX_ENTRIES ((dast_sz)0xFFFFFFFF)
+
+
+/*
+ * ----------------
+ * Static Functions
+ * ----------------
+ */
+
+/** Key being placed while freezing a map */
+typedef struct frozenmap_key {
+    hashmap_entry_t* entry; /**< Entry of the key in the map */
+    dast_u64         mixed; /**< Hash of the key, mixed with the seed */
+} frozenmap_key_t;
+
+/** State of a map being frozen, allocated once and reused for every seed tried */
+typedef struct frozenmap_build {
+    frozenmap_key_t* keys;    /**< Keys of the map */
+    dast_sz*  bucket_start;   /**< Index in `order` of the first key of each bucket, plus the end of the last one */
+    dast_sz*  order;          /**< Keys grouped by bucket */
+    dast_sz*  by_size;        /**< Buckets, largest first */
+    dast_sz*  slot_key;       /**< Key placed in each slot */
+    dast_u64* taken;          /**< Bit set for every slot already taken */
+    dast_u32* pilots;         /**< Pilot of each bucket */
+} frozenmap_build_t;
+
+/** Returns a 64-bit number whose bits all depend on every bit of the input (splitmix64 finaliser) */
+static dast_u64 frozenmap_mix(dast_u64 x){
+    x ^= x >> 30;
+    x *= (dast_u64)0xBF58476D1CE4E5B9;
+    x ^= x >> 27;
+    x *= (dast_u64)0x94D049BB133111EB;
+    x ^= x >> 31;
+    return x;
+}
+
+/** Maps a 32-bit number onto `[0, n)` with a multiplication instead of a division, for `n` up to 2^32 */
+static dast_sz frozenmap_range(dast_u64 x, dast_sz n){
+    return (dast_sz)(((x & 0xFFFFFFFF) * (dast_u64)n) >> 32);
+}
+
+/** Returns the bucket of a mixed hash */
+static dast_sz frozenmap_bucket(dast_u64 mixed, dast_sz buckets){
+    return frozenmap_range(mixed >> 32, buckets);
+}
+
+/** Returns the slot of a mixed hash, given the pilot of its bucket */
+static dast_sz frozenmap_position(dast_u64 mixed, dast_u32 pilot, dast_sz entries){
+    return frozenmap_range(frozenmap_mix(mixed ^ (pilot * FROZENMAP_PILOT_MULTIPLIER)) >> 32, entries);
+}
+
+/** Returns the hash a key is placed by: its hash under the function of the map mixed with the seed,
+ * or a seeded hash of its bytes if the map had keys with the same hash */
+static dast_u64 frozenmap_key_hash(frozenmap_t* frozen, const void* bkey, dast_sz key_len){
+    if (frozen->hash_keys) return hashmap_wyhash64_seeded(bkey, key_len, frozen->seed);
+    return frozenmap_mix((dast_u64)frozen->hash_fn(bkey, key_len) ^ frozen->seed);
+}
+
+/** Returns the slot a key would be found in, or `frozen->entries` if the key is not in the map */
+static dast_sz frozenmap_find(frozenmap_t* frozen, const void* bkey, dast_sz key_len){
+    dast_u64 mixed = frozenmap_key_hash(frozen, bkey, key_len);
+    dast_u32 pilot = frozen->pilots[frozenmap_bucket(mixed, frozen->buckets)];
+    dast_sz  i     = frozenmap_position(mixed, pilot, frozen->entries);
+
+    /* Most absent keys are rejected here, without reading any key */
+    if (frozen->fingerprints[i] != FROZENMAP_FINGERPRINT(mixed)) return frozen->entries;
+    DAST_PREFETCH((char*)frozen->values + i * frozen->value_stride);
+
+    dast_u32 start = frozen->key_offsets[i];
+    if (frozen->key_offsets[i + 1] - start != key_len) return frozen->entries;
+    if (!frozen->eq_fn(bkey, frozen->keys + start, key_len)) return frozen->entries;
+    return i;
+}
+
+/** Frees the state of a map being frozen */
+static void frozenmap_build_free(frozenmap_build_t* b, dast_allocator_t* alloc){
+    if (b->keys)         alloc->free(b->keys);
+    if (b->bucket_start) alloc->free(b->bucket_start);
+    if (b->order)        alloc->free(b->order);
+    if (b->by_size)      alloc->free(b->by_size);
+    if (b->slot_key)     alloc->free(b->slot_key);
+    if (b->taken)        alloc->free(b->taken);
+    if (b->pilots)       alloc->free(b->pilots);
+}
+
+/** Tries to find a pilot for every bucket with the seed of the frozen map, largest buckets first,
+ * so that the buckets hardest to place are placed while most slots are free.
+ * @returns 1 on success, 0 if a pilot could not be found with this seed,
+ * and -1 if two keys have the same mixed hash, which they do for every seed unless `hash_keys` is set.
+ */
+static int frozenmap_place(frozenmap_t* frozen, frozenmap_build_t* b, dast_sz n, dast_sz buckets){
+    dast_sz max_size = 0;
+
+    /* Group the keys by bucket */
+    for (dast_sz i = 0; i != n; ++i) {
+        hashmap_entry_t* entry = b->keys[i].entry;
+        if (frozen->hash_keys) b->keys[i].mixed = frozenmap_key_hash(frozen, entry->key, entry->len);
+        else                   b->keys[i].mixed = frozenmap_mix((dast_u64)entry->hash ^ frozen->seed);
+    }
+    dast_memset(b->bucket_start, 0, (buckets + 1) * sizeof(dast_sz));
+    for (dast_sz i = 0; i != n; ++i) b->bucket_start[frozenmap_bucket(b->keys[i].mixed, buckets) + 1]++;
+    for (dast_sz k = 0; k != buckets; ++k) {
+        dast_sz size = b->bucket_start[k + 1];
+        if (size > max_size) max_size = size;
+        b->bucket_start[k + 1] += b->bucket_start[k];
+    }
+    /* `by_size` serves as the fill position of each bucket until the buckets are sorted */
+    dast_memset(b->by_size, 0, buckets * sizeof(dast_sz));
+    for (dast_sz i = 0; i != n; ++i) {
+        dast_sz k = frozenmap_bucket(b->keys[i].mixed, buckets);
+        b->order[b->bucket_start[k] + b->by_size[k]++] = i;
+    }
+
+    /* Sort the buckets by decreasing size, with a counting sort.
+       `slot_key` counts the buckets of each size, then serves as the fill position of each size,
+       until it is filled with the key of each slot */
+    dast_memset(b->slot_key, 0, (max_size + 2) * sizeof(dast_sz));
+    for (dast_sz k = 0; k != buckets; ++k) b->slot_key[max_size - (b->bucket_start[k + 1] - b->bucket_start[k]) + 1]++;
+    for (dast_sz s = 0; s != max_size + 1; ++s) b->slot_key[s + 1] += b->slot_key[s];
+    for (dast_sz k = 0; k != buckets; ++k) b->by_size[b->slot_key[max_size - (b->bucket_start[k + 1] - b->bucket_start[k])]++] = k;
+
+    dast_memset(b->taken, 0, ((n + 63) / 64) * sizeof(dast_u64));
+    for (dast_sz s = 0; s != buckets; ++s) {
+        dast_sz k = b->by_size[s];
+        dast_sz* keys = b->order + b->bucket_start[k];
+        dast_sz  size = b->bucket_start[k + 1] - b->bucket_start[k];
+        if (size == 0) {
+            b->pilots[k] = 0;
+            continue;
+        }
+
+        for (dast_sz j = 1; j < size; ++j) {
+            for (dast_sz l = 0; l != j; ++l) {
+                if (b->keys[keys[j]].mixed == b->keys[keys[l]].mixed) return -1;
+            }
+        }
+
+        dast_u32 pilot = 0;
+        for (;;) {
+            dast_sz j;
+            for (j = 0; j != size; ++j) {
+                dast_sz pos = frozenmap_position(b->keys[keys[j]].mixed, pilot, n);
+                if (b->taken[pos / 64] & ((dast_u64)1 << (pos % 64))) break;
+                /* Mark the slot straight away, so that keys of the bucket landing on the same slot are caught */
+                b->taken[pos / 64] |= (dast_u64)1 << (pos % 64);
+                b->slot_key[pos] = keys[j];
+            }
+            if (j == size) break;
+
+            /* Release the slots marked by this pilot */
+            while (j--) {
+                dast_sz pos = frozenmap_position(b->keys[keys[j]].mixed, pilot, n);
+                b->taken[pos / 64] &= ~((dast_u64)1 << (pos % 64));
+            }
+            if (pilot == 0xFFFFFFFF) return 0;
+            pilot++;
+        }
+        b->pilots[k] = pilot;
+    }
+    return 1;
+}
+
+
+/** Tries each seed in turn until every key is placed.
+ * @returns 1 on success, 0 if no seed placed every key,
+ * and -1 if two keys have the same mixed hash, so that no other seed is worth trying.
+ */
+static int frozenmap_place_seeds(frozenmap_t* frozen, frozenmap_build_t* b, dast_sz n, dast_sz buckets){
+    int placed = 0;
+    for (dast_u64 s = 0; s != FROZENMAP_MAX_SEEDS; ++s) {
+        frozen->seed = s * FROZENMAP_PILOT_MULTIPLIER;
+        placed = frozenmap_place(frozen, b, n, buckets);
+        if (placed == 1) return 1;
+        /* Seeded hashes of the key bytes differ on the next seed, but stored hashes stay the same */
+        if (placed == -1 && !frozen->hash_keys) return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * ----------------
+ * Public Functions
+ * ----------------
+ */
+
+/** @brief Builds a read-only copy of a map, with the allocator and functions of the map.
+ * @param frozen frozen map to initialise
+ * @param map populated hashmap
+ * @returns the input frozen map on success, and NULL otherwise
+ */
+frozenmap_t* hashmap_freeze(frozenmap_t* frozen, hashmap_t* map){
+    if (!frozen || !map || (!map->table && !map->slots)) return dast_null;
+    *frozen = (frozenmap_t){0};
+    frozen->alloc   = map->alloc;
+    frozen->hash_fn = map->hash_fn;
+    frozen->eq_fn   = map->eq_fn;
+    frozen->value_size   = map->value_size;
+    frozen->value_stride = map->value_size ? ((map->value_size + 7) & ~(dast_sz)7) : sizeof(void*);
+
+    dast_sz n = map->entries;
+    if (n == 0) return frozen;
+    if (n > FROZENMAP_MAX_ENTRIES) return dast_null;
+
+    dast_allocator_t* alloc = &map->alloc;
+    dast_sz buckets = (n + FROZENMAP_BUCKET_KEYS - 1) / FROZENMAP_BUCKET_KEYS;
+    dast_sz key_bytes = 0;
+    frozenmap_build_t b = {0};
+
+    b.keys         = alloc->alloc(n * sizeof(frozenmap_key_t));
+    b.bucket_start = alloc->alloc((buckets + 1) * sizeof(dast_sz));
+    b.order        = alloc->alloc(n * sizeof(dast_sz));
+    b.by_size      = alloc->alloc(buckets * sizeof(dast_sz));
+    b.slot_key     = alloc->alloc((n + 2) * sizeof(dast_sz));
+    b.taken        = alloc->alloc(((n + 63) / 64) * sizeof(dast_u64));
+    b.pilots       = alloc->alloc(buckets * sizeof(dast_u32));
+    if (!b.keys || !b.bucket_start || !b.order || !b.by_size || !b.slot_key || !b.taken || !b.pilots) {
+        frozenmap_build_free(&b, alloc);
+        return dast_null;
+    }
+
+    /* Entries keep the hash of their key, so no key is hashed again */
+    {
+        hashmap_cursor_t cursor = {0};
+        dast_sz i = 0;
+        while (hashmap_cursor_next(map, &cursor)) {
+            b.keys[i++].entry = cursor.entry;
+            key_bytes += cursor.len;
+        }
+    }
+    if (key_bytes > 0xFFFFFFFF) {
+        frozenmap_build_free(&b, alloc);
+        return dast_null;
+    }
+
+    int placed = frozenmap_place_seeds(frozen, &b, n, buckets);
+    if (placed == -1 && frozen->eq_fn == dast_memeq) {
+        /* Keys with the same hash cannot be placed apart by it, so place every key by a hash of its bytes.
+           Only possible if keys are equal when their bytes are, which holds for the default equality function */
+        frozen->hash_keys = dast_true;
+        placed = frozenmap_place_seeds(frozen, &b, n, buckets);
+    }
+    if (placed != 1) {
+        frozenmap_build_free(&b, alloc);
+        return dast_null;
+    }
+
+    /* Values come first, as they need the strictest alignment, then offsets, pilots, fingerprints and keys */
+    dast_sz values_bytes  = n * frozen->value_stride;
+    dast_sz offsets_bytes = (n + 1) * sizeof(dast_u32);
+    dast_sz pilots_bytes  = buckets * sizeof(dast_u32);
+    frozen->bytes = values_bytes + offsets_bytes + pilots_bytes + n + key_bytes;
+    char* block = alloc->alloc(frozen->bytes);
+    if (!block) {
+        frozenmap_build_free(&b, alloc);
+        return dast_null;
+    }
+
+    frozen->entries     = n;
+    frozen->buckets     = buckets;
+    frozen->values      = block;
+    frozen->key_offsets = (dast_u32*)(block + values_bytes);
+    frozen->pilots      = (dast_u32*)(block + values_bytes + offsets_bytes);
+    frozen->fingerprints = (dast_u8*)(block + values_bytes + offsets_bytes + pilots_bytes);
+    frozen->keys        = block + values_bytes + offsets_bytes + pilots_bytes + n;
+    dast_memcpy(frozen->pilots, b.pilots, pilots_bytes);
+
+    dast_u32 offset = 0;
+    for (dast_sz i = 0; i != n; ++i) {
+        frozenmap_key_t* key = b.keys + b.slot_key[i];
+        hashmap_entry_t* entry = key->entry;
+        frozen->fingerprints[i] = FROZENMAP_FINGERPRINT(key->mixed);
+        frozen->key_offsets[i] = offset;
+        dast_memcpy(frozen->keys + offset, entry->key, entry->len);
+        offset += (dast_u32)entry->len;
+
+        void* value = (char*)frozen->values + i * frozen->value_stride;
+        if (frozen->value_size) dast_memcpy(value, entry->value, frozen->value_size);
+        else                    *(void**)value = entry->value;
+    }
+    frozen->key_offsets[n] = offset;
+
+    frozenmap_build_free(&b, alloc);
+    return frozen;
+}
+
+/** @brief Frees a frozen map. It does not free the values pointed to.
+ * @param frozen frozen map
+ */
+void frozenmap_uninit(frozenmap_t* frozen){
+    if (!frozen) return;
+    if (frozen->values) frozen->alloc.free(frozen->values); /* Start of the single allocation */
+    *frozen = (frozenmap_t){0};
+}
+
+/** @brief Returns the number of keys of a frozen map.
+ * @param frozen frozen map
+ * @returns the number of keys
+ */
+dast_sz frozenmap_count(frozenmap_t* frozen){
+    if (!frozen) return 0;
+    return frozen->entries;
+}
+
+/** @brief Checks if a frozen map has a given key
+ * @param frozen frozen map
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if the key is in the map, and `dast_false` otherwise
+ */
+dast_bool frozenmap_has_keyb(frozenmap_t* frozen, const void* bkey, dast_sz key_len){
+    if (!frozen || !bkey || !frozen->entries) return dast_false;
+    return frozenmap_find(frozen, bkey, key_len) != frozen->entries;
+}
+
+/** @brief Checks if a frozen map has a given string key
+ * @param frozen frozen map
+ * @param key string key
+ * @returns `dast_true` if the key is in the map, and `dast_false` otherwise
+ */
+dast_bool frozenmap_has_key(frozenmap_t* frozen, string_t key){
+    if (!key.str) return dast_false;
+    return frozenmap_has_keyb(frozen, key.str, key.len + 1); /* Include null-terminating char */
+}
+
+/** @brief Retrieves the data associated with a key.
+ * @param frozen frozen map
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @returns the value of the key, or NULL if the key does not exist
+ */
+void* frozenmap_getb(frozenmap_t* frozen, const void* bkey, dast_sz key_len){
+    if (!frozen || !bkey || !frozen->entries) return dast_null;
+    dast_sz i = frozenmap_find(frozen, bkey, key_len);
+    if (i == frozen->entries) return dast_null;
+    void* value = (char*)frozen->values + i * frozen->value_stride;
+    return frozen->value_size ? value : *(void**)value;
+}
+
+/** @brief Retrieves the data associated with a string key.
+ * @param frozen frozen map
+ * @param key string key
+ * @returns the value of the key, or NULL if the key does not exist
+ */
+void* frozenmap_get(frozenmap_t* frozen, string_t key){
+    if (!key.str) return dast_null;
+    return frozenmap_getb(frozen, key.str, key.len + 1); /* Include null-terminating char */
+}
+
+/** @brief Returns the key and value of a slot.
+ * @param frozen frozen map
+ * @param slot slot index
+ * @param key_len if not NULL, set to the number of bytes in the key
+ * @param value if not NULL, set to the value of the key
+ * @returns the key of the slot, or NULL if the slot is out of range
+ */
+const char* frozenmap_slot(frozenmap_t* frozen, dast_sz slot, dast_sz* key_len, void** value){
+    if (!frozen || slot >= frozen->entries) return dast_null;
+    if (key_len) *key_len = frozen->key_offsets[slot + 1] - frozen->key_offsets[slot];
+    if (value) {
+        void* v = (char*)frozen->values + slot * frozen->value_stride;
+        *value = frozen->value_size ? v : *(void**)v;
+    }
+    return frozen->keys + frozen->key_offsets[slot];
+}
@@ -0,0 +1,449 @@
+#if defined(__unix__)
+    #define _POSIX_C_SOURCE 200112L /* fstat, mmap */
+#endif
+
+#include "hashimage.h"
+
+/* Image files are memory-mapped where the system allows it, and otherwise read into memory */
+#if !defined(DAST_NO_STDLIB)
+    #if defined(__unix__) || defined(__APPLE__)
+        #include <fcntl.h>
+        #include <unistd.h>
+        #include <sys/mman.h>
+        #include <sys/stat.h>
+        #define HASHIMAGE_MMAP_POSIX
+    #elif defined(_WIN32)
+        #define WIN32_LEAN_AND_MEAN
+        #include <windows.h>
+        #define HASHIMAGE_MMAP_WIN32
+    #endif
+#endif
+
+
+#define HASHIMAGE_FIBONACCI_MULTIPLIER ((dast_u64)0x9E3779B97F4A7C15)
+
+/** Images keep `slots * NUM >= entries * DEN` */
+#define HASHIMAGE_MAX_LOAD_NUM 3
+#define HASHIMAGE_MAX_LOAD_DEN 4
+
+/** Bytes gathered before each write to a file */
+#define HASHIMAGE_WRITE_BUFFER (1 << 16)
+
+/** Rounds a number of bytes up to a multiple of 8 */
+#define HASHIMAGE_ALIGN(N) (((N) + 7) & ~(dast_u64)7)
+
+
+/*
+ * ----------------
+ * Static Functions
+ * ----------------
+ */
+
+
+/** Destination of the bytes of an image being written */
+typedef struct hashimage_sink {
+    dast_u8* buf;  /**< Buffer to copy the image into, or to stage writes to `file` in */
+    dast_sz  cap;  /**< Bytes in `buf` */
+    dast_sz  used; /**< Bytes of `buf` taken */
+    dast_sz  len;  /**< Bytes written so far */
+#ifndef DAST_NO_STDLIB
+    FILE*    file; /**< File to write the image to, or NULL */
+#endif
+} hashimage_sink_t;
+
+#ifndef DAST_NO_STDLIB
+/** Writes the staged bytes of an image to its file */
+static dast_bool hashimage_flush(hashimage_sink_t* sink){
+    dast_bool ok = fwrite(sink->buf, 1, sink->used, sink->file) == sink->used;
+    sink->used = 0;
+    return ok;
+}
+#endif
+
+/** Appends bytes to an image */
+static dast_bool hashimage_put(hashimage_sink_t* sink, const void* data, dast_sz len){
+    if (!len) return dast_true;
+#ifndef DAST_NO_STDLIB
+    if (sink->file && len > sink->cap - sink->used) {
+        if (!hashimage_flush(sink)) return dast_false;
+        if (len >= sink->cap) {
+            sink->len += len;
+            return fwrite(data, 1, len, sink->file) == len;
+        }
+    }
+#endif
+    if (len > sink->cap - sink->used) return dast_false;
+    dast_memcpy(sink->buf + sink->used, data, len);
+    sink->used += len;
+    sink->len  += len;
+    return dast_true;
+}
+
+/** Pads an image to a multiple of 8 bytes */
+static dast_bool hashimage_pad(hashimage_sink_t* sink){
+    static const dast_u8 zeros[8] = {0};
+    return hashimage_put(sink, zeros, (dast_sz)(HASHIMAGE_ALIGN((dast_u64)sink->len) - sink->len));
+}
+
+/** Returns the number of bytes of the data a value points to */
+static dast_u64 hashimage_value_len(hashmap_t* map, hashimage_sizefn_t size_fn, const void* value){
+    if (!value) return 0;
+    if (size_fn) return (dast_u64)size_fn(value);
+    return (dast_u64)map->value_size; /* Values stored inside the map */
+}
+
+/** Returns the home slot of a hash in a table of `1 << (64 - shift)` slots */
+static dast_sz hashimage_slot(dast_u64 hash, dast_u32 shift){
+    return (dast_sz)((hash * HASHIMAGE_FIBONACCI_MULTIPLIER) >> shift);
+}
+
+/** Fills in the header of the image of a map, and returns `dast_false` if a key or value is too long */
+static dast_bool hashimage_layout(hashmap_t* map, hashimage_sizefn_t size_fn, hashimage_header_t* header, dast_u32* shift){
+    *header = (hashimage_header_t){0};
+    dast_memcpy(header->magic, HASHIMAGE_MAGIC, sizeof(header->magic));
+    header->version    = HASHIMAGE_VERSION;
+    header->byte_order = HASHIMAGE_BYTE_ORDER;
+    header->hash_check = map->hash_fn(HASHIMAGE_MAGIC, sizeof(header->magic));
+    header->entries    = map->entries;
+
+    /* Keep at least one slot in four empty, so that probes stay short */
+    header->slots = 2;
+    *shift = 63;
+    while (header->slots * HASHIMAGE_MAX_LOAD_NUM < header->entries * HASHIMAGE_MAX_LOAD_DEN) {
+        header->slots <<= 1;
+        (*shift)--;
+    }
+
+    header->records_offset = sizeof(hashimage_header_t);
+    header->size = header->records_offset + header->slots * sizeof(hashimage_record_t);
+
+    hashmap_cursor_t cursor = {0};
+    while (hashmap_cursor_next(map, &cursor)) {
+        dast_u64 value_len = hashimage_value_len(map, size_fn, cursor.value);
+        if ((dast_u64)cursor.len > 0xFFFFFFFFu || value_len > 0xFFFFFFFFu) return dast_false;
+        header->size += HASHIMAGE_ALIGN((dast_u64)cursor.len) + HASHIMAGE_ALIGN(value_len);
+    }
+    return dast_true;
+}
+
+/** Writes the image of a map: the table of records, and then the keys and values in the same order */
+static dast_bool hashimage_emit(hashmap_t* map, hashimage_sizefn_t size_fn, hashimage_sink_t* sink){
+    if (!map || (!map->table && !map->slots)) return dast_false;
+
+    hashimage_header_t header;
+    dast_u32 shift;
+    if (!hashimage_layout(map, size_fn, &header, &shift)) return dast_false;
+    if (header.size != (dast_u64)(dast_sz)header.size) return dast_false;
+
+    /* Place every entry with linear probing */
+    dast_sz slots = (dast_sz)header.slots;
+    hashmap_entry_t** table = map->alloc.alloc(slots * sizeof(hashmap_entry_t*));
+    if (!table) return dast_false;
+    dast_memset(table, 0, slots * sizeof(hashmap_entry_t*));
+
+    hashmap_cursor_t cursor = {0};
+    while (hashmap_cursor_next(map, &cursor)) {
+        dast_sz i = hashimage_slot(cursor.entry->hash, shift);
+        while (table[i]) i = (i + 1) & (slots - 1);
+        table[i] = cursor.entry;
+    }
+
+    dast_bool ok = hashimage_put(sink, &header, sizeof(header));
+
+    dast_u64 offset = header.records_offset + header.slots * sizeof(hashimage_record_t);
+    for (dast_sz i = 0; ok && i != slots; ++i) {
+        hashimage_record_t record = {0};
+        if (table[i]) {
+            record.hash      = table[i]->hash;
+            record.offset    = offset;
+            record.key_len   = (dast_u32)table[i]->len;
+            record.value_len = (dast_u32)hashimage_value_len(map, size_fn, table[i]->value);
+            offset += HASHIMAGE_ALIGN((dast_u64)record.key_len) + HASHIMAGE_ALIGN((dast_u64)record.value_len);
+        }
+        ok = hashimage_put(sink, &record, sizeof(record));
+    }
+
+    for (dast_sz i = 0; ok && i != slots; ++i) {
+        if (!table[i]) continue;
+        dast_sz value_len = (dast_sz)hashimage_value_len(map, size_fn, table[i]->value);
+        ok = hashimage_put(sink, table[i]->key, table[i]->len) && hashimage_pad(sink)
+          && hashimage_put(sink, table[i]->value, value_len) && hashimage_pad(sink);
+    }
+
+    map->alloc.free(table);
+    return ok && (dast_u64)sink->len == header.size;
+}
+
+/** Returns the record of a key, or NULL if it is not in the image */
+static const hashimage_record_t* hashimage_find(hashimage_t* image, const void* bkey, dast_sz key_len){
+    if (!image || !image->data || !bkey) return dast_null;
+
+    dast_u64 hash = image->hash_fn(bkey, key_len);
+    dast_sz mask = image->slots - 1;
+    dast_sz i = hashimage_slot(hash, image->shift);
+
+    /* Bounded, in case a damaged image has no empty slot */
+    for (dast_sz probes = 0; probes != image->slots; ++probes, i = (i + 1) & mask) {
+        const hashimage_record_t* record = &image->records[i];
+        if (!record->offset) return dast_null;
+        if (record->hash != hash || record->key_len != key_len) continue;
+        /* Bounds are checked here rather than on open, so opening reads no records */
+        if (record->offset > image->size || image->size - record->offset < key_len) return dast_null;
+        if (image->eq_fn(image->data + record->offset, bkey, key_len)) return record;
+    }
+    return dast_null;
+}
+
+
+/*
+ * ----------------
+ * Public Functions
+ * ----------------
+ */
+
+
+/** @brief Computes the number of bytes of the image of a map.
+ * @param map hashmap
+ * @param size_fn Number of bytes each value points to, or NULL
+ * @returns the size of the image, or zero on failure
+ */
+dast_sz hashimage_size(hashmap_t* map, hashimage_sizefn_t size_fn){
+    if (!map || (!map->table && !map->slots)) return 0;
+    hashimage_header_t header;
+    dast_u32 shift;
+    if (!hashimage_layout(map, size_fn, &header, &shift)) return 0;
+    if (header.size != (dast_u64)(dast_sz)header.size) return 0;
+    return (dast_sz)header.size;
+}
+
+/** @brief Writes the image of a map into a buffer.
+ * @param map hashmap
+ * @param size_fn Number of bytes each value points to, or NULL
+ * @param buf buffer
+ * @param cap number of bytes in the buffer
+ * @returns the number of bytes written, or zero on failure
+ */
+dast_sz hashimage_write(hashmap_t* map, hashimage_sizefn_t size_fn, void* buf, dast_sz cap){
+    if (!buf) return 0;
+    hashimage_sink_t sink = { .buf = buf, .cap = cap };
+    return hashimage_emit(map, size_fn, &sink) ? sink.len : 0;
+}
+
+/** @brief Opens an image held in memory.
+ * @param image view to initialise
+ * @param data image, aligned to 8 bytes
+ * @param size number of bytes of the image
+ * @param hash_fn Hash function the map was built with, or NULL
+ * @param eq_fn Key equality function, or NULL
+ * @returns the input view on success, and NULL otherwise
+ */
+hashimage_t* hashimage_open(hashimage_t* image, const void* data, dast_sz size, hashmap_hashfn_t hash_fn, hashmap_eqfn_t eq_fn){
+    if (!image) return dast_null;
+    *image = (hashimage_t){0};
+    if (!data || size < sizeof(hashimage_header_t) || ((dast_sz)data & 7)) return dast_null;
+
+    image->hash_fn = hash_fn ? hash_fn : HASHMAP_DEFAULT_HASH;
+    image->eq_fn   = eq_fn   ? eq_fn   : dast_memeq;
+
+    const hashimage_header_t* header = data;
+    if (!dast_memeq(header->magic, HASHIMAGE_MAGIC, sizeof(header->magic))) return dast_null;
+    if (header->version != HASHIMAGE_VERSION || header->byte_order != HASHIMAGE_BYTE_ORDER) return dast_null;
+    if (header->hash_check != image->hash_fn(HASHIMAGE_MAGIC, sizeof(header->magic))) return dast_null;
+    if (header->size != (dast_u64)size) return dast_null;
+
+    /* The records must lie within the image */
+    if (header->slots < 2 || (header->slots & (header->slots - 1))) return dast_null;
+    if (header->entries >= header->slots) return dast_null;
+    if ((header->records_offset & 7) || header->records_offset > size) return dast_null;
+    if (header->slots > (size - header->records_offset) / sizeof(hashimage_record_t)) return dast_null;
+
+    image->data    = data;
+    image->size    = size;
+    image->records = (const hashimage_record_t*)(image->data + header->records_offset);
+    image->entries = (dast_sz)header->entries;
+    image->slots   = (dast_sz)header->slots;
+    image->shift   = 64;
+    for (dast_u64 b = header->slots; b > 1; b >>= 1) image->shift--;
+    return image;
+}
+
+#ifndef DAST_NO_STDLIB
+
+/** @brief Saves the image of a map to a file.
+ * @param map hashmap
+ * @param size_fn Number of bytes each value points to, or NULL
+ * @param path path of the file
+ * @returns `dast_true` on success, and `dast_false` otherwise
+ */
+dast_bool hashimage_save(hashmap_t* map, hashimage_sizefn_t size_fn, const char* path){
+    if (!path) return dast_false;
+    FILE* file = fopen(path, "wb");
+    if (!file) return dast_false;
+
+    hashimage_sink_t sink = { .cap = HASHIMAGE_WRITE_BUFFER, .file = file };
+    sink.buf = (map && map->alloc.alloc) ? map->alloc.alloc(sink.cap) : dast_null;
+    dast_bool ok = sink.buf && hashimage_emit(map, size_fn, &sink) && hashimage_flush(&sink);
+    if (sink.buf) map->alloc.free(sink.buf);
+    if (fclose(file) != 0) ok = dast_false;
+    if (!ok) remove(path);
+    return ok;
+}
+
+/** @brief Opens an image file by mapping it read-only into memory.
+ * @param image view to initialise
+ * @param path path of the file
+ * @param hash_fn Hash function the map was built with, or NULL
+ * @param eq_fn Key equality function, or NULL
+ * @returns the input view on success, and NULL otherwise
+ */
+hashimage_t* hashimage_map(hashimage_t* image, const char* path, hashmap_hashfn_t hash_fn, hashmap_eqfn_t eq_fn){
+    if (!image) return dast_null;
+    *image = (hashimage_t){0};
+    if (!path) return dast_null;
+
+#if defined(HASHIMAGE_MMAP_POSIX)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return dast_null;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(hashimage_header_t)) {
+        close(fd);
+        return dast_null;
+    }
+    dast_sz size = (dast_sz)st.st_size;
+    void* data = mmap(dast_null, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); /* The mapping keeps the file open */
+    if (data == MAP_FAILED) return dast_null;
+
+    if (!hashimage_open(image, data, size, hash_fn, eq_fn)) {
+        munmap(data, size);
+        return dast_null;
+    }
+
+#elif defined(HASHIMAGE_MMAP_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, dast_null, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, dast_null);
+    if (file == INVALID_HANDLE_VALUE) return dast_null;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < (LONGLONG)sizeof(hashimage_header_t)) {
+        CloseHandle(file);
+        return dast_null;
+    }
+    dast_sz size = (dast_sz)file_size.QuadPart;
+    HANDLE mapping = CreateFileMappingA(file, dast_null, PAGE_READONLY, 0, 0, dast_null);
+    CloseHandle(file); /* The mapping keeps the file open */
+    if (!mapping) return dast_null;
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        return dast_null;
+    }
+
+    if (!hashimage_open(image, data, size, hash_fn, eq_fn)) {
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        return dast_null;
+    }
+    image->handle = mapping;
+
+#else
+    FILE* file = fopen(path, "rb");
+    if (!file) return dast_null;
+    long size = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+    void* data = (size > 0) ? malloc((dast_sz)size) : dast_null;
+    dast_bool ok = data && fseek(file, 0, SEEK_SET) == 0 && fread(data, 1, (dast_sz)size, file) == (dast_sz)size;
+    fclose(file);
+
+    if (!ok || !hashimage_open(image, data, (dast_sz)size, hash_fn, eq_fn)) {
+        free(data);
+        return dast_null;
+    }
+#endif
+
+    image->mapped = dast_true;
+    return image;
+}
+
+#endif /* DAST_NO_STDLIB */
+
+/** @brief Closes a view, unmapping the file if it was opened with `hashimage_map`.
+ * @param image view
+ */
+void hashimage_close(hashimage_t* image){
+    if (!image) return;
+#if defined(HASHIMAGE_MMAP_POSIX)
+    if (image->mapped) munmap((void*)image->data, image->size);
+#elif defined(HASHIMAGE_MMAP_WIN32)
+    if (image->mapped) {
+        UnmapViewOfFile(image->data);
+        CloseHandle(image->handle);
+    }
+#elif !defined(DAST_NO_STDLIB)
+    if (image->mapped) free((void*)image->data);
+#endif
+    *image = (hashimage_t){0};
+}
+
+/** @brief Returns the number of keys of an image.
+ * @param image view
+ * @returns the number of keys
+ */
+dast_sz hashimage_count(hashimage_t* image){
+    return image ? image->entries : 0;
+}
+
+/** @brief Checks if an image has a given key
+ * @param image view
+ * @param bkey key to find, can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if key exists in the image, and `dast_false` otherwise
+ */
+dast_bool hashimage_has_keyb(hashimage_t* image, const void* bkey, dast_sz key_len){
+    return hashimage_find(image, bkey, key_len) != dast_null;
+}
+
+/** @brief Checks if an image has a given string key
+ * @param image view
+ * @param key string key
+ * @returns `dast_true` if key exists in the image, and `dast_false` otherwise
+ */
+dast_bool hashimage_has_key(hashimage_t* image, string_t key){
+    if (!key.str) return dast_false;
+    return hashimage_has_keyb(image, key.str, key.len + 1); /* Include null-terminating char */
+}
+
+/** @brief Retrieves the data associated with a key, and its size.
+ * @param image view
+ * @param bkey key to search for, which can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @param value_len if not NULL, set to the number of bytes of the value
+ * @returns the value of the key within the image, or NULL if the key does not exist
+ */
+const void* hashimage_getb_sized(hashimage_t* image, const void* bkey, dast_sz key_len, dast_sz* value_len){
+    if (value_len) *value_len = 0;
+    const hashimage_record_t* record = hashimage_find(image, bkey, key_len);
+    if (!record || !record->value_len) return dast_null;
+
+    dast_u64 offset = record->offset + HASHIMAGE_ALIGN((dast_u64)record->key_len);
+    if (offset > image->size || image->size - offset < record->value_len) return dast_null;
+    if (value_len) *value_len = record->value_len;
+    return image->data + offset;
+}
+
+/** @brief Retrieves the data associated with a key.
+ * @param image view
+ * @param bkey key to search for, which can be any set of bytes
+ * @param key_len number of bytes in the key
+ * @returns the value of the key within the image, or NULL if the key does not exist
+ */
+const void* hashimage_getb(hashimage_t* image, const void* bkey, dast_sz key_len){
+    return hashimage_getb_sized(image, bkey, key_len, dast_null);
+}
+
+/** @brief Retrieves the data associated with a string key.
+ * @param image view
+ * @param key string key
+ * @returns the value of the key within the image, or NULL if the key does not exist
+ */
+const void* hashimage_get(hashimage_t* image, string_t key){
+    if (!key.str) return dast_null;
+    return hashimage_getb(image, key.str, key.len + 1); /* Include null-terminating char */
+}
@@ -1,10 +1,42 @@
 
 #include "hashmap.h"
+#include "hashmap_ctrl.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_MSC_VER)
+    #include <intrin.h> /* _umul128 */
+#endif
+
+/* Parallel resizes and bulk loads need threads and atomic exchanges, and otherwise run on the calling thread */
+#if !defined(DAST_NO_STDLIB) && defined(DAST_ATOMICS)
+    #if defined(__unix__) || defined(__APPLE__)
+        #include <pthread.h>
+        #define HASHMAP_THREADS_POSIX
+    #elif defined(_WIN32)
+        #define WIN32_LEAN_AND_MEAN
+        #include <windows.h>
+        #define HASHMAP_THREADS_WIN32
+    #endif
+#endif
+
+/* Lookup counters are only updated with `DAST_STATS`, and atomically where possible,
+   as several threads may look up keys in the same map */
+#if defined(DAST_STATS) && defined(DAST_ATOMICS)
+    #define HASHMAP_COUNT(MAP, FIELD, N) ((void)DAST_ATOMIC_FETCH_ADD(&(MAP)->counters.FIELD, (dast_sz)(N)))
+#elif defined(DAST_STATS)
+    #define HASHMAP_COUNT(MAP, FIELD, N) ((void)((MAP)->counters.FIELD += (dast_sz)(N)))
+#else
+    #define HASHMAP_COUNT(MAP, FIELD, N) ((void)0)
+#endif
+
+/* Hardware CRC32-C is used when the CPU supports SSE4.2, checked at runtime */
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    #define HASHMAP_CRC32C_HW
+#endif
+
 
 /* 
  * ----------------
@@ -28,105 +60,1228 @@ static dast_u64 hashmap_isprime(dast_u64 n) {
     return 1;
 }
 
-/** Returns the next prime number larger than the given number `n` */
-static dast_u64 hashmap_next_prime(dast_u64 n){
-    if(n<=1) return 2;
-    while(!hashmap_isprime(++n));
-    return n;
-}
+/** Returns the next prime number larger than the given number `n` */
+static dast_u64 hashmap_next_prime(dast_u64 n){
+    if(n<=1) return 2;
+    while(!hashmap_isprime(++n));
+    return n;
+}
+
+
+/** Reads 4 unaligned bytes as a little-endian integer */
+static dast_u64 hashmap_read32(const dast_u8* p){
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    dast_u32 v;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return v;
+#else
+    return (dast_u64)p[0] | ((dast_u64)p[1] << 8) | ((dast_u64)p[2] << 16) | ((dast_u64)p[3] << 24);
+#endif
+}
+
+/** 2^64 (or 2^32 with 32-bit hashes) divided by the golden ratio, used to spread hashes over power-of-two tables */
+#ifdef DAST_HASH_64BIT
+    #define HASHMAP_FIBONACCI_MULTIPLIER ((dast_u64)0x9E3779B97F4A7C15)
+    #define HASHMAP_HASH_BITS 64
+#else
+    #define HASHMAP_FIBONACCI_MULTIPLIER ((dast_u32)0x9E3779B9)
+    #define HASHMAP_HASH_BITS 32
+#endif
+
+/** Returns the number of buckets to allocate for a requested size, following the sizing policy of a map */
+static dast_sz hashmap_table_size(hashmap_t* map, dast_sz n){
+    if (map->sizing == HASHMAP_SIZING_POW2) {
+        dast_sz size = 2;
+        while (size < n) size <<= 1;
+        return size;
+    }
+    return (dast_sz)hashmap_next_prime(n);
+}
+
+/** Returns the bucket where keys with the given hash are stored, in a table of `size` buckets.
+ * Prime-sized tables take the modulo of the hash, whereas power-of-two tables
+ * keep the top bits of the hash multiplied by the golden ratio (Fibonacci hashing). */
+static dast_sz hashmap_bucket_in(hashmap_t* map, dast_hash_t hash, dast_sz size){
+    if (map->sizing == HASHMAP_SIZING_POW2) {
+        return (dast_sz)((dast_hash_t)(hash * HASHMAP_FIBONACCI_MULTIPLIER) >> (HASHMAP_HASH_BITS - hashmap_ctz64(size)));
+    }
+    /* 32-bit hashes take a 32-bit division, as tables then have fewer than 2^32 buckets */
+    return (dast_sz)(hash % (dast_hash_t)size);
+}
+
+/** Returns the bucket of a chained map where keys with the given hash are stored */
+static dast_sz hashmap_bucket(hashmap_t* map, dast_hash_t hash){
+    return hashmap_bucket_in(map, hash, map->size);
+}
+
+/** Chunk of the key arena, holding keys back to back */
+typedef struct hashmap_arena_chunk {
+    struct hashmap_arena_chunk* next;
+    dast_sz size;
+    char    data[];
+} hashmap_arena_chunk_t;
+
+/** Allocates a chunk of the key arena able to hold `size` bytes */
+static hashmap_arena_chunk_t* hashmap_arena_chunk_alloc(hashmap_t* map, dast_sz size){
+    hashmap_arena_chunk_t* chunk = map->alloc.alloc(sizeof(hashmap_arena_chunk_t) + size);
+    if (chunk) chunk->size = size;
+    return chunk;
+}
+
+/** Reserves `len` bytes at the end of the key arena */
+static char* hashmap_arena_alloc(hashmap_t* map, dast_sz len){
+    hashmap_arena_t* arena = &map->arena;
+    hashmap_arena_chunk_t* head = arena->chunks;
+
+    if (head && head->size - arena->used >= len) {
+        char* key = head->data + arena->used;
+        arena->used += len;
+        return key;
+    }
+
+    hashmap_arena_chunk_t* chunk = hashmap_arena_chunk_alloc(map, len > arena->chunk_size ? len : arena->chunk_size);
+    if (!chunk) return dast_null;
+
+    if (head && len > arena->chunk_size) {
+        /* Oversized keys get a chunk of their own, behind the one being filled */
+        chunk->next = head->next;
+        head->next  = chunk;
+    } else {
+        chunk->next   = head;
+        arena->chunks = chunk;
+        arena->used   = len;
+    }
+    return chunk->data;
+}
+
+/** Makes sure the key arena can take `len` more bytes without allocating again */
+static hashmap_t* hashmap_arena_reserve(hashmap_t* map, dast_sz len){
+    hashmap_arena_t* arena = &map->arena;
+    if (!arena->chunk_size || !len) return map;
+    if (arena->chunks && arena->chunks->size - arena->used >= len) return map;
+
+    hashmap_arena_chunk_t* chunk = hashmap_arena_chunk_alloc(map, len > arena->chunk_size ? len : arena->chunk_size);
+    if (!chunk) return dast_null;
+    chunk->next   = arena->chunks;
+    arena->chunks = chunk;
+    arena->used   = 0;
+    return map;
+}
+
+/** Frees every chunk of the key arena at once */
+static void hashmap_arena_free(hashmap_t* map){
+    hashmap_arena_chunk_t* chunk = map->arena.chunks;
+    while (chunk) {
+        hashmap_arena_chunk_t* next = chunk->next;
+        map->alloc.free(chunk);
+        chunk = next;
+    }
+    map->arena.chunks = dast_null;
+    map->arena.used = map->arena.live = map->arena.total = 0;
+}
+
+/** Copies a key into an entry, inside the entry itself if it is short enough */
+static char* hashmap_entry_set_key(hashmap_t* map, hashmap_entry_t* entry, const void* bkey, dast_sz key_len){
+    if ((hashmap_len_t)key_len != key_len) return dast_null; /* Too long for a 32-bit length */
+    if (key_len <= HASHMAP_SMALL_KEY_SIZE) {
+        entry->key = entry->small_key;
+    } else if (map->arena.chunk_size) {
+        entry->key = hashmap_arena_alloc(map, key_len);
+        if (!entry->key) return dast_null;
+        map->arena.live  += key_len;
+        map->arena.total += key_len;
+    } else {
+        entry->key = map->alloc.alloc(key_len);
+        if (!entry->key) return dast_null;
+    }
+    dast_memcpy(entry->key, bkey, key_len);
+    entry->len = (hashmap_len_t)key_len;
+    return entry->key;
+}
+
+/** Frees the key of an entry, unless it is stored inside the entry.
+ * Keys in the arena are only accounted for, and reclaimed by `hashmap_compact_keys`. */
+static void hashmap_entry_free_key(hashmap_t* map, hashmap_entry_t* entry){
+    if (entry->key == entry->small_key) return;
+    if (map->arena.chunk_size) map->arena.live -= entry->len;
+    else                       map->alloc.free(entry->key);
+}
+
+/** Compacts the key arena if most of it is taken by removed keys */
+static void hashmap_arena_maybe_compact(hashmap_t* map){
+    if (map->arena.chunk_size && map->arena.total > map->arena.live * 2 + map->arena.chunk_size) {
+        hashmap_compact_keys(map); /* On failure, the keys are left where they were */
+    }
+}
+
+/** Returns entry `i` of an array of entries, which are `map->entry_size` bytes apart */
+static hashmap_entry_t* hashmap_entry_at(hashmap_t* map, hashmap_entry_t* entries, dast_sz i){
+    return (hashmap_entry_t*)((char*)entries + i * map->entry_size);
+}
+
+/** Stores a value in an entry: the pointer itself, or a copy of the `value_size` bytes it points to,
+ * which are zeroed if it is NULL */
+static void hashmap_entry_set_value(hashmap_t* map, hashmap_entry_t* entry, void* value){
+    if (!map->value_size) {
+        entry->value = value;
+        return;
+    }
+    entry->value = entry + 1;
+    if (!value)                     dast_memset(entry->value, 0, map->value_size);
+    else if (value != entry->value) dast_memcpy(entry->value, value, map->value_size);
+}
+
+/** Moves an entry to a different address, pointing its key and value to the new copies if they are stored inline */
+static void hashmap_entry_move(hashmap_t* map, hashmap_entry_t* dest, hashmap_entry_t* src){
+    dast_memcpy(dest, src, map->entry_size);
+    if (src->key == src->small_key) dest->key = dest->small_key;
+    if (map->value_size) dest->value = dest + 1;
+}
+
+/* 
+ * ----------------
+ * Open addressing
+ * ----------------
+ * Slots and control bytes follow `hashmap_ctrl.h`. Slots hold whole entries,
+ * `entry_size` bytes apart so that inline values fit after each entry.
+ */
+
+/** Returns the table of an open-addressing map, as walked by the probe loops of `hashmap_ctrl.h` */
+static hashmap_ctrl_table_t hashmap_open_table(hashmap_t* map){
+    return (hashmap_ctrl_table_t){
+        .ctrl = map->ctrl, .slots = (char*)map->slots, .size = map->size, .stride = map->entry_size,
+        .key_offset  = offsetof(hashmap_entry_t, key),
+        .len_offset  = offsetof(hashmap_entry_t, len),
+        .hash_offset = offsetof(hashmap_entry_t, hash)
+    };
+}
+
+/** Allocates empty control bytes and slots for an open-addressing map of `size` slots */
+static hashmap_t* hashmap_open_alloc(hashmap_t* map, dast_sz size){
+    map->size  = size;
+    map->slots = hashmap_ctrl_alloc(&map->alloc, size, map->entry_size, &map->ctrl);
+    return map->slots ? map : dast_null;
+}
+
+/** Returns the slot index of a key, or `map->size` if it is not in the map */
+static dast_sz hashmap_open_find(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    hashmap_ctrl_table_t table = hashmap_open_table(map);
+    hashmap_ctrl_lookup_t lookup = hashmap_ctrl_find(&table, map->eq_fn, bkey, key_len, hash);
+    HASHMAP_COUNT(map, lookups, 1);
+    HASHMAP_COUNT(map, probes, lookup.probes);
+    HASHMAP_COUNT(map, eq_calls, lookup.eq_calls);
+    return lookup.slot;
+}
+
+/** Moves every entry into a new array of `new_size` slots, dropping DELETED control bytes */
+static hashmap_t* hashmap_open_rehash(hashmap_t* map, dast_sz new_size){
+    hashmap_t new_map = *map;
+    if (!hashmap_open_alloc(&new_map, new_size)) return dast_null;
+    new_map.deleted = 0;
+
+    for (dast_sz i = hashmap_ctrl_next(map->ctrl, map->size, 0); i != map->size; i = hashmap_ctrl_next(map->ctrl, map->size, i + 1)) {
+        hashmap_entry_t* slot = hashmap_entry_at(map, map->slots, i);
+        dast_sz j = hashmap_ctrl_place(new_map.ctrl, new_map.size, slot->hash);
+        hashmap_entry_move(map, hashmap_entry_at(map, new_map.slots, j), slot);
+    }
+
+    map->alloc.free(map->ctrl);
+    map->alloc.free(map->slots);
+    *map = new_map;
+    map->resizes++;
+    hashmap_arena_maybe_compact(map);
+    return map;
+}
+
+/** Doubles the number of slots and moves every entry to its new position */
+static hashmap_t* hashmap_open_grow(hashmap_t* map){
+    return hashmap_open_rehash(map, map->size * 2);
+}
+
+/** Returns the slot of a key in an open-addressing map, inserting the key with a NULL value if it is not in the map */
+static hashmap_entry_t* hashmap_open_upsert(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash, dast_bool* inserted){
+    dast_sz i = hashmap_open_find(map, bkey, key_len, hash);
+
+    *inserted = (i == map->size);
+    if (!*inserted) return hashmap_entry_at(map, map->slots, i);
+
+    dast_sz new_size = hashmap_ctrl_grow_size(map->size, map->entries, map->deleted);
+    if (new_size && !hashmap_open_rehash(map, new_size)) return dast_null;
+
+    i = hashmap_ctrl_find_free(map->ctrl, map->size, hash);
+    hashmap_entry_t* slot = hashmap_entry_at(map, map->slots, i);
+    if (!hashmap_entry_set_key(map, slot, bkey, key_len)) return dast_null;
+    if (map->ctrl[i] == HASHMAP_CTRL_DELETED) map->deleted--;
+    slot->hash  = hash;
+    slot->next  = dast_null;
+    hashmap_entry_set_value(map, slot, dast_null);
+    hashmap_ctrl_set(map->ctrl, map->size, i, HASHMAP_H2(hash));
+    map->entries++;
+    return slot;
+}
+
+/** Removes the slot at index `i` of an open-addressing map */
+static void hashmap_open_remove_at(hashmap_t* map, dast_sz i){
+    hashmap_entry_free_key(map, hashmap_entry_at(map, map->slots, i));
+    if (hashmap_ctrl_erase(map->ctrl, map->size, i)) map->deleted++;
+    map->entries--;
+}
+
+/** Returns the slot index after `i` holding an entry, or `map->size` if there are none left */
+static dast_sz hashmap_open_next(hashmap_t* map, dast_sz i){
+    return hashmap_ctrl_next(map->ctrl, map->size, i);
+}
+
+
+/* 
+ * ----------------
+ * Worker threads
+ * ----------------
+ */
+
+/** Task run by each thread of `hashmap_parallel_for`, given the thread index */
+typedef void (*hashmap_task_t)(void* ctx, dast_sz t);
+
+/** Arguments of a worker thread */
+typedef struct hashmap_worker {
+    hashmap_task_t task;
+    void*          ctx;
+    dast_sz        t;
+} hashmap_worker_t;
+
+#if defined(HASHMAP_THREADS_POSIX)
+static void* hashmap_worker_main(void* arg){
+    hashmap_worker_t* worker = arg;
+    worker->task(worker->ctx, worker->t);
+    return dast_null;
+}
+#elif defined(HASHMAP_THREADS_WIN32)
+static DWORD WINAPI hashmap_worker_main(LPVOID arg){
+    hashmap_worker_t* worker = arg;
+    worker->task(worker->ctx, worker->t);
+    return 0;
+}
+#endif
+
+/** Returns the number of threads to split `work` entries over, following the thread count of a map
+ * and `HASHMAP_PARALLEL_MIN_ENTRIES`. Always one where threads are not available. */
+static dast_sz hashmap_parallel_threads(hashmap_t* map, dast_sz work){
+#if defined(HASHMAP_THREADS_POSIX) || defined(HASHMAP_THREADS_WIN32)
+    dast_sz threads = work / HASHMAP_PARALLEL_MIN_ENTRIES;
+    if (threads > map->threads) threads = map->threads;
+    return threads ? threads : 1;
+#else
+    (void)map, (void)work;
+    return 1;
+#endif
+}
+
+/** Runs `task` for every thread index below `threads`, at once, and waits for all of them.
+ * Index zero runs on the calling thread, as does any index whose thread cannot be started. */
+static void hashmap_parallel_for(dast_sz threads, hashmap_task_t task, void* ctx){
+#if defined(HASHMAP_THREADS_POSIX) || defined(HASHMAP_THREADS_WIN32)
+    hashmap_worker_t workers[HASHMAP_MAX_THREADS];
+    dast_bool started[HASHMAP_MAX_THREADS];
+    #if defined(HASHMAP_THREADS_POSIX)
+    pthread_t ids[HASHMAP_MAX_THREADS];
+    #else
+    HANDLE ids[HASHMAP_MAX_THREADS];
+    #endif
+
+    for (dast_sz t = 1; t < threads; ++t) {
+        workers[t] = (hashmap_worker_t){ task, ctx, t };
+    #if defined(HASHMAP_THREADS_POSIX)
+        started[t] = pthread_create(&ids[t], dast_null, hashmap_worker_main, &workers[t]) == 0;
+    #else
+        ids[t] = CreateThread(dast_null, 0, hashmap_worker_main, &workers[t], 0, dast_null);
+        started[t] = ids[t] != dast_null;
+    #endif
+        if (!started[t]) task(ctx, t);
+    }
+    task(ctx, 0);
+    for (dast_sz t = 1; t < threads; ++t) {
+        if (!started[t]) continue;
+    #if defined(HASHMAP_THREADS_POSIX)
+        pthread_join(ids[t], dast_null);
+    #else
+        WaitForSingleObject(ids[t], INFINITE);
+        CloseHandle(ids[t]);
+    #endif
+    }
+#else
+    for (dast_sz t = 0; t < threads; ++t) task(ctx, t);
+#endif
+}
+
+/** Returns the first item of part `t` when `n` items are split into `parts` contiguous parts */
+static dast_sz hashmap_part_start(dast_sz n, dast_sz parts, dast_sz t){
+    return (dast_sz)((dast_u64)n * t / parts);
+}
+
+
+/* 
+ * ----------------
+ * Chaining
+ * ----------------
+ */
+
+/** Slab of entries handed out by the entry pool of a chained map. Entries are `map->entry_size` bytes apart */
+typedef struct hashmap_slab {
+    struct hashmap_slab* next;
+    dast_sz              capacity;
+    hashmap_entry_t      entries[];
+} hashmap_slab_t;
+
+/** Adds a slab of `capacity` entries to the entry pool, to be filled next */
+static hashmap_slab_t* hashmap_pool_add_slab(hashmap_t* map, dast_sz capacity){
+    hashmap_slab_t* slab = map->alloc.alloc(sizeof(hashmap_slab_t) + capacity * map->entry_size);
+    if (!slab) return dast_null;
+    slab->capacity  = capacity;
+    slab->next      = map->pool.slabs;
+    map->pool.slabs = slab;
+    map->pool.used  = 0;
+    return slab;
+}
+
+/** Makes sure the entry pool can hand out `n` entries without allocating again */
+static hashmap_t* hashmap_pool_reserve(hashmap_t* map, dast_sz n){
+    hashmap_pool_t* pool = &map->pool;
+    if (!pool->slab_entries) return map;
+    if (pool->slabs && pool->slabs->capacity - pool->used >= n) return map;
+    return hashmap_pool_add_slab(map, n > pool->slab_entries ? n : pool->slab_entries) ? map : dast_null;
+}
+
+/** Allocates a chained entry, from the entry pool if the map has one */
+static hashmap_entry_t* hashmap_entry_alloc(hashmap_t* map){
+    hashmap_pool_t* pool = &map->pool;
+    if (!pool->slab_entries) return map->alloc.alloc(map->entry_size);
+
+    if (pool->free_list) {
+        hashmap_entry_t* entry = pool->free_list;
+        pool->free_list = entry->next;
+        return entry;
+    }
+    if (!pool->slabs || pool->used == pool->slabs->capacity) {
+        if (!hashmap_pool_add_slab(map, pool->slab_entries)) return dast_null;
+    }
+    return hashmap_entry_at(map, pool->slabs->entries, pool->used++);
+}
+
+/** Frees a chained entry, or returns it to the entry pool if the map has one */
+static void hashmap_entry_release(hashmap_t* map, hashmap_entry_t* entry){
+    if (!map->pool.slab_entries) {
+        map->alloc.free(entry);
+        return;
+    }
+    entry->next = map->pool.free_list;
+    map->pool.free_list = entry;
+}
+
+/** Frees every slab of the entry pool at once */
+static void hashmap_pool_free(hashmap_t* map){
+    hashmap_slab_t* slab = map->pool.slabs;
+    while (slab) {
+        hashmap_slab_t* next = slab->next;
+        map->alloc.free(slab);
+        slab = next;
+    }
+    map->pool.slabs = dast_null;
+    map->pool.free_list = dast_null;
+    map->pool.used = 0;
+}
+
+/** Returns the entry of a key in a chain of entries.
+ * Stored hashes are compared first, so that `eq_fn` only runs on likely matches. */
+static hashmap_entry_t* hashmap_chain_search(hashmap_t* map, hashmap_entry_t* entry, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    dast_sz probes = 0, eq_calls = 0;
+    for (; entry; entry = entry->next) {
+        probes++;
+        if (entry->hash == hash && key_len == entry->len && (eq_calls++, map->eq_fn(bkey, entry->key, key_len))) {
+            break;
+        }
+    }
+    HASHMAP_COUNT(map, probes, probes);
+    HASHMAP_COUNT(map, eq_calls, eq_calls);
+    (void)probes, (void)eq_calls;
+    return entry;
+}
+
+/** Returns the entry of a key in the old table of an incremental resize, if it has not been moved yet */
+static hashmap_entry_t* hashmap_chain_find_old(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    if (!map->old_table) return dast_null;
+    dast_sz bucket = hashmap_bucket_in(map, hash, map->old_size);
+    if (bucket < map->migrated) return dast_null;
+    return hashmap_chain_search(map, map->old_table[bucket], bkey, key_len, hash);
+}
+
+/** Returns the entry of a key in a chained map */
+static hashmap_entry_t* hashmap_chain_find(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    HASHMAP_COUNT(map, lookups, 1);
+    hashmap_entry_t* entry = hashmap_chain_search(map, map->table[hashmap_bucket(map, hash)], bkey, key_len, hash);
+    if (!entry) entry = hashmap_chain_find_old(map, bkey, key_len, hash);
+    return entry;
+}
+
+/** Allocates an empty array of buckets */
+static hashmap_entry_t** hashmap_chain_alloc_table(hashmap_t* map, dast_sz size){
+    hashmap_entry_t** table = map->alloc.alloc(size * sizeof(hashmap_entry_t*));
+    if (table) dast_memset(table, 0, size * sizeof(hashmap_entry_t*));
+    return table;
+}
+
+/** Moves up to `buckets` buckets of the old table into the current one,
+ * relinking their entries. The old table is freed once every bucket is moved. */
+static void hashmap_chain_migrate(hashmap_t* map, dast_sz buckets){
+    if (!map->old_table) return;
+
+    dast_sz end = map->old_size - map->migrated > buckets ? map->migrated + buckets : map->old_size;
+    for (; map->migrated != end; map->migrated++) {
+        hashmap_entry_t* entry = map->old_table[map->migrated];
+        while (entry) {
+            hashmap_entry_t* next = entry->next;
+            dast_sz bucket = hashmap_bucket(map, entry->hash);
+            entry->next = map->table[bucket];
+            map->table[bucket] = entry;
+            entry = next;
+        }
+        map->old_table[map->migrated] = dast_null;
+    }
+
+    if (map->migrated == map->old_size) {
+        map->alloc.free(map->old_table);
+        map->old_table = dast_null;
+        map->old_size  = 0;
+        map->migrated  = 0;
+    }
+}
+
+/** Returns the first entry in the buckets from `*i` onwards, either of the current table
+ * followed by the unmoved buckets of the old table, or of the old table alone if `*in_old_table` is set.
+ * On return, `*in_old_table` and `*i` hold the table and bucket where the entry was found. */
+static hashmap_entry_t* hashmap_chain_first(hashmap_t* map, dast_bool* in_old_table, dast_sz* i){
+    if (!*in_old_table) {
+        for (; *i < map->size; ++*i) {
+            if (map->table[*i]) return map->table[*i];
+        }
+        *in_old_table = dast_true;
+        *i = map->migrated;
+    }
+    if (!map->old_table) return dast_null;
+    for (; *i < map->old_size; ++*i) {
+        if (map->old_table[*i]) return map->old_table[*i];
+    }
+    return dast_null;
+}
+
+/** Replaces the table with a larger empty one, whose entries will be moved over by `hashmap_chain_migrate` */
+static hashmap_t* hashmap_chain_begin_rehash(hashmap_t* map, dast_sz new_size){
+    hashmap_chain_migrate(map, map->old_size); /* Finish any previous resize first */
+
+    new_size = hashmap_table_size(map, new_size);
+    hashmap_entry_t** table = hashmap_chain_alloc_table(map, new_size);
+    if (!table) return dast_null;
+
+    map->old_table = map->table;
+    map->old_size  = map->size;
+    map->migrated  = 0;
+    map->table     = table;
+    map->size      = new_size;
+    map->resizes++;
+    return map;
+}
+
+/** Adds an entry to a chained map for a key that is not already in it */
+static hashmap_entry_t* hashmap_chain_insert(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash, void* value){
+    hashmap_entry_t* entry = hashmap_entry_alloc(map);
+    if (!entry) return dast_null;
+
+    if (!hashmap_entry_set_key(map, entry, bkey, key_len)) {
+        hashmap_entry_release(map, entry);
+        return dast_null;
+    }
+
+    dast_sz bucket = hashmap_bucket(map, hash);
+    entry->hash  = hash;
+    entry->next  = map->table[bucket];
+    hashmap_entry_set_value(map, entry, value);
+    map->table[bucket] = entry;
+    map->entries++;
+    return entry;
+}
+
+/** Returns the entry of a key in a chained map, inserting the key with a NULL value if it is not in the map */
+static hashmap_entry_t* hashmap_chain_upsert(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash, dast_bool* inserted){
+    hashmap_chain_migrate(map, map->rehash_budget);
+
+    hashmap_entry_t* entry = hashmap_chain_find(map, bkey, key_len, hash);
+    *inserted = (entry == dast_null);
+    if (entry) return entry;
+
+    entry = hashmap_chain_insert(map, bkey, key_len, hash, dast_null);
+    if (!entry) return dast_null;
+
+    /* Extend if necessary. Entries are relinked, not copied, so `entry` stays valid */
+    if (map->entries * HASHMAP_LOADING_FACTOR >= map->size) {
+        if (map->rehash_budget) hashmap_chain_begin_rehash(map, map->entries * HASHMAP_LOADING_FACTOR * 2);
+        else                    hashmap_resize(map);
+    }
+    return entry;
+}
+
+/** Unlinks the entry of a key from the chain starting at `*link`, and returns it */
+static hashmap_entry_t* hashmap_chain_unlink(hashmap_t* map, hashmap_entry_t** link, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    for (; *link; link = &(*link)->next) {
+        hashmap_entry_t* entry = *link;
+        HASHMAP_COUNT(map, probes, 1);
+        if (entry->hash == hash && entry->len == key_len) {
+            HASHMAP_COUNT(map, eq_calls, 1);
+            if (map->eq_fn(bkey, entry->key, key_len)) {
+                *link = entry->next;
+                return entry;
+            }
+        }
+    }
+    return dast_null;
+}
+
+/** Unlinks the entry of a key from a chained map, looking in both tables during an incremental resize */
+static hashmap_entry_t* hashmap_chain_remove(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    HASHMAP_COUNT(map, lookups, 1);
+    hashmap_entry_t* entry = hashmap_chain_unlink(map, &map->table[hashmap_bucket(map, hash)], bkey, key_len, hash);
+    if (!entry && map->old_table) {
+        dast_sz bucket = hashmap_bucket_in(map, hash, map->old_size);
+        if (bucket >= map->migrated) {
+            entry = hashmap_chain_unlink(map, &map->old_table[bucket], bkey, key_len, hash);
+        }
+    }
+    if (entry) map->entries--;
+    return entry;
+}
+
+/** Frees the entries, keys and tables of a chained map */
+static void hashmap_chain_free(hashmap_t* map){
+    hashmap_chain_migrate(map, map->old_size);
+    for (dast_sz i = 0; i != map->size; ++i) {
+        hashmap_entry_t* entry = map->table[i];
+        hashmap_entry_t* next;
+        while (entry) {
+            next = entry->next;
+            hashmap_entry_free_key(map, entry);
+            if (!map->pool.slab_entries) map->alloc.free(entry);
+            entry = next;
+        }
+    }
+    hashmap_pool_free(map);
+    hashmap_arena_free(map);
+    map->alloc.free(map->table);
+}
+
+/** Shared state of a parallel rebuild of a chained table */
+typedef struct hashmap_rebuild {
+    hashmap_t*        map;
+    hashmap_entry_t** table;   /**< New bucket array */
+    dast_sz           threads;
+} hashmap_rebuild_t;
+
+/** Zeroes a part of the new bucket array */
+static void hashmap_rebuild_clear(void* ctx, dast_sz t){
+    hashmap_rebuild_t* rb = ctx;
+    dast_sz start = hashmap_part_start(rb->map->size, rb->threads, t);
+    dast_sz end   = hashmap_part_start(rb->map->size, rb->threads, t + 1);
+    dast_memset(rb->table + start, 0, (end - start) * sizeof(hashmap_entry_t*));
+}
+
+/** Relinks the entries of a part of the old buckets into the new table.
+ * Each entry belongs to a single old bucket, so only the heads of the new buckets are shared,
+ * and entries are pushed onto them with an atomic exchange. */
+static void hashmap_rebuild_relink(void* ctx, dast_sz t){
+    hashmap_rebuild_t* rb = ctx;
+    hashmap_t* map = rb->map;
+    dast_sz start = hashmap_part_start(map->old_size, rb->threads, t);
+    dast_sz end   = hashmap_part_start(map->old_size, rb->threads, t + 1);
+
+    for (dast_sz i = start; i != end; ++i) {
+        hashmap_entry_t* entry = map->old_table[i];
+        while (entry) {
+            hashmap_entry_t* next = entry->next;
+            hashmap_entry_t** bucket = &rb->table[hashmap_bucket(map, entry->hash)];
+#if defined(DAST_ATOMICS)
+            entry->next = (hashmap_entry_t*)DAST_ATOMIC_EXCHANGE(bucket, entry);
+#else
+            entry->next = *bucket;
+            *bucket = entry;
+#endif
+            entry = next;
+        }
+    }
+}
+
+/** Replaces the table of a chained map with one of `new_size` buckets, moving every entry over at once.
+ * Entries are relinked into the new table using their stored hashes, so only the bucket array is allocated.
+ * Large tables of maps with `threads` are zeroed and relinked by several threads. */
+static hashmap_t* hashmap_chain_rebuild(hashmap_t* map, dast_sz new_size){
+    hashmap_chain_migrate(map, map->old_size); /* Finish any incremental resize first */
+    hashmap_rebuild_t rb = { map, dast_null, hashmap_parallel_threads(map, map->entries) };
+
+    if (rb.threads == 1) {
+        if (!hashmap_chain_begin_rehash(map, new_size)) return dast_null;
+        hashmap_chain_migrate(map, map->old_size);
+        hashmap_arena_maybe_compact(map);
+        return map;
+    }
+
+    new_size = hashmap_table_size(map, new_size);
+    rb.table = map->alloc.alloc(new_size * sizeof(hashmap_entry_t*));
+    if (!rb.table) return dast_null;
+
+    map->old_table = map->table;
+    map->old_size  = map->size;
+    map->table     = rb.table;
+    map->size      = new_size;
+    map->resizes++;
+    hashmap_parallel_for(rb.threads, hashmap_rebuild_clear, &rb);
+    hashmap_parallel_for(rb.threads, hashmap_rebuild_relink, &rb);
+
+    map->alloc.free(map->old_table);
+    map->old_table = dast_null;
+    map->old_size  = 0;
+    hashmap_arena_maybe_compact(map);
+    return map;
+}
+
+/** Shared state of a parallel bulk load into a chained map.
+ * Keys are split among threads by the part of the table their bucket falls in,
+ * so each thread links entries into its own buckets only. */
+typedef struct hashmap_build {
+    hashmap_t*         map;
+    dast_sz            n;
+    const void* const* bkeys;
+    const dast_sz*     key_lens;
+    void* const*       values;
+    dast_sz            threads;
+
+    dast_hash_t*     hashes;   /**< Hash of each key */
+    dast_sz*         order;    /**< Key indices, grouped by part of the table */
+    dast_sz*         counts;   /**< Keys of input slice `t` in table part `p`, at `t * threads + p`,
+                                    then the position in `order` where the next of them goes */
+    dast_sz*         bytes;    /**< Arena bytes of the keys of input slice `t` in table part `p` */
+    dast_sz          part_start[HASHMAP_MAX_THREADS + 1]; /**< First position in `order` of each part */
+    char*            arena_base[HASHMAP_MAX_THREADS];     /**< Arena space reserved for each part */
+    hashmap_entry_t* slab;     /**< Pool entries reserved for the batch, one per position in `order` */
+
+    dast_sz          inserted[HASHMAP_MAX_THREADS]; /**< Keys added by each part */
+    dast_sz          live[HASHMAP_MAX_THREADS];     /**< Arena bytes used by each part */
+    hashmap_entry_t* unused[HASHMAP_MAX_THREADS];   /**< Pool entries left unused by each part */
+    volatile dast_bool failed;
+} hashmap_build_t;
+
+/** Returns the part of the table a hash falls in */
+static dast_sz hashmap_build_part(hashmap_build_t* b, dast_hash_t hash){
+    return (dast_sz)((dast_u64)hashmap_bucket(b->map, hash) * b->threads / b->map->size);
+}
+
+/** First pass: hashes a slice of the keys, counting how many keys and arena bytes go to each part */
+static void hashmap_build_hash(void* ctx, dast_sz t){
+    hashmap_build_t* b = ctx;
+    dast_sz end = hashmap_part_start(b->n, b->threads, t + 1);
+    for (dast_sz i = hashmap_part_start(b->n, b->threads, t); i != end; ++i) {
+        b->hashes[i] = b->map->hash_fn(b->bkeys[i], b->key_lens[i]);
+        dast_sz cell = t * b->threads + hashmap_build_part(b, b->hashes[i]);
+        b->counts[cell]++;
+        if (b->key_lens[i] > HASHMAP_SMALL_KEY_SIZE) b->bytes[cell] += b->key_lens[i];
+    }
+}
+
+/** Second pass: places the keys of a slice in `order`, grouped by part and in input order within each part */
+static void hashmap_build_scatter(void* ctx, dast_sz t){
+    hashmap_build_t* b = ctx;
+    dast_sz end = hashmap_part_start(b->n, b->threads, t + 1);
+    for (dast_sz i = hashmap_part_start(b->n, b->threads, t); i != end; ++i) {
+        b->order[b->counts[t * b->threads + hashmap_build_part(b, b->hashes[i])]++] = i;
+    }
+}
+
+/** Third pass: adds the keys of a part of the table, replacing the values of keys already in the map */
+static void hashmap_build_link(void* ctx, dast_sz p){
+    hashmap_build_t* b = ctx;
+    hashmap_t* map = b->map;
+    char* arena = b->arena_base[p];
+
+    for (dast_sz k = b->part_start[p]; k != b->part_start[p + 1] && !b->failed; ++k) {
+        dast_sz i = b->order[k];
+        dast_sz len = b->key_lens[i];
+        hashmap_entry_t** bucket = &map->table[hashmap_bucket(map, b->hashes[i])];
+        HASHMAP_COUNT(map, lookups, 1);
+
+        hashmap_entry_t* entry = hashmap_chain_search(map, *bucket, b->bkeys[i], len, b->hashes[i]);
+        if (entry) {
+            hashmap_entry_set_value(map, entry, b->values[i]);
+            if (b->slab) {
+                hashmap_entry_t* spare = hashmap_entry_at(map, b->slab, k);
+                spare->next = b->unused[p];
+                b->unused[p] = spare;
+            }
+            continue;
+        }
+
+        if ((hashmap_len_t)len != len) { b->failed = dast_true; return; }
+        entry = b->slab ? hashmap_entry_at(map, b->slab, k) : map->alloc.alloc(map->entry_size);
+        if (!entry) { b->failed = dast_true; return; }
+
+        if (len <= HASHMAP_SMALL_KEY_SIZE) {
+            entry->key = entry->small_key;
+        } else if (arena) {
+            entry->key = arena;
+            arena += len;
+            b->live[p] += len;
+        } else if (!(entry->key = map->alloc.alloc(len))) {
+            if (!b->slab) map->alloc.free(entry);
+            b->failed = dast_true;
+            return;
+        }
+        dast_memcpy(entry->key, b->bkeys[i], len);
+        entry->len   = (hashmap_len_t)len;
+        entry->hash  = b->hashes[i];
+        entry->next  = *bucket;
+        hashmap_entry_set_value(map, entry, b->values[i]);
+        *bucket = entry;
+        b->inserted[p]++;
+    }
+}
+
+/** Adds many keys to a chained map using several threads, after sizing its table, pool and arena for them.
+ * @returns the input map on success, NULL if some keys could not be added,
+ * or `map` without adding anything if the scratch space could not be allocated */
+static hashmap_t* hashmap_chain_build_parallel(hashmap_t* map, dast_sz n, const void* const* bkeys, const dast_sz* key_lens, void* const* values, dast_sz threads, dast_bool* done){
+    hashmap_chain_migrate(map, map->old_size); /* Keys are only looked up in the current table */
+    hashmap_build_t* b = map->alloc.alloc(sizeof(hashmap_build_t));
+    if (!b) return map;
+    hashmap_t* result = map;
+    *b = (hashmap_build_t){ .map = map, .n = n, .bkeys = bkeys, .key_lens = key_lens, .values = values, .threads = threads };
+
+    b->hashes = map->alloc.alloc(n * sizeof(dast_hash_t));
+    b->order  = map->alloc.alloc(n * sizeof(dast_sz));
+    b->counts = map->alloc.alloc(threads * threads * sizeof(dast_sz));
+    b->bytes  = map->alloc.alloc(threads * threads * sizeof(dast_sz));
+    if (b->hashes && b->order && b->counts && b->bytes) {
+        *done = dast_true;
+        dast_memset(b->counts, 0, threads * threads * sizeof(dast_sz));
+        dast_memset(b->bytes,  0, threads * threads * sizeof(dast_sz));
+        hashmap_parallel_for(threads, hashmap_build_hash, b);
+
+        /* Lay out the parts one after another, each made of the slices in input order */
+        dast_sz pos = 0, arena_pos = 0;
+        char* arena = map->arena.chunk_size && map->arena.chunks ? map->arena.chunks->data + map->arena.used : dast_null;
+        for (dast_sz p = 0; p != threads; ++p) {
+            b->part_start[p] = pos;
+            b->arena_base[p] = arena ? arena + arena_pos : dast_null;
+            for (dast_sz t = 0; t != threads; ++t) {
+                dast_sz count = b->counts[t * threads + p];
+                b->counts[t * threads + p] = pos;
+                pos += count;
+                arena_pos += b->bytes[t * threads + p];
+            }
+        }
+        b->part_start[threads] = pos;
+        if (map->pool.slab_entries) b->slab = hashmap_entry_at(map, map->pool.slabs->entries, map->pool.used);
+
+        hashmap_parallel_for(threads, hashmap_build_scatter, b);
+        hashmap_parallel_for(threads, hashmap_build_link, b);
+
+        /* Reserved pool entries and arena bytes are all taken; those of existing keys are recycled or become gaps */
+        if (b->slab) map->pool.used += n;
+        if (arena) {
+            map->arena.used  += arena_pos;
+            map->arena.total += arena_pos;
+        }
+        for (dast_sz p = 0; p != threads; ++p) {
+            map->entries    += b->inserted[p];
+            map->arena.live += b->live[p];
+            while (b->unused[p]) {
+                hashmap_entry_t* entry = b->unused[p];
+                b->unused[p] = entry->next;
+                hashmap_entry_release(map, entry);
+            }
+        }
+        if (b->failed) result = dast_null;
+    }
+
+    if (b->hashes) map->alloc.free(b->hashes);
+    if (b->order)  map->alloc.free(b->order);
+    if (b->counts) map->alloc.free(b->counts);
+    if (b->bytes)  map->alloc.free(b->bytes);
+    map->alloc.free(b);
+    return result;
+}
+
+/** Shrinks a map once its load drops below `1 / HASHMAP_SHRINK_RATIO` of the maximum,
+ * down to half the maximum load, but never below the size it was initialised with.
+ * Growing also leaves a table at half its maximum load, so the number of entries
+ * must double or drop several-fold between resizes, and they cannot thrash. */
+static void hashmap_maybe_shrink(hashmap_t* map){
+    if (map->engine == HASHMAP_ENGINE_OPEN) {
+        dast_sz new_size = hashmap_ctrl_shrink_size(map->size, map->entries, map->min_size);
+        if (new_size < map->size) hashmap_open_rehash(map, new_size); /* On failure, the map is left as it was */
+        return;
+    }
+
+    if (map->entries * HASHMAP_LOADING_FACTOR * HASHMAP_SHRINK_RATIO >= map->size) return;
+    dast_sz new_size = map->entries * HASHMAP_LOADING_FACTOR * 2;
+    if (new_size < map->min_size) new_size = map->min_size;
+    if (hashmap_table_size(map, new_size) >= map->size) return;
+    if (map->rehash_budget) hashmap_chain_begin_rehash(map, new_size);
+    else                    hashmap_chain_rebuild(map, new_size);
+}
+
+
+/** Returns the entry of a key whose hash has already been computed */
+static hashmap_entry_t* hashmap_find_hashed(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    if (map->engine == HASHMAP_ENGINE_OPEN) {
+        dast_sz i = hashmap_open_find(map, bkey, key_len, hash);
+        return (i != map->size) ? hashmap_entry_at(map, map->slots, i) : dast_null;
+    }
+    return hashmap_chain_find(map, bkey, key_len, hash);
+}
+
+/** Prefetches the memory a lookup of the given hash reads first:
+ * the bucket of a chained map, or the first control group and slot of an open-addressing map */
+static void hashmap_prefetch_bucket(hashmap_t* map, dast_hash_t hash){
+    if (map->engine == HASHMAP_ENGINE_OPEN) {
+        dast_sz pos = (dast_sz)HASHMAP_H1(hash) & (map->size - 1);
+        DAST_PREFETCH(map->ctrl + pos);
+        DAST_PREFETCH(hashmap_entry_at(map, map->slots, pos));
+        return;
+    }
+    DAST_PREFETCH(map->table + hashmap_bucket(map, hash));
+}
+
+/** Returns the hashmap element with the given binary key
+ * @param map hashmap in which to lookup keys
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @return hashamp entry associated with the key
+*/
+static hashmap_entry_t* hashmap_lookupb(hashmap_t* map, const void* bkey, dast_sz key_len) {
+    if (!map || !bkey) return dast_null;
+    return hashmap_find_hashed(map, bkey, key_len, map->hash_fn(bkey, key_len));
+}
+
+/** Returns the entry of a key, inserting the key with a NULL value if it is not in the map */
+static hashmap_entry_t* hashmap_upsert_entry(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash, dast_bool* inserted){
+    return (map->engine == HASHMAP_ENGINE_OPEN)
+        ? hashmap_open_upsert (map, bkey, key_len, hash, inserted)
+        : hashmap_chain_upsert(map, bkey, key_len, hash, inserted);
+}
+
+
+/* 
+ * ----------------
+ * Public Functions
+ * ----------------
+ */
+
+#define HASHMAP_FNV_64BIT_OFFSET_BASIS ((dast_u64)0xcbf29ce484222325)
+#define HASHMAP_FNV_64BIT_PRIME ((dast_u64)0x100000001b3)
+
+#define HASHMAP_FNV_32BIT_OFFSET_BASIS ((dast_u32)0x811c9dc5)
+#define HASHMAP_FNV_32BIT_PRIME ((dast_u32)0x01000193)
+
+/* Folds a 64-bit hash into a `dast_hash_t` */
+#ifdef DAST_HASH_64BIT
+    #define HASHMAP_FOLD(H) (H)
+#else
+    #define HASHMAP_FOLD(H) ((dast_hash_t)((H) ^ ((H) >> 32)))
+#endif
+
+/* Computes the hash of a sequence of `len` bytes of `data`
+using the FNV1-a hashing algorithm. */
+dast_hash_t hashmap_FNV1a64_hash(const void* data, dast_sz len){
+	const char* p = data;
+	dast_u64 hash = HASHMAP_FNV_64BIT_OFFSET_BASIS;
+	for(dast_u64 i = 0; i != len; ++i){
+		hash = hash ^ p[i];
+		hash = hash * HASHMAP_FNV_64BIT_PRIME;
+	}
+	return HASHMAP_FOLD(hash);
+}
+
+/* Computes the hash of a sequence of `len` bytes of `data`
+using the 32-bit FNV1-a hashing algorithm. */
+dast_hash_t hashmap_FNV1a32_hash(const void* data, dast_sz len){
+	const char* p = data;
+	dast_u32 hash = HASHMAP_FNV_32BIT_OFFSET_BASIS;
+	for(dast_sz i = 0; i != len; ++i){
+		hash = hash ^ (dast_u8)p[i];
+		hash = hash * HASHMAP_FNV_32BIT_PRIME;
+	}
+	return hash;
+}
+
+
+/** Multiplies two 64-bit integers, storing the low half of the 128-bit product in `a` and the high half in `b` */
+static void hashmap_mum(dast_u64* a, dast_u64* b){
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 hashmap_u128;
+    hashmap_u128 r = (hashmap_u128)*a * *b;
+    *a = (dast_u64)r;
+    *b = (dast_u64)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
+#else
+    dast_u64 ha = *a >> 32, hb = *b >> 32, la = (dast_u32)*a, lb = (dast_u32)*b;
+    dast_u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    dast_u64 t = rl + (rm0 << 32), lo, c = t < rl;
+    lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/** Multiplies two 64-bit integers and folds the 128-bit product into 64 bits */
+static dast_u64 hashmap_mix(dast_u64 a, dast_u64 b){
+    hashmap_mum(&a, &b);
+    return a ^ b;
+}
+
+#define HASHMAP_WY_SECRET0 ((dast_u64)0x2d358dccaa6c78a5)
+#define HASHMAP_WY_SECRET1 ((dast_u64)0x8bb84b93962eacc9)
+#define HASHMAP_WY_SECRET2 ((dast_u64)0x4b33a62ed433d4a3)
+#define HASHMAP_WY_SECRET3 ((dast_u64)0x4d5a2da51de1aa47)
+
+/* Computes the 64-bit hash of a sequence of `len` bytes of `data`
+using the wyhash algorithm, which consumes 8 bytes per step. */
+dast_u64 hashmap_wyhash64_seeded(const void* data, dast_sz len, dast_u64 seed){
+    const dast_u8* p = data;
+    seed ^= HASHMAP_WY_SECRET0;
+    dast_u64 a, b;
+
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (hashmap_read32(p) << 32) | hashmap_read32(p + ((len >> 3) << 2));
+            b = (hashmap_read32(p + len - 4) << 32) | hashmap_read32(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = ((dast_u64)p[0] << 16) | ((dast_u64)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        dast_sz i = len;
+        if (i > 48) {
+            dast_u64 see1 = seed, see2 = seed;
+            do {
+                seed = hashmap_mix(hashmap_read64(p)      ^ HASHMAP_WY_SECRET1, hashmap_read64(p + 8)  ^ seed);
+                see1 = hashmap_mix(hashmap_read64(p + 16) ^ HASHMAP_WY_SECRET2, hashmap_read64(p + 24) ^ see1);
+                see2 = hashmap_mix(hashmap_read64(p + 32) ^ HASHMAP_WY_SECRET3, hashmap_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = hashmap_mix(hashmap_read64(p) ^ HASHMAP_WY_SECRET1, hashmap_read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = hashmap_read64(p + i - 16);
+        b = hashmap_read64(p + i - 8);
+    }
+
+    a ^= HASHMAP_WY_SECRET1;
+    b ^= seed;
+    hashmap_mum(&a, &b);
+    return hashmap_mix(a ^ HASHMAP_WY_SECRET0 ^ (dast_u64)len, b ^ HASHMAP_WY_SECRET1);
+}
+
+/* Computes the hash of a sequence of `len` bytes of `data`
+using the wyhash algorithm, which consumes 8 bytes per step. */
+dast_hash_t hashmap_wyhash64_hash(const void* data, dast_sz len){
+    dast_u64 hash = hashmap_wyhash64_seeded(data, len, 0);
+    return HASHMAP_FOLD(hash);
+}
+
 
+/** CRC32-C (Castagnoli) lookup table for the reflected polynomial 0x82F63B78 */
+static const dast_u32 hashmap_crc32c_table[256] = {
+    0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C, 0x26A1E7E8, 0xD4CA64EB,
+    0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B, 0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24,
+    0x105EC76F, 0xE235446C, 0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+    0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC, 0xBC267848, 0x4E4DFB4B,
+    0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A, 0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35,
+    0xAA64D611, 0x580F5512, 0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+    0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD, 0x1642AE59, 0xE4292D5A,
+    0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A, 0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595,
+    0x417B1DBC, 0xB3109EBF, 0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+    0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F, 0xED03A29B, 0x1F682198,
+    0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927, 0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38,
+    0xDBFC821C, 0x2997011F, 0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+    0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E, 0x4767748A, 0xB50CF789,
+    0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859, 0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46,
+    0x7198540D, 0x83F3D70E, 0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+    0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE, 0xDDE0EB2A, 0x2F8B6829,
+    0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C, 0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93,
+    0x082F63B7, 0xFA44E0B4, 0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+    0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B, 0xB4091BFF, 0x466298FC,
+    0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C, 0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033,
+    0xA24BB5A6, 0x502036A5, 0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+    0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975, 0x0E330A81, 0xFC588982,
+    0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D, 0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622,
+    0x38CC2A06, 0xCAA7A905, 0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+    0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8, 0xE52CC12C, 0x1747422F,
+    0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF, 0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0,
+    0xD3D3E1AB, 0x21B862A8, 0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+    0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78, 0x7FAB5E8C, 0x8DC0DD8F,
+    0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE, 0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1,
+    0x69E9F0D5, 0x9B8273D6, 0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+    0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69, 0xD5CF889D, 0x27A40B9E,
+    0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E, 0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351
+};
 
-/** Return the hash of a chunk of memory mod'ed with the map size */
-static dast_u64 hashmap_get_hash(hashmap_t* map, const void* key, dast_sz keylen){
-    return map->hash_fn(key, keylen) % map->size;
-}
+#define HASHMAP_CRC32C_SEED1 ((dast_u32)0xFFFFFFFF)
+#define HASHMAP_CRC32C_SEED2 ((dast_u32)0x9E3779B9)
 
-/** Returns the hashmap element with the given binary key
- * @param map hashmap in which to lookup keys
- * @param bkey binary key
- * @param key_len number of bytes in the key
- * @return hashamp entry associated with the key
-*/
-static hashmap_entry_t* hashmap_lookupb(hashmap_t* map, const void* bkey, dast_sz key_len) {
-    if (!map || !bkey) return dast_null;
-    dast_u64 hash = hashmap_get_hash(map, bkey, key_len);
-    hashmap_entry_t* entry = map->table[hash];
+/** Updates a CRC32-C with one byte */
+static dast_u32 hashmap_crc32c_u8(dast_u32 crc, dast_u8 byte){
+    return hashmap_crc32c_table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+}
 
-    while (entry) {
-        if (key_len == entry->len && map->eq_fn(bkey, entry->key, key_len)) {
-            return entry;
-        }
-        entry = entry->next;
+/** Updates a CRC32-C with an 8-byte word, least significant byte first */
+static dast_u32 hashmap_crc32c_u64(dast_u32 crc, dast_u64 word){
+    for (int i = 0; i != 8; ++i) {
+        crc = hashmap_crc32c_u8(crc, (dast_u8)word);
+        word >>= 8;
     }
-    return dast_null;
+    return crc;
 }
 
+/** Runs two CRC32-C lanes over alternating 8-byte words of the data, returning both joined into 64 bits.
+ * Lane one takes the words, lane two takes every second word and the trailing bytes. */
+#define HASHMAP_CRC32C_LANES(CRC_U64, CRC_U8) \
+    dast_u32 h1 = HASHMAP_CRC32C_SEED1, h2 = HASHMAP_CRC32C_SEED2; \
+    for (; len >= 16; p += 16, len -= 16) { \
+        h1 = (dast_u32)CRC_U64(h1, hashmap_read64(p)); \
+        h2 = (dast_u32)CRC_U64(h2, hashmap_read64(p + 8)); \
+    } \
+    if (len >= 8) { \
+        h1 = (dast_u32)CRC_U64(h1, hashmap_read64(p)); \
+        p += 8; \
+        len -= 8; \
+    } \
+    for (; len > 0; ++p, --len) { \
+        h2 = CRC_U8(h2, *p); \
+    } \
+    return ((dast_u64)h1 << 32) | h2;
 
-/* 
- * ----------------
- * Public Functions
- * ----------------
- */
+/** Computes the CRC32-C lanes of some data using a lookup table */
+static dast_u64 hashmap_crc32c_lanes_sw(const dast_u8* p, dast_sz len){
+    HASHMAP_CRC32C_LANES(hashmap_crc32c_u64, hashmap_crc32c_u8)
+}
 
-#define HASHMAP_FNV_64BIT_OFFSET_BASIS ((dast_u64)0xcbf29ce484222325)
-#define HASHMAP_FNV_64BIT_PRIME ((dast_u64)0x100000001b3)
+#ifdef HASHMAP_CRC32C_HW
+/** Computes the CRC32-C lanes of some data using the SSE4.2 `crc32` instruction */
+__attribute__((target("sse4.2")))
+static dast_u64 hashmap_crc32c_lanes_hw(const dast_u8* p, dast_sz len){
+    HASHMAP_CRC32C_LANES(__builtin_ia32_crc32di, __builtin_ia32_crc32qi)
+}
+#endif
 
-/* Computes the hash of a sequence of `len` bytes of `data`
-using the FNV1-a hashing algorithm. */
-dast_u64 hashmap_FNV1a64_hash(const void* data, dast_sz len){
-	const char* p = data;
-	dast_u64 hash = HASHMAP_FNV_64BIT_OFFSET_BASIS;
-	for(dast_u64 i = 0; i != len; ++i){
-		hash = hash ^ p[i];
-		hash = hash * HASHMAP_FNV_64BIT_PRIME;
-	}
-	return hash;
+/** Mixes the bits of a 64-bit integer so that every input bit affects every output bit */
+static dast_u64 hashmap_fmix64(dast_u64 k){
+    k ^= k >> 33;
+    k *= (dast_u64)0xff51afd7ed558ccd;
+    k ^= k >> 33;
+    k *= (dast_u64)0xc4ceb9fe1a85ec53;
+    k ^= k >> 33;
+    return k;
+}
+
+/* Computes the hash of a sequence of `len` bytes of `data` from two CRC32-C checksums.
+Uses the SSE4.2 `crc32` instruction when the CPU supports it, and an equivalent lookup table otherwise. */
+dast_hash_t hashmap_crc32c_hash(const void* data, dast_sz len){
+    dast_u64 hash;
+#ifdef HASHMAP_CRC32C_HW
+    if (__builtin_cpu_supports("sse4.2")) {
+        hash = hashmap_fmix64(hashmap_crc32c_lanes_hw(data, len) ^ (dast_u64)len);
+        return HASHMAP_FOLD(hash);
+    }
+#endif
+    hash = hashmap_fmix64(hashmap_crc32c_lanes_sw(data, len) ^ (dast_u64)len);
+    return HASHMAP_FOLD(hash);
 }
 
 
-/** @brief Initialise hashmap via user-managed object with custom allocator and/or hash function.
+/** @brief Initialise hashmap via user-managed object from a set of options.
  * Should be deleted with `hashmap_uninit`.
- * @param map Hashmap to initialised
- * @param size_hint Starting number of buckets
- * @param alloc Memory allocation functions. If NULL, defaults to 
- * @param hash_fn Hash function. If NULL, defaults to 64-bit FNV-1A.
- * @param eq_fn Key equality function. Needed when hashes collide and keys need to be compared. If NULL, defaults to comparing the raw bytes of the two keys.
-*/
-hashmap_t* hashmap_init_custom(
-	hashmap_t*        map,
-	dast_sz           size_hint,
-    dast_allocator_t  alloc,
-	hashmap_hashfn_t  hash_fn,
-    hashmap_eqfn_t    eq_fn
-){
+ * @param map Hashmap to initialise
+ * @param config Options. Zeroed fields fall back to the defaults used by `hashmap_init_custom`.
+ * @returns the input map on success, and NULL otherwise
+ */
+hashmap_t* hashmap_init_config(hashmap_t* map, hashmap_config_t config){
 
     if(!map) return dast_null;
     *map = (hashmap_t){0};
 
-    if (hash_fn) map->hash_fn = hash_fn;
-    else         map->hash_fn = hashmap_FNV1a64_hash;
+    if (config.hash_fn) map->hash_fn = config.hash_fn;
+    else                map->hash_fn = HASHMAP_DEFAULT_HASH;
 
-    if (eq_fn)   map->eq_fn   = eq_fn;
-    else         map->eq_fn   = dast_memeq;
+    if (config.eq_fn)   map->eq_fn   = config.eq_fn;
+    else                map->eq_fn   = dast_memeq;
 
-    if(!alloc.alloc || !alloc.realloc || !alloc.free){
+    if(!config.alloc.alloc || !config.alloc.realloc || !config.alloc.free){
 #ifdef DAST_NO_STDLIB
         return dast_null;
 #else
         map->alloc = DAST_DEFAULT_ALLOCATOR;
 #endif
-    } else map->alloc = alloc;
+    } else map->alloc = config.alloc;
+
+    map->arena.chunk_size = config.key_arena_chunk;
+    map->value_size = config.value_size;
+    map->entry_size = sizeof(hashmap_entry_t) + ((config.value_size + 7) & ~(dast_sz)7);
+    map->engine = config.engine;
+    if (map->engine == HASHMAP_ENGINE_OPEN) {
+        map->min_size = config.size_hint;
+        return hashmap_open_alloc(map, hashmap_ctrl_capacity(config.size_hint));
+    }
 
-    map->size = (dast_sz)hashmap_next_prime(size_hint);
-    map->table = map->alloc.alloc(map->size * sizeof(hashmap_entry_t*));
+    map->rehash_budget = config.rehash_budget;
+    if (map->rehash_budget && map->rehash_budget < HASHMAP_MIN_REHASH_BUDGET) {
+        map->rehash_budget = HASHMAP_MIN_REHASH_BUDGET;
+    }
+    map->sizing = config.sizing;
+    map->pool.slab_entries = config.pool_slab_entries;
+    map->threads = config.threads > HASHMAP_MAX_THREADS ? HASHMAP_MAX_THREADS : config.threads;
+    map->size = hashmap_table_size(map, config.size_hint);
+    map->min_size = config.size_hint;
+    map->table = hashmap_chain_alloc_table(map, map->size);
     if(!map->table){
         return dast_null;
     }
-    memset(map->table, 0, map->size * sizeof(hashmap_entry_t*));
 
     return map;
 }
 
+/** @brief Initialise hashmap via user-managed object with custom allocator and/or hash function.
+ * Should be deleted with `hashmap_uninit`.
+ * @param map Hashmap to initialised
+ * @param size_hint Starting number of buckets
+ * @param alloc Memory allocation functions. If NULL, defaults to 
+ * @param hash_fn Hash function. If NULL, defaults to `HASHMAP_DEFAULT_HASH`.
+ * @param eq_fn Key equality function. Needed when hashes collide and keys need to be compared. If NULL, defaults to comparing the raw bytes of the two keys.
+*/
+hashmap_t* hashmap_init_custom(
+	hashmap_t*        map,
+	dast_sz           size_hint,
+    dast_allocator_t  alloc,
+	hashmap_hashfn_t  hash_fn,
+    hashmap_eqfn_t    eq_fn
+){
+    return hashmap_init_config(map, (hashmap_config_t){
+        .size_hint = size_hint, .alloc = alloc, .hash_fn = hash_fn, .eq_fn = eq_fn
+    });
+}
+
 
 /** @brief Initialise hashmap via user-managed object.
  * Should be deleted using `hashmap_uninit`.
@@ -147,23 +1302,48 @@ hashmap_t* hashmap_init(hashmap_t* map, dast_sz size_hint){
  * @param map hashmap to uninitialise
  */
 void hashmap_uninit(hashmap_t* map){
-    if(!map || !map->table) return;
+    if(!map) return;
 
-    for(dast_sz i=0; i!=map->size; ++i){
-        hashmap_entry_t* entry = map->table[i];
-        hashmap_entry_t* next;
-        while(entry){
-            next = entry->next;
-            map->alloc.free(entry->key);
-            map->alloc.free(entry);
-            entry = next;
+    if(map->engine == HASHMAP_ENGINE_OPEN){
+        if(!map->slots) return;
+        for(dast_sz i = hashmap_open_next(map, 0); i != map->size; i = hashmap_open_next(map, i + 1)){
+            hashmap_entry_free_key(map, hashmap_entry_at(map, map->slots, i));
         }
+        hashmap_arena_free(map);
+        map->alloc.free(map->ctrl);
+        map->alloc.free(map->slots);
+        *map = (hashmap_t){0};
+        return;
     }
-    map->alloc.free(map->table);
+
+    if(!map->table) return;
+
+    hashmap_chain_free(map);
     *map = (hashmap_t){0};
 }
 
 
+/** @brief Computes the hash of a key with the hashing function of a map.
+ * @param map hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @returns the hash of the key, or zero if the map or key are NULL
+ */
+dast_hash_t hashmap_hashb(hashmap_t* map, const void* bkey, dast_sz key_len) {
+    if (!map || !bkey) return 0;
+    return map->hash_fn(bkey, key_len);
+}
+
+/** @brief Computes the hash of a string key with the hashing function of a map.
+ * @param map hashmap
+ * @param key string key
+ * @returns the hash of the key, including its null-terminating character
+ */
+dast_hash_t hashmap_hash(hashmap_t* map, string_t key) {
+    if (!key.str) return 0;
+    return hashmap_hashb(map, key.str, key.len + 1); /* Include null-terminating char */
+}
+
 /** @brief Checks if a map has a given key
  * @param map initialised hashmap
  * @param bkey key to find, can be any set of bytes
@@ -175,6 +1355,18 @@ dast_bool hashmap_has_keyb(hashmap_t* map, const void* bkey, dast_sz key_len) {
     return (hashmap_lookupb(map, bkey, key_len) != dast_null);
 }
 
+/** @brief Checks if a map has a given key, using a hash computed beforehand with `hashmap_hashb`.
+ * @param map hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @param hash hash of the key
+ * @returns `dast_true` if the key is in the map, and `dast_false` otherwise
+ */
+dast_bool hashmap_has_keyb_hashed(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash) {
+    if (!map || !bkey) return 0;
+    return (hashmap_find_hashed(map, bkey, key_len, hash) != dast_null);
+}
+
 /** @brief Checks if a map has a given string key
  * @param map initialised hashmap
  * @param key string key
@@ -197,6 +1389,20 @@ void* hashmap_getb(hashmap_t* map, const void* bkey, dast_sz key_len) {
     return entry->value;
 }
 
+/** @brief Retrieves the data associated with a key, using a hash computed beforehand with `hashmap_hashb`.
+ * @param map hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @param hash hash of the key
+ * @returns the data associated with the key, or NULL if the key is not in the map
+ */
+void* hashmap_getb_hashed(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash) {
+    if (!map || !bkey) return dast_null;
+    hashmap_entry_t* entry = hashmap_find_hashed(map, bkey, key_len, hash);
+    if (!entry) return dast_null;
+    return entry->value;
+}
+
 /** @brief Retrieves the data associated with a key.
  * @param hashmap to query
  * @param bkey key to search for, which can be any set of bytes
@@ -208,6 +1414,77 @@ void* hashmap_get(hashmap_t* map, string_t key){
     return hashmap_getb(map, key.str, key.len + 1); /* Include null-terminating char */
 }
 
+/** @brief Retrieves the data associated with many keys at once.
+ * Keys are processed in batches of `HASHMAP_BATCH_SIZE`: every key of a batch is hashed
+ * and its bucket prefetched, then the first entry of each bucket is prefetched,
+ * and only then are the keys resolved, so that their cache misses overlap.
+ * @param map hashmap
+ * @param n number of keys
+ * @param bkeys array of `n` keys. NULL keys are never found.
+ * @param key_lens array of `n` key lengths in bytes
+ * @param values array of `n` pointers, filled with the value of each key, or NULL if it is not in the map
+ * @returns the number of keys found
+ */
+dast_sz hashmap_getb_many(hashmap_t* map, dast_sz n, const void* const* bkeys, const dast_sz* key_lens, void** values){
+    if (!map || !bkeys || !key_lens || !values) return 0;
+
+    dast_hash_t hashes[HASHMAP_BATCH_SIZE];
+    dast_sz found = 0;
+
+    for (dast_sz start = 0; start < n; start += HASHMAP_BATCH_SIZE) {
+        dast_sz count = (n - start < HASHMAP_BATCH_SIZE) ? n - start : HASHMAP_BATCH_SIZE;
+        const void* const* keys = bkeys + start;
+        const dast_sz* lens = key_lens + start;
+
+        for (dast_sz i = 0; i != count; ++i) {
+            if (!keys[i]) continue;
+            hashes[i] = map->hash_fn(keys[i], lens[i]);
+            hashmap_prefetch_bucket(map, hashes[i]);
+        }
+
+        if (map->engine == HASHMAP_ENGINE_CHAINED) {
+            for (dast_sz i = 0; i != count; ++i) {
+                if (!keys[i]) continue;
+                hashmap_entry_t* entry = map->table[hashmap_bucket(map, hashes[i])];
+                if (entry) DAST_PREFETCH(entry);
+            }
+        }
+
+        for (dast_sz i = 0; i != count; ++i) {
+            hashmap_entry_t* entry = keys[i] ? hashmap_find_hashed(map, keys[i], lens[i], hashes[i]) : dast_null;
+            values[start + i] = entry ? entry->value : dast_null;
+            found += (entry != dast_null);
+        }
+    }
+    return found;
+}
+
+/** @brief Retrieves the data associated with many string keys at once.
+ * @param map hashmap
+ * @param n number of keys
+ * @param keys array of `n` string keys
+ * @param values array of `n` pointers, filled with the value of each key, or NULL if it is not in the map
+ * @returns the number of keys found
+ * @note See `hashmap_getb_many`
+ */
+dast_sz hashmap_get_many(hashmap_t* map, dast_sz n, const string_t* keys, void** values){
+    if (!map || !keys || !values) return 0;
+
+    const void* bkeys[HASHMAP_BATCH_SIZE];
+    dast_sz lens[HASHMAP_BATCH_SIZE];
+    dast_sz found = 0;
+
+    for (dast_sz start = 0; start < n; start += HASHMAP_BATCH_SIZE) {
+        dast_sz count = (n - start < HASHMAP_BATCH_SIZE) ? n - start : HASHMAP_BATCH_SIZE;
+        for (dast_sz i = 0; i != count; ++i) {
+            bkeys[i] = keys[start + i].str;
+            lens[i]  = keys[start + i].len + 1; /* Include null-terminating char */
+        }
+        found += hashmap_getb_many(map, count, bkeys, lens, values + start);
+    }
+    return found;
+}
+
 /** @brief Adds a new key-value pair to a hashmap. If the key already exists, the value is replaced.
  * @param map hashmap to which to insert value
  * @param bkey key to insert, can be any set of bytes
@@ -222,41 +1499,108 @@ void* hashmap_get(hashmap_t* map, string_t key){
  */
 hashmap_t* hashmap_setb(hashmap_t* map, const void* bkey, dast_sz key_len, void* value) {
     if (!map || !bkey) return dast_null;
+    return hashmap_setb_hashed(map, bkey, key_len, map->hash_fn(bkey, key_len), value);
+}
 
-    hashmap_entry_t* entry = hashmap_lookupb(map, bkey, key_len);
-    dast_u64 hash = map->hash_fn(bkey, key_len) % map->size;
+/** @brief Adds a new key-value pair to a hashmap, using a hash computed beforehand with `hashmap_hashb`.
+ * @param map hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @param hash hash of the key
+ * @param value data associated with the key
+ * @returns the input map on success, and NULL otherwise
+ */
+hashmap_t* hashmap_setb_hashed(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash, void* value) {
+    if (!map || !bkey) return dast_null;
+    dast_bool inserted;
+    hashmap_entry_t* entry = hashmap_upsert_entry(map, bkey, key_len, hash, &inserted);
+    if (!entry) return dast_null;
+    hashmap_entry_set_value(map, entry, value);
+    return map;
+}
 
-    while (entry) {
-        if (key_len == entry->len && map->eq_fn(bkey, entry->key, key_len)) {
-            entry->value = value;
-            return map;
-        }
-        entry = entry->next;
-    }
+/** @brief Returns a pointer to the value of a key, inserting the key with a NULL value if it is not in the map.
+ * @param map hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @param inserted if not NULL, set to whether the key was inserted
+ * @returns a pointer to the value of the key, or NULL on failure
+ */
+void** hashmap_upsertb(hashmap_t* map, const void* bkey, dast_sz key_len, dast_bool* inserted) {
+    if (!map || !bkey) return dast_null;
+    return hashmap_upsertb_hashed(map, bkey, key_len, map->hash_fn(bkey, key_len), inserted);
+}
+
+/** @brief Returns a pointer to the value of a key, using a hash computed beforehand with `hashmap_hashb`.
+ * @param map hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @param hash hash of the key
+ * @param inserted if not NULL, set to whether the key was inserted
+ * @returns a pointer to the value of the key, or NULL on failure
+ */
+void** hashmap_upsertb_hashed(hashmap_t* map, const void* bkey, dast_sz key_len, dast_hash_t hash, dast_bool* inserted) {
+    if (!map || !bkey) return dast_null;
 
-    /* No matching key found */
-    entry = map->alloc.alloc(sizeof(hashmap_entry_t));
+    dast_bool was_inserted;
+    hashmap_entry_t* entry = hashmap_upsert_entry(map, bkey, key_len, hash, &was_inserted);
     if (!entry) return dast_null;
+    if (inserted) *inserted = was_inserted;
+    return &entry->value;
+}
 
-    memset(entry, 0, sizeof(hashmap_entry_t));
-    entry->key = map->alloc.alloc(key_len);
-    if (!entry->key) {
-        map->alloc.free(entry);
-        return dast_null;
-    }
+/** @brief Returns a pointer to the value of a string key, inserting the key with a NULL value if it is not in the map.
+ * @param map hashmap
+ * @param key string key
+ * @param inserted if not NULL, set to whether the key was inserted
+ * @returns a pointer to the value of the key, or NULL on failure
+ */
+void** hashmap_upsert(hashmap_t* map, string_t key, dast_bool* inserted) {
+    if (!key.str) return dast_null;
+    return hashmap_upsertb(map, key.str, key.len + 1, inserted); /* Include null-terminating char */
+}
 
-    memcpy(entry->key, bkey, key_len);
-    entry->len = key_len;
-    entry->value = value;
-    entry->next = map->table[hash];
-    map->table[hash] = entry;
+/** @brief Removes a key from a hashmap, freeing its entry and its copy of the key.
+ * @param map hashmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @param value if not NULL, set to the value of the removed key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the map
+ */
+dast_bool hashmap_removeb(hashmap_t* map, const void* bkey, dast_sz key_len, void** value) {
+    if (!map || !bkey) return dast_false;
+    dast_hash_t hash = map->hash_fn(bkey, key_len);
 
-    /* Extend if necessary */
-    map->entries++;
-    if (map->entries * HASHMAP_LOADING_FACTOR >= map->size) {
-        hashmap_resize(map);
+    if (map->engine == HASHMAP_ENGINE_OPEN) {
+        if (!map->slots) return dast_false;
+        dast_sz i = hashmap_open_find(map, bkey, key_len, hash);
+        if (i == map->size) return dast_false;
+        if (value) *value = map->value_size ? dast_null : hashmap_entry_at(map, map->slots, i)->value;
+        hashmap_open_remove_at(map, i);
+    } else {
+        if (!map->table) return dast_false;
+        hashmap_chain_migrate(map, map->rehash_budget);
+        hashmap_entry_t* entry = hashmap_chain_remove(map, bkey, key_len, hash);
+        if (!entry) return dast_false;
+        if (value) *value = map->value_size ? dast_null : entry->value;
+        hashmap_entry_free_key(map, entry);
+        hashmap_entry_release(map, entry);
     }
-    return map;
+
+    hashmap_maybe_shrink(map);
+    hashmap_arena_maybe_compact(map);
+    return dast_true;
+}
+
+/** @brief Removes a string key from a hashmap, freeing its entry and its copy of the key.
+ * @param map hashmap
+ * @param key string key
+ * @param value if not NULL, set to the value of the removed key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the map
+ */
+dast_bool hashmap_remove(hashmap_t* map, string_t key, void** value) {
+    if (!key.str) return dast_false;
+    return hashmap_removeb(map, key.str, key.len + 1, value); /* Include null-terminating char */
 }
 
 /** @brief Adds a new key-value pair to a hashmap. If the key already exists, the value is replaced.
@@ -281,27 +1625,147 @@ hashmap_t* hashmap_set(hashmap_t* map, string_t key, void* value){
  * @note This is a CPU intensive operation, as the whole table is rehashed.
  * The table should resize itself automatically when the number of keys
  * reaches some fraction of the number of buckets.
+ * Maps using `HASHMAP_SIZING_POW2` round the new size up to a power of two instead,
+ * and maps using `HASHMAP_ENGINE_OPEN` double their number of slots.
  */
 hashmap_t* hashmap_resize(hashmap_t* map) {
     if (!map) return dast_null;
+    if (map->engine == HASHMAP_ENGINE_OPEN) return hashmap_open_grow(map);
 
-    dast_sz new_size = map->entries * HASHMAP_LOADING_FACTOR;
-    hashmap_t new_map;
-    hashmap_init_custom(&new_map, new_size, map->alloc, map->hash_fn, map->eq_fn);
-    hashmap_entry_t* entry;
-    dast_sz i;
+    /* Leave room for as many keys again before the next resize */
+    return hashmap_chain_rebuild(map, map->entries * HASHMAP_LOADING_FACTOR * 2);
+}
 
-    /* Rehash table */
-    for (i = 0; i != map->size; ++i) {
-        entry = map->table[i];
-        while (entry) {
-            hashmap_setb(&new_map, entry->key, entry->len, entry->value);
-            entry = entry->next;
-        }
+/** @brief Sizes the table of a map to hold a number of keys without growing.
+ * @param map hashmap
+ * @param n_keys number of keys the map should be able to hold
+ * @returns the input map on success, and NULL otherwise
+ */
+hashmap_t* hashmap_reserve(hashmap_t* map, dast_sz n_keys) {
+    if (!map) return dast_null;
+
+    if (map->engine == HASHMAP_ENGINE_OPEN) {
+        if (!map->slots) return dast_null;
+        dast_sz size = hashmap_ctrl_reserve_size(n_keys);
+        if (size <= map->size) return map;
+        return hashmap_open_rehash(map, size);
+    }
+
+    if (!map->table) return dast_null;
+    dast_sz size_hint = n_keys * HASHMAP_LOADING_FACTOR + 1;
+    if (hashmap_table_size(map, size_hint) <= map->size) return map;
+    return hashmap_chain_rebuild(map, size_hint);
+}
+
+/** Sizes the table, entry pool and key arena of a map for `n` more keys, `key_bytes` of which go to the arena */
+static hashmap_t* hashmap_reserve_batch(hashmap_t* map, dast_sz n, dast_sz key_bytes){
+    if (!hashmap_reserve(map, map->entries + n)) return dast_null;
+    if (map->engine == HASHMAP_ENGINE_CHAINED && !hashmap_pool_reserve(map, n)) return dast_null;
+    if (!hashmap_arena_reserve(map, key_bytes)) return dast_null;
+    return map;
+}
+
+/** @brief Adds many key-value pairs to a hashmap at once.
+ * @param map hashmap
+ * @param n number of keys
+ * @param bkeys array of `n` keys
+ * @param key_lens array of `n` key lengths in bytes
+ * @param values array of `n` values
+ * @returns the input map on success, and NULL otherwise
+ */
+hashmap_t* hashmap_setb_many(hashmap_t* map, dast_sz n, const void* const* bkeys, const dast_sz* key_lens, void* const* values) {
+    if (!map || !bkeys || !key_lens || !values) return dast_null;
+
+    dast_sz key_bytes = 0;
+    for (dast_sz i = 0; i != n; ++i) {
+        if (key_lens[i] > HASHMAP_SMALL_KEY_SIZE) key_bytes += key_lens[i];
+    }
+    if (!hashmap_reserve_batch(map, n, key_bytes)) return dast_null;
+
+    dast_sz threads = hashmap_parallel_threads(map, n);
+    if (threads > 1 && map->engine == HASHMAP_ENGINE_CHAINED) {
+        dast_bool done = dast_false;
+        hashmap_t* result = hashmap_chain_build_parallel(map, n, bkeys, key_lens, values, threads, &done);
+        if (done) return result;
+    }
+
+    for (dast_sz i = 0; i != n; ++i) {
+        if (!hashmap_setb(map, bkeys[i], key_lens[i], values[i])) return dast_null;
+    }
+    return map;
+}
+
+/** @brief Adds many key-value pairs with string keys to a hashmap at once.
+ * @param map hashmap
+ * @param n number of keys
+ * @param keys array of `n` string keys
+ * @param values array of `n` values
+ * @returns the input map on success, and NULL otherwise
+ */
+hashmap_t* hashmap_set_many(hashmap_t* map, dast_sz n, const string_t* keys, void* const* values) {
+    if (!map || !keys || !values) return dast_null;
+    if (n == 0) return map;
+
+    /* Passed to `hashmap_setb_many` in one call, so that large batches can be built in parallel */
+    const void** bkeys = map->alloc.alloc(n * sizeof(const void*));
+    dast_sz* lens = map->alloc.alloc(n * sizeof(dast_sz));
+    if (!bkeys || !lens) {
+        if (bkeys) map->alloc.free((void*)bkeys);
+        if (lens)  map->alloc.free(lens);
+        return dast_null;
+    }
+
+    for (dast_sz i = 0; i != n; ++i) {
+        bkeys[i] = keys[i].str;
+        lens[i]  = keys[i].len + 1; /* Include null-terminating char */
+    }
+    hashmap_t* result = hashmap_setb_many(map, n, bkeys, lens, values);
+
+    map->alloc.free((void*)bkeys);
+    map->alloc.free(lens);
+    return result;
+}
+
+/** @brief Moves buckets of a pending incremental resize into the new table.
+ * @param map hashmap
+ * @param buckets maximum number of buckets to move
+ * @returns `dast_true` if buckets remain to be moved, and `dast_false` otherwise
+ */
+dast_bool hashmap_rehash_step(hashmap_t* map, dast_sz buckets){
+    if (!map || map->engine != HASHMAP_ENGINE_CHAINED) return dast_false;
+    hashmap_chain_migrate(map, buckets);
+    return map->old_table != dast_null;
+}
+
+/** @brief Copies the keys held in the key arena of a map into a single new chunk,
+ * dropping the space taken by removed keys.
+ * @param map hashmap
+ * @returns the input map on success, and NULL otherwise
+ */
+hashmap_t* hashmap_compact_keys(hashmap_t* map){
+    if (!map) return dast_null;
+    if (!map->arena.chunk_size || !map->arena.chunks) return map;
+
+    dast_sz size = map->arena.live > map->arena.chunk_size ? map->arena.live : map->arena.chunk_size;
+    hashmap_arena_chunk_t* chunk = hashmap_arena_chunk_alloc(map, size);
+    if (!chunk) return dast_null;
+    chunk->next = dast_null;
+
+    dast_sz used = 0;
+    hashmap_cursor_t cursor = {0};
+    while (hashmap_cursor_next(map, &cursor)) {
+        hashmap_entry_t* entry = cursor.entry;
+        if (entry->key == entry->small_key) continue;
+        dast_memcpy(chunk->data + used, entry->key, entry->len);
+        entry->key = chunk->data + used;
+        used += entry->len;
     }
 
-    hashmap_uninit(map);
-    memmove(map, &new_map, sizeof(hashmap_t));
+    hashmap_arena_free(map);
+    map->arena.chunks = chunk;
+    map->arena.used   = used;
+    map->arena.live   = used;
+    map->arena.total  = used;
     return map;
 }
 
@@ -320,45 +1784,91 @@ hashmap_t* hashmap_resize(hashmap_t* map) {
  * 	```
  */
 void* hashmap_iterb(hashmap_t* map, const char* bkey, dast_sz* key_len) {
-    if (!map || !map->table) return dast_null;
+    if (!map) return dast_null;
 
     hashmap_entry_t* entry = dast_null;
-    dast_u64 hash;
 
-    /* Search from the beginning of the hash table */
-    if (!bkey) {
-        for (dast_sz i = 0; i != map->size; ++i) {
-            if (map->table[i]) {
-                if (key_len) {
-                    *key_len = map->table[i]->len;
-                }
-                return map->table[i]->key;
-            }
+    if (map->engine == HASHMAP_ENGINE_OPEN) {
+        if (!map->slots) return dast_null;
+        dast_sz i = 0;
+        if (bkey) {
+            i = hashmap_open_find(map, bkey, *key_len, map->hash_fn(bkey, *key_len));
+            if (i == map->size) return dast_null; /* Key provided does not exist in the map */
+            i++;
         }
-        return dast_null;
+        i = hashmap_open_next(map, i);
+        if (i == map->size) return dast_null;
+        hashmap_entry_t* slot = hashmap_entry_at(map, map->slots, i);
+        if (key_len) {
+            *key_len = slot->len;
+        }
+        return slot->key;
     }
 
-    /* Fetch the next key with the same hash (in a linked list) */
-    entry = hashmap_lookupb(map, bkey, *key_len);
-    if(!entry) return dast_null; /* Key provided does not exist in the map */
-    if (entry->next) {
-        if (key_len) {
-            *key_len = entry->next->len;
+    if (!map->table) return dast_null;
+
+    dast_bool in_old_table = dast_false;
+    dast_sz i = 0;
+
+    if (!bkey) {
+        /* Search from the beginning of the hash table */
+        entry = hashmap_chain_first(map, &in_old_table, &i);
+    } else {
+        dast_hash_t hash = map->hash_fn(bkey, *key_len);
+        HASHMAP_COUNT(map, lookups, 1);
+        entry = hashmap_chain_search(map, map->table[hashmap_bucket(map, hash)], bkey, *key_len, hash);
+        if (entry) {
+            /* Fetch the next key with the same hash (in a linked list),
+               or else the key in the table (with a different hash) */
+            i = hashmap_bucket(map, hash) + 1;
+        } else {
+            /* The key may not have been moved yet by an incremental resize */
+            entry = hashmap_chain_find_old(map, bkey, *key_len, hash);
+            if (!entry) return dast_null; /* Key provided does not exist in the map */
+            in_old_table = dast_true;
+            i = hashmap_bucket_in(map, hash, map->old_size) + 1;
         }
-        return entry->next->key;
+        entry = entry->next ? entry->next : hashmap_chain_first(map, &in_old_table, &i);
+    }
+
+    if (!entry) return dast_null;
+    if (key_len) {
+        *key_len = entry->len;
     }
+    return entry->key;
+}
+
+/** @brief Advances a cursor to the next entry of a hashmap.
+ * @param map hashmap
+ * @param cursor Zero-initialised to start iterating
+ * @returns `dast_true` if the cursor now holds an entry, and `dast_false` once all entries have been visited
+ */
+dast_bool hashmap_cursor_next(hashmap_t* map, hashmap_cursor_t* cursor){
+    if (!map || !cursor) return dast_false;
+
+    hashmap_entry_t* entry = dast_null;
 
-    /* Fetch the key in the table (with a different hash) */
-    hash = map->hash_fn(bkey, *key_len) % map->size;
-    for (dast_u64 i = hash + 1; i != map->size; ++i) {
-        if (map->table[i]) {
-            if (key_len) {
-                *key_len = map->table[i]->len;
+    if (map->engine == HASHMAP_ENGINE_OPEN) {
+        if (map->slots && cursor->bucket < map->size) {
+            cursor->bucket = hashmap_open_next(map, cursor->bucket);
+            if (cursor->bucket != map->size) {
+                entry = hashmap_entry_at(map, map->slots, cursor->bucket++);
             }
-            return map->table[i]->key;
+        }
+    } else if (map->table) {
+        entry = cursor->entry ? cursor->entry->next : dast_null;
+        if (!entry) {
+            entry = hashmap_chain_first(map, &cursor->in_old_table, &cursor->bucket);
+            cursor->bucket++;
         }
     }
-    return dast_null;
+
+    cursor->entry = entry;
+    if (!entry) return dast_false;
+    cursor->key   = entry->key;
+    cursor->len   = entry->len;
+    cursor->value = entry->value;
+    return dast_true;
 }
 
 /** @brief Returns the next key in a hashmap.
@@ -384,3 +1894,90 @@ string_t* hashmap_iter(hashmap_t* map, string_t* key){
     if(key->str) return key;
     return dast_null;
 }
+
+/** @brief Measures the layout and memory use of a map.
+ * @param map hashmap
+ * @param stats filled with the measurements and the lookup counters of the map
+ * @returns `stats` on success, and NULL if the map or `stats` are NULL
+ */
+hashmap_stats_t* hashmap_stats(hashmap_t* map, hashmap_stats_t* stats){
+    if (!map || !stats) return dast_null;
+    *stats = (hashmap_stats_t){0};
+    stats->entries  = map->entries;
+    stats->resizes  = map->resizes;
+    stats->counters = map->counters;
+    dast_sz chains = 0; /* Sum of the lengths of every chain */
+
+    if (map->engine == HASHMAP_ENGINE_OPEN) {
+        if (!map->slots) return stats;
+        dast_sz mask = map->size - 1;
+        stats->buckets     = map->size;
+        stats->table_bytes = map->size + HASHMAP_GROUP_WIDTH;
+        stats->entry_bytes = map->size * map->entry_size;
+
+        for (dast_sz i = hashmap_open_next(map, 0); i != map->size; i = hashmap_open_next(map, i + 1)) {
+            hashmap_entry_t* slot = hashmap_entry_at(map, map->slots, i);
+            if (slot->key != slot->small_key && !map->arena.chunk_size) stats->key_bytes += slot->len;
+
+            /* A lookup loads groups along the probe sequence of the hash until one contains the slot */
+            dast_sz pos = (dast_sz)HASHMAP_H1(slot->hash) & mask;
+            dast_sz groups = 0;
+            while (((i - pos) & mask) >= HASHMAP_GROUP_WIDTH && groups != map->size) {
+                groups++;
+                pos = (pos + groups * HASHMAP_GROUP_WIDTH) & mask;
+            }
+            stats->histogram[groups < HASHMAP_STATS_BINS ? groups : HASHMAP_STATS_BINS - 1]++;
+            if (groups + 1 > stats->max_chain) stats->max_chain = groups + 1;
+            chains += groups + 1;
+            stats->used_buckets++;
+        }
+        if (map->entries) stats->avg_chain = (double)chains / (double)map->entries;
+    } else {
+        if (!map->table) return stats;
+        stats->buckets     = map->size + (map->old_table ? map->old_size - map->migrated : 0);
+        stats->table_bytes = (map->size + (map->old_table ? map->old_size : 0)) * sizeof(hashmap_entry_t*);
+
+        for (int old = 0; old != 2; ++old) {
+            hashmap_entry_t** table = old ? map->old_table : map->table;
+            dast_sz start = old ? map->migrated : 0;
+            dast_sz end   = old ? map->old_size : map->size;
+            if (!table) continue;
+
+            for (dast_sz i = start; i != end; ++i) {
+                dast_sz length = 0;
+                for (hashmap_entry_t* entry = table[i]; entry; entry = entry->next) {
+                    if (entry->key != entry->small_key && !map->arena.chunk_size) stats->key_bytes += entry->len;
+                    length++;
+                }
+                stats->histogram[length < HASHMAP_STATS_BINS ? length : HASHMAP_STATS_BINS - 1]++;
+                if (length > stats->max_chain) stats->max_chain = length;
+                if (length) stats->used_buckets++;
+                chains += length;
+            }
+        }
+        if (stats->used_buckets) stats->avg_chain = (double)chains / (double)stats->used_buckets;
+
+        if (map->pool.slab_entries) {
+            for (hashmap_slab_t* slab = map->pool.slabs; slab; slab = slab->next) {
+                stats->entry_bytes += sizeof(hashmap_slab_t) + slab->capacity * map->entry_size;
+            }
+        } else {
+            stats->entry_bytes = map->entries * map->entry_size;
+        }
+    }
+
+    for (hashmap_arena_chunk_t* chunk = map->arena.chunks; chunk; chunk = chunk->next) {
+        stats->key_bytes += sizeof(hashmap_arena_chunk_t) + chunk->size;
+    }
+    if (stats->buckets) stats->load_factor = (double)map->entries / (double)stats->buckets;
+    stats->total_bytes = stats->table_bytes + stats->entry_bytes + stats->key_bytes;
+    return stats;
+}
+
+/** @brief Zeroes the lookup counters of a map.
+ * @param map hashmap
+ */
+void hashmap_reset_counters(hashmap_t* map){
+    if (!map) return;
+    map->counters = (hashmap_counters_t){0};
+}
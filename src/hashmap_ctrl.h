@@ -0,0 +1,254 @@
+/** @file hashmap_ctrl.h
+* Internal to the library: control bytes and probe sequences of open-addressing tables,
+* shared by open-addressing hashmaps and hash sets.
+*
+* Entries live in a flat array of `size` slots, where `size` is a power of two.
+* Each slot has a control byte: either EMPTY, DELETED, or the lowest 7 bits of
+* the key hash (H2). Lookups start at the slot given by the remaining hash bits (H1).
+* 32-bit hashes have too few bits to spare, so H2 takes their top 7 bits and H1 all of them.
+* Lookups scan groups of `HASHMAP_GROUP_WIDTH` control bytes at once, so only slots
+* whose H2 matches are ever dereferenced.
+* The first group of control bytes is mirrored after the last slot,
+* so that a group can always be loaded without wrapping around.
+*
+* Slots are `stride` bytes apart, and each starts with an entry holding a key, its length and its hash
+* at the offsets given by `hashmap_ctrl_table_t`, so the same probe loops serve entries of any type.
+*/
+
+
+#ifndef HASHMAP_CTRL_H
+#define HASHMAP_CTRL_H
+
+#include <stddef.h> /* offsetof */
+
+#include "defs.h"
+#include "mem.h"
+#include "hashmap.h"
+
+
+#define HASHMAP_CTRL_EMPTY   ((dast_u8)0x80)
+#define HASHMAP_CTRL_DELETED ((dast_u8)0xFE)
+
+#define HASHMAP_GROUP_LSBS ((dast_u64)0x0101010101010101)
+#define HASHMAP_GROUP_MSBS ((dast_u64)0x8080808080808080)
+
+#ifdef DAST_HASH_64BIT
+    #define HASHMAP_H1(hash) ((hash) >> 7)
+    #define HASHMAP_H2(hash) ((dast_u8)((hash) & 0x7F))
+#else
+    #define HASHMAP_H1(hash) (hash)
+    #define HASHMAP_H2(hash) ((dast_u8)((hash) >> 25))
+#endif
+
+
+/** @struct hashmap_ctrl_table
+ * @brief Control bytes and slots of an open-addressing table, and where each slot keeps its key.
+ */
+typedef struct hashmap_ctrl_table {
+	dast_u8* ctrl;        /**< Control byte per slot, plus a mirrored group */
+	char*    slots;       /**< Flat array of entries */
+	dast_sz  size;        /**< Number of slots, a power of two */
+	dast_sz  stride;      /**< Bytes between slots */
+	dast_sz  key_offset;  /**< Offset of the `char*` key in an entry */
+	dast_sz  len_offset;  /**< Offset of the `hashmap_len_t` key length in an entry */
+	dast_sz  hash_offset; /**< Offset of the `dast_hash_t` hash in an entry */
+} hashmap_ctrl_table_t;
+
+/** @struct hashmap_ctrl_lookup
+ * @brief Result of a lookup, with the work it took.
+ */
+typedef struct hashmap_ctrl_lookup {
+	dast_sz slot;     /**< Slot index of the key, or the number of slots if it is not in the table */
+	dast_sz probes;   /**< Groups of control bytes scanned */
+	dast_sz eq_calls; /**< Calls to the key equality function */
+} hashmap_ctrl_lookup_t;
+
+
+/** Returns the number of trailing zero bits of a non-zero integer */
+static inline dast_u32 hashmap_ctz64(dast_u64 x){
+#if defined(__GNUC__) || defined(__clang__)
+    return (dast_u32)__builtin_ctzll(x);
+#else
+    dast_u32 n = 0;
+    while (!(x & 1)) { x >>= 1; n++; }
+    return n;
+#endif
+}
+
+/** Returns the number of leading zero bits of a non-zero integer */
+static inline dast_u32 hashmap_clz64(dast_u64 x){
+#if defined(__GNUC__) || defined(__clang__)
+    return (dast_u32)__builtin_clzll(x);
+#else
+    dast_u32 n = 0;
+    while (!(x >> 63)) { x <<= 1; n++; }
+    return n;
+#endif
+}
+
+/** Reads 8 unaligned bytes as a little-endian integer */
+static inline dast_u64 hashmap_read64(const dast_u8* p){
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    dast_u64 v;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return v;
+#else
+    return  (dast_u64)p[0]        | ((dast_u64)p[1] << 8)
+         | ((dast_u64)p[2] << 16) | ((dast_u64)p[3] << 24)
+         | ((dast_u64)p[4] << 32) | ((dast_u64)p[5] << 40)
+         | ((dast_u64)p[6] << 48) | ((dast_u64)p[7] << 56);
+#endif
+}
+
+/** Loads a group of control bytes as a little-endian word */
+static inline dast_u64 hashmap_group_load(const dast_u8* ctrl){
+    return hashmap_read64(ctrl);
+}
+
+/** Returns a mask with the top bit set on every byte of the group equal to `h2`.
+ * May report false positives, which are discarded when the keys are compared. */
+static inline dast_u64 hashmap_group_match(dast_u64 group, dast_u8 h2){
+    dast_u64 x = group ^ (HASHMAP_GROUP_LSBS * h2);
+    return (x - HASHMAP_GROUP_LSBS) & ~x & HASHMAP_GROUP_MSBS;
+}
+
+/** Returns a mask with the top bit set on every EMPTY byte of the group */
+static inline dast_u64 hashmap_group_match_empty(dast_u64 group){
+    return group & (~group << 6) & HASHMAP_GROUP_MSBS;
+}
+
+/** Returns a mask with the top bit set on every EMPTY or DELETED byte of the group */
+static inline dast_u64 hashmap_group_match_free(dast_u64 group){
+    return group & (~group << 7) & HASHMAP_GROUP_MSBS;
+}
+
+/** Returns the smallest valid number of slots able to hold `n` slots */
+static inline dast_sz hashmap_ctrl_capacity(dast_sz n){
+    dast_sz cap = HASHMAP_GROUP_WIDTH;
+    while (cap < n) cap <<= 1;
+    return cap;
+}
+
+/** Returns the number of slots needed to hold `n_keys` keys without growing */
+static inline dast_sz hashmap_ctrl_reserve_size(dast_sz n_keys){
+    return hashmap_ctrl_capacity(n_keys * HASHMAP_OPEN_MAX_LOAD_DEN / HASHMAP_OPEN_MAX_LOAD_NUM + 1);
+}
+
+/** Returns the number of slots to rehash into before adding a key, or zero if the key fits.
+ * Tables grow beforehand, so that they never run out of empty slots.
+ * DELETED slots count towards the load, as they do not end probe sequences. */
+static inline dast_sz hashmap_ctrl_grow_size(dast_sz size, dast_sz entries, dast_sz deleted){
+    if ((entries + deleted + 1) * HASHMAP_OPEN_MAX_LOAD_DEN <= size * HASHMAP_OPEN_MAX_LOAD_NUM) return 0;
+    /* Mostly DELETED slots: clean them up without growing */
+    dast_bool crowded = (entries + 1) * HASHMAP_OPEN_MAX_LOAD_DEN * 2 > size * HASHMAP_OPEN_MAX_LOAD_NUM;
+    return crowded ? size * 2 : size;
+}
+
+/** Returns the number of slots to shrink to once the load drops below `1 / HASHMAP_SHRINK_RATIO` of the maximum,
+ * down to half the maximum load, but never below `min_size`. Returns `size` if the table should not shrink. */
+static inline dast_sz hashmap_ctrl_shrink_size(dast_sz size, dast_sz entries, dast_sz min_size){
+    if (entries * HASHMAP_OPEN_MAX_LOAD_DEN * HASHMAP_SHRINK_RATIO >= size * HASHMAP_OPEN_MAX_LOAD_NUM) return size;
+    dast_sz new_size = entries * HASHMAP_OPEN_MAX_LOAD_DEN * 2 / HASHMAP_OPEN_MAX_LOAD_NUM + 1;
+    if (new_size < min_size) new_size = min_size;
+    new_size = hashmap_ctrl_capacity(new_size);
+    return new_size < size ? new_size : size;
+}
+
+/** Allocates empty control bytes and `size` slots of `stride` bytes.
+ * Returns the slots, or NULL if either allocation failed, in which case nothing is left allocated. */
+static inline void* hashmap_ctrl_alloc(dast_allocator_t* alloc, dast_sz size, dast_sz stride, dast_u8** ctrl){
+    *ctrl = alloc->alloc(size + HASHMAP_GROUP_WIDTH);
+    void* slots = alloc->alloc(size * stride);
+    if (!*ctrl || !slots) {
+        if (*ctrl) alloc->free(*ctrl);
+        if (slots) alloc->free(slots);
+        *ctrl = dast_null;
+        return dast_null;
+    }
+    dast_memset(*ctrl, HASHMAP_CTRL_EMPTY, size + HASHMAP_GROUP_WIDTH);
+    return slots;
+}
+
+/** Sets the control byte of a slot, keeping the mirrored group in sync */
+static inline void hashmap_ctrl_set(dast_u8* ctrl, dast_sz size, dast_sz i, dast_u8 c){
+    ctrl[i] = c;
+    if (i < HASHMAP_GROUP_WIDTH) ctrl[size + i] = c;
+}
+
+/** Finds the slot of a key along the probe sequence of its hash */
+static inline hashmap_ctrl_lookup_t hashmap_ctrl_find(
+    const hashmap_ctrl_table_t* table, hashmap_eqfn_t eq_fn,
+    const void* bkey, dast_sz key_len, dast_hash_t hash
+){
+    hashmap_ctrl_lookup_t lookup = {table->size, 0, 0};
+    dast_sz mask = table->size - 1;
+    dast_sz pos  = (dast_sz)HASHMAP_H1(hash) & mask;
+    dast_sz step = 0;
+    dast_u8 h2   = HASHMAP_H2(hash);
+
+    for (;;) {
+        dast_u64 group = hashmap_group_load(table->ctrl + pos);
+        dast_u64 match = hashmap_group_match(group, h2);
+        lookup.probes++;
+        while (match) {
+            dast_sz j = (pos + hashmap_ctz64(match) / 8) & mask;
+            const char* slot = table->slots + j * table->stride;
+            if (*(const dast_hash_t*)(slot + table->hash_offset) == hash
+                && *(const hashmap_len_t*)(slot + table->len_offset) == key_len
+                && (lookup.eq_calls++, eq_fn(bkey, *(char* const*)(slot + table->key_offset), key_len))) {
+                lookup.slot = j;
+                return lookup;
+            }
+            match &= match - 1;
+        }
+        if (hashmap_group_match_empty(group)) return lookup;
+        step += HASHMAP_GROUP_WIDTH;
+        pos = (pos + step) & mask;
+    }
+}
+
+/** Returns the index of the first free slot along the probe sequence of a hash */
+static inline dast_sz hashmap_ctrl_find_free(const dast_u8* ctrl, dast_sz size, dast_hash_t hash){
+    dast_sz mask = size - 1;
+    dast_sz pos  = (dast_sz)HASHMAP_H1(hash) & mask;
+    dast_sz step = 0;
+
+    for (;;) {
+        dast_u64 free_mask = hashmap_group_match_free(hashmap_group_load(ctrl + pos));
+        if (free_mask) return (pos + hashmap_ctz64(free_mask) / 8) & mask;
+        step += HASHMAP_GROUP_WIDTH;
+        pos = (pos + step) & mask;
+    }
+}
+
+/** Takes the first free slot along the probe sequence of a hash for a new entry,
+ * setting its control byte. Returns the slot index. */
+static inline dast_sz hashmap_ctrl_place(dast_u8* ctrl, dast_sz size, dast_hash_t hash){
+    dast_sz i = hashmap_ctrl_find_free(ctrl, size, hash);
+    hashmap_ctrl_set(ctrl, size, i, HASHMAP_H2(hash));
+    return i;
+}
+
+/** Frees the control byte of slot `i`.
+ * The slot is marked EMPTY if every group containing it has another EMPTY slot,
+ * as then no probe sequence can have gone past it. Otherwise it is marked DELETED.
+ * @returns `dast_true` if the slot was marked DELETED */
+static inline dast_bool hashmap_ctrl_erase(dast_u8* ctrl, dast_sz size, dast_sz i){
+    dast_sz mask = size - 1;
+    dast_u64 empty_before = hashmap_group_match_empty(hashmap_group_load(ctrl + ((i - HASHMAP_GROUP_WIDTH) & mask)));
+    dast_u64 empty_after  = hashmap_group_match_empty(hashmap_group_load(ctrl + i));
+    dast_bool was_never_full = empty_before && empty_after
+        && hashmap_clz64(empty_before) / 8 + hashmap_ctz64(empty_after) / 8 < HASHMAP_GROUP_WIDTH;
+
+    hashmap_ctrl_set(ctrl, size, i, was_never_full ? HASHMAP_CTRL_EMPTY : HASHMAP_CTRL_DELETED);
+    return !was_never_full;
+}
+
+/** Returns the slot index after `i` holding an entry, or `size` if there are none left */
+static inline dast_sz hashmap_ctrl_next(const dast_u8* ctrl, dast_sz size, dast_sz i){
+    while (i != size && (ctrl[i] & HASHMAP_CTRL_EMPTY)) ++i;
+    return i;
+}
+
+
+#endif /* HASHMAP_CTRL_H */
@@ -0,0 +1,374 @@
+#include "hashset.h"
+#include "hashmap_ctrl.h"
+
+
+/*
+ * ----------------
+ * Static Functions
+ * ----------------
+ * Slots follow the layout of open-addressing hashmaps (see `hashmap_ctrl.h`),
+ * with entries that hold no value.
+ */
+
+/** Returns the table of a set, as walked by the probe loops of `hashmap_ctrl.h` */
+static hashmap_ctrl_table_t hashset_table(hashset_t* set){
+    return (hashmap_ctrl_table_t){
+        .ctrl = set->ctrl, .slots = (char*)set->slots, .size = set->size, .stride = sizeof(hashset_entry_t),
+        .key_offset  = offsetof(hashset_entry_t, key),
+        .len_offset  = offsetof(hashset_entry_t, len),
+        .hash_offset = offsetof(hashset_entry_t, hash)
+    };
+}
+
+/** Allocates empty control bytes and slots for a set of `size` slots */
+static hashset_t* hashset_alloc(hashset_t* set, dast_sz size){
+    set->size  = size;
+    set->slots = hashmap_ctrl_alloc(&set->alloc, size, sizeof(hashset_entry_t), &set->ctrl);
+    return set->slots ? set : dast_null;
+}
+
+/** Copies a key into an entry, inside the entry itself if it is short enough */
+static char* hashset_entry_set_key(hashset_t* set, hashset_entry_t* entry, const void* bkey, dast_sz key_len){
+    if ((hashmap_len_t)key_len != key_len) return dast_null; /* Too long for a 32-bit length */
+    if (key_len <= HASHMAP_SMALL_KEY_SIZE) {
+        entry->key = entry->small_key;
+    } else {
+        entry->key = set->alloc.alloc(key_len);
+        if (!entry->key) return dast_null;
+    }
+    dast_memcpy(entry->key, bkey, key_len);
+    entry->len = (hashmap_len_t)key_len;
+    return entry->key;
+}
+
+/** Frees the key of an entry, unless it is stored inside the entry */
+static void hashset_entry_free_key(hashset_t* set, hashset_entry_t* entry){
+    if (entry->key != entry->small_key) set->alloc.free(entry->key);
+}
+
+/** Moves an entry to a different address, pointing its key to the new copy if it is stored inline */
+static void hashset_entry_move(hashset_entry_t* dest, hashset_entry_t* src){
+    *dest = *src;
+    if (src->key == src->small_key) dest->key = dest->small_key;
+}
+
+/** Returns the slot index of a key, or `set->size` if it is not in the set */
+static dast_sz hashset_find(hashset_t* set, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    hashmap_ctrl_table_t table = hashset_table(set);
+    return hashmap_ctrl_find(&table, set->eq_fn, bkey, key_len, hash).slot;
+}
+
+/** Returns the slot index after `i` holding an entry, or `set->size` if there are none left */
+static dast_sz hashset_next(hashset_t* set, dast_sz i){
+    return hashmap_ctrl_next(set->ctrl, set->size, i);
+}
+
+/** Moves every entry into a new array of `new_size` slots, dropping DELETED control bytes */
+static hashset_t* hashset_rehash(hashset_t* set, dast_sz new_size){
+    hashset_t new_set = *set;
+    if (!hashset_alloc(&new_set, new_size)) return dast_null;
+    new_set.deleted = 0;
+
+    for (dast_sz i = hashset_next(set, 0); i != set->size; i = hashset_next(set, i + 1)) {
+        dast_sz j = hashmap_ctrl_place(new_set.ctrl, new_set.size, set->slots[i].hash);
+        hashset_entry_move(new_set.slots + j, set->slots + i);
+    }
+
+    set->alloc.free(set->ctrl);
+    set->alloc.free(set->slots);
+    *set = new_set;
+    return set;
+}
+
+/** Sizes the slots of a set to hold `n_keys` keys without growing */
+static hashset_t* hashset_reserve(hashset_t* set, dast_sz n_keys){
+    dast_sz size = hashmap_ctrl_reserve_size(n_keys);
+    if (size <= set->size) return set;
+    return hashset_rehash(set, size);
+}
+
+/** Adds a key whose hash has already been computed, if it is not in the set yet */
+static hashset_t* hashset_insert_hashed(hashset_t* set, const void* bkey, dast_sz key_len, dast_hash_t hash){
+    if (hashset_find(set, bkey, key_len, hash) != set->size) return set;
+
+    dast_sz new_size = hashmap_ctrl_grow_size(set->size, set->entries, set->deleted);
+    if (new_size && !hashset_rehash(set, new_size)) return dast_null;
+
+    dast_sz i = hashmap_ctrl_find_free(set->ctrl, set->size, hash);
+    hashset_entry_t* slot = set->slots + i;
+    if (!hashset_entry_set_key(set, slot, bkey, key_len)) return dast_null;
+    if (set->ctrl[i] == HASHMAP_CTRL_DELETED) set->deleted--;
+    slot->hash = hash;
+    hashmap_ctrl_set(set->ctrl, set->size, i, HASHMAP_H2(hash));
+    set->entries++;
+    return set;
+}
+
+/** Removes the slot at index `i` of a set */
+static void hashset_remove_at(hashset_t* set, dast_sz i){
+    hashset_entry_free_key(set, set->slots + i);
+    if (hashmap_ctrl_erase(set->ctrl, set->size, i)) set->deleted++;
+    set->entries--;
+}
+
+/** Shrinks a set once its load drops below `1 / HASHMAP_SHRINK_RATIO` of the maximum,
+ * but never below the size it was initialised with */
+static void hashset_maybe_shrink(hashset_t* set){
+    dast_sz new_size = hashmap_ctrl_shrink_size(set->size, set->entries, set->min_size);
+    if (new_size < set->size) hashset_rehash(set, new_size); /* On failure, the set is left as it was */
+}
+
+/** Returns the hash of the key of an entry of `src` under the hashing function of `set`,
+ * which is the hash stored in the entry if both sets hash keys the same way */
+static dast_hash_t hashset_entry_hash(hashset_t* set, hashset_t* src, hashset_entry_t* entry){
+    if (set->hash_fn == src->hash_fn) return entry->hash;
+    return set->hash_fn(entry->key, entry->len);
+}
+
+/** Checks if `set` has the key of an entry of `src` */
+static dast_bool hashset_has_entry(hashset_t* set, hashset_t* src, hashset_entry_t* entry){
+    return hashset_find(set, entry->key, entry->len, hashset_entry_hash(set, src, entry)) != set->size;
+}
+
+
+/*
+ * ----------------
+ * Public Functions
+ * ----------------
+ */
+
+/** @brief Initialise a set via user-managed object with custom allocator and/or hash function.
+ * Should be deleted with `hashset_uninit`.
+ * @param set Set to initialise
+ * @param size_hint Starting number of slots
+ * @param alloc Memory allocation functions
+ * @param hash_fn Hash function. If NULL, defaults to `HASHMAP_DEFAULT_HASH`.
+ * @param eq_fn Key equality function. If NULL, defaults to comparing the raw bytes of the two keys.
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_init_custom(
+	hashset_t*        set,
+	dast_sz           size_hint,
+	dast_allocator_t  alloc,
+	hashmap_hashfn_t  hash_fn,
+	hashmap_eqfn_t    eq_fn
+){
+    if (!set) return dast_null;
+    *set = (hashset_t){0};
+
+    set->hash_fn = hash_fn ? hash_fn : HASHMAP_DEFAULT_HASH;
+    set->eq_fn   = eq_fn   ? eq_fn   : dast_memeq;
+
+    if (!alloc.alloc || !alloc.realloc || !alloc.free) {
+#ifdef DAST_NO_STDLIB
+        return dast_null;
+#else
+        set->alloc = DAST_DEFAULT_ALLOCATOR;
+#endif
+    } else set->alloc = alloc;
+
+    set->min_size = size_hint;
+    return hashset_alloc(set, hashmap_ctrl_capacity(size_hint));
+}
+
+/** @brief Initialise a set via user-managed object.
+ * Should be deleted using `hashset_uninit`.
+ * @param set Set to initialise
+ * @param size_hint starting number of slots
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_init(hashset_t* set, dast_sz size_hint){
+    return hashset_init_custom(set, size_hint, DAST_DEFAULT_ALLOCATOR, dast_null, dast_null);
+}
+
+/** @brief Initialises a set with a copy of the keys of another, with the same allocator and functions.
+ * @param set Set to initialise
+ * @param src Set to copy
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_copy(hashset_t* set, hashset_t* src){
+    if (!set || !src || !src->slots || set == src) return dast_null;
+    *set = *src;
+    if (!hashset_alloc(set, src->size)) return dast_null;
+
+    dast_memcpy(set->ctrl, src->ctrl, src->size + HASHMAP_GROUP_WIDTH);
+    for (dast_sz i = hashset_next(src, 0); i != src->size; i = hashset_next(src, i + 1)) {
+        hashset_entry_t* entry = src->slots + i;
+        if (!hashset_entry_set_key(set, set->slots + i, entry->key, entry->len)) {
+            /* Free the keys copied so far */
+            for (dast_sz j = hashset_next(src, 0); j != i; j = hashset_next(src, j + 1)) {
+                hashset_entry_free_key(set, set->slots + j);
+            }
+            set->alloc.free(set->ctrl);
+            set->alloc.free(set->slots);
+            *set = (hashset_t){0};
+            return dast_null;
+        }
+        set->slots[i].hash = entry->hash;
+    }
+    return set;
+}
+
+/** @brief Frees a set and its copies of the keys.
+ * @param set set to uninitialise
+ */
+void hashset_uninit(hashset_t* set){
+    if (!set || !set->slots) return;
+    for (dast_sz i = hashset_next(set, 0); i != set->size; i = hashset_next(set, i + 1)) {
+        hashset_entry_free_key(set, set->slots + i);
+    }
+    set->alloc.free(set->ctrl);
+    set->alloc.free(set->slots);
+    *set = (hashset_t){0};
+}
+
+/** @brief Returns the number of keys in a set.
+ * @param set set
+ * @returns the number of keys
+ */
+dast_sz hashset_count(hashset_t* set){
+    if (!set) return 0;
+    return set->entries;
+}
+
+/** @brief Adds a key to a set. Does nothing if the key is already in it.
+ * @param set set
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_insertb(hashset_t* set, const void* bkey, dast_sz key_len){
+    if (!set || !set->slots || !bkey) return dast_null;
+    return hashset_insert_hashed(set, bkey, key_len, set->hash_fn(bkey, key_len));
+}
+
+/** @brief Adds a string key to a set. Does nothing if the key is already in it.
+ * @param set set
+ * @param key string key
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_insert(hashset_t* set, string_t key){
+    if (!key.str) return dast_null;
+    return hashset_insertb(set, key.str, key.len + 1); /* Include null-terminating char */
+}
+
+/** @brief Checks if a set has a given key
+ * @param set set
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if the key is in the set, and `dast_false` otherwise
+ */
+dast_bool hashset_containsb(hashset_t* set, const void* bkey, dast_sz key_len){
+    if (!set || !set->slots || !bkey) return dast_false;
+    return hashset_find(set, bkey, key_len, set->hash_fn(bkey, key_len)) != set->size;
+}
+
+/** @brief Checks if a set has a given string key
+ * @param set set
+ * @param key string key
+ * @returns `dast_true` if the key is in the set, and `dast_false` otherwise
+ */
+dast_bool hashset_contains(hashset_t* set, string_t key){
+    if (!key.str) return dast_false;
+    return hashset_containsb(set, key.str, key.len + 1); /* Include null-terminating char */
+}
+
+/** @brief Removes a key from a set, freeing its copy of the key.
+ * @param set set
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the set
+ */
+dast_bool hashset_removeb(hashset_t* set, const void* bkey, dast_sz key_len){
+    if (!set || !set->slots || !bkey) return dast_false;
+    dast_sz i = hashset_find(set, bkey, key_len, set->hash_fn(bkey, key_len));
+    if (i == set->size) return dast_false;
+    hashset_remove_at(set, i);
+    hashset_maybe_shrink(set);
+    return dast_true;
+}
+
+/** @brief Removes a string key from a set, freeing its copy of the key.
+ * @param set set
+ * @param key string key
+ * @returns `dast_true` if the key was removed, and `dast_false` if it was not in the set
+ */
+dast_bool hashset_remove(hashset_t* set, string_t key){
+    if (!key.str) return dast_false;
+    return hashset_removeb(set, key.str, key.len + 1); /* Include null-terminating char */
+}
+
+/** @brief Advances a cursor to the next key of a set.
+ * @param set set
+ * @param cursor Zero-initialised to start iterating
+ * @returns `dast_true` if the cursor now holds a key, and `dast_false` once all keys have been visited
+ */
+dast_bool hashset_cursor_next(hashset_t* set, hashset_cursor_t* cursor){
+    if (!set || !cursor || !set->slots || cursor->slot >= set->size) return dast_false;
+    cursor->slot = hashset_next(set, cursor->slot);
+    if (cursor->slot == set->size) return dast_false;
+    cursor->key = set->slots[cursor->slot].key;
+    cursor->len = set->slots[cursor->slot].len;
+    cursor->slot++;
+    return dast_true;
+}
+
+/** @brief Adds every key of `other` to `set`.
+ * @param set set to add keys to
+ * @param other keys to add
+ * @returns the input set on success, and NULL otherwise
+ */
+hashset_t* hashset_union(hashset_t* set, hashset_t* other){
+    if (!set || !other || !set->slots || !other->slots) return dast_null;
+    if (set == other) return set;
+
+    /* The union has at least as many keys as the larger set, so grow once up front */
+    if (!hashset_reserve(set, set->entries > other->entries ? set->entries : other->entries)) return dast_null;
+
+    for (dast_sz i = hashset_next(other, 0); i != other->size; i = hashset_next(other, i + 1)) {
+        hashset_entry_t* entry = other->slots + i;
+        if (!hashset_insert_hashed(set, entry->key, entry->len, hashset_entry_hash(set, other, entry))) return dast_null;
+    }
+    return set;
+}
+
+/** @brief Removes every key of `set` that is not in `other`.
+ * @param set set to remove keys from
+ * @param other keys to keep
+ * @returns the input set, or NULL if either set is NULL
+ */
+hashset_t* hashset_intersect(hashset_t* set, hashset_t* other){
+    if (!set || !other || !set->slots || !other->slots) return dast_null;
+    if (set == other) return set;
+
+    for (dast_sz i = hashset_next(set, 0); i != set->size; i = hashset_next(set, i + 1)) {
+        if (!hashset_has_entry(other, set, set->slots + i)) hashset_remove_at(set, i);
+    }
+    hashset_maybe_shrink(set);
+    return set;
+}
+
+/** @brief Removes every key of `other` from `set`.
+ * @param set set to remove keys from
+ * @param other keys to remove
+ * @returns the input set, or NULL if either set is NULL
+ */
+hashset_t* hashset_difference(hashset_t* set, hashset_t* other){
+    if (!set || !other || !set->slots || !other->slots) return dast_null;
+
+    if (set == other) {
+        for (dast_sz i = hashset_next(set, 0); i != set->size; i = hashset_next(set, i + 1)) hashset_remove_at(set, i);
+    } else if (other->entries < set->entries) {
+        for (dast_sz i = hashset_next(other, 0); i != other->size; i = hashset_next(other, i + 1)) {
+            hashset_entry_t* entry = other->slots + i;
+            dast_sz j = hashset_find(set, entry->key, entry->len, hashset_entry_hash(set, other, entry));
+            if (j != set->size) hashset_remove_at(set, j);
+        }
+    } else {
+        for (dast_sz i = hashset_next(set, 0); i != set->size; i = hashset_next(set, i + 1)) {
+            if (hashset_has_entry(other, set, set->slots + i)) hashset_remove_at(set, i);
+        }
+    }
+    hashset_maybe_shrink(set);
+    return set;
+}
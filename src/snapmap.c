@@ -0,0 +1,281 @@
+#include "snapmap.h"
+
+#if !defined(DAST_NO_STDLIB) && defined(__unix__)
+    #include <sched.h> /* sched_yield */
+#endif
+
+
+#if !defined(DAST_ATOMICS)
+    #error "snapmap needs GCC, Clang or MSVC atomic builtins"
+#endif
+
+
+/*
+ * ----------------
+ * Static Functions
+ * ----------------
+ */
+
+
+/** Acquires the writer lock */
+static void snapmap_lock(snapmap_t* snap){
+    while (DAST_ATOMIC_EXCHANGE(&snap->lock, 1)) {
+        while (DAST_ATOMIC_LOAD(&snap->lock)) DAST_CPU_PAUSE();
+    }
+}
+
+/** Releases the writer lock */
+static void snapmap_unlock(snapmap_t* snap){
+    DAST_ATOMIC_STORE(&snap->lock, 0);
+}
+
+/** Disposes of a map created by `snapmap_new_map` */
+static void snapmap_free_map(snapmap_t* snap, hashmap_t* map){
+    if (!map) return;
+    if (snap->on_reclaim) snap->on_reclaim(map);
+    hashmap_uninit(map);
+    snap->alloc.free(map);
+}
+
+/** Returns the oldest epoch an online reader may still be reading. Needs the writer lock */
+static dast_sz snapmap_min_seen(snapmap_t* snap){
+    dast_sz min = SNAPMAP_OFFLINE;
+    DAST_ATOMIC_FENCE();
+    for (snapmap_reader_t* reader = snap->readers; reader; reader = reader->next) {
+        dast_sz seen = DAST_ATOMIC_LOAD(&reader->seen);
+        if (seen < min) min = seen;
+    }
+    return min;
+}
+
+/** Frees the replaced maps every reader has moved on from. Needs the writer lock */
+static dast_sz snapmap_reclaim_locked(snapmap_t* snap){
+    dast_sz min = snapmap_min_seen(snap);
+    dast_sz kept = 0;
+    for (dast_sz i = 0; i != snap->retired_len; ++i) {
+        if (snap->retired[i].epoch <= min) snapmap_free_map(snap, snap->retired[i].map);
+        else snap->retired[kept++] = snap->retired[i];
+    }
+    snap->retired_len = kept;
+    return kept;
+}
+
+
+/*
+ * ----------------
+ * Public Functions
+ * ----------------
+ */
+
+
+/** @brief Initialise a snapmap with a custom allocator and/or a function to dispose of replaced maps.
+ * @param snap snapmap to initialise
+ * @param alloc Memory allocation functions
+ * @param on_reclaim Called on each replaced map before it is freed. May be NULL.
+ * @returns the input snapmap on success, and NULL otherwise
+ */
+snapmap_t* snapmap_init_custom(snapmap_t* snap, dast_allocator_t alloc, snapmap_reclaim_fn_t on_reclaim){
+    if (!snap) return dast_null;
+    *snap = (snapmap_t){0};
+    snap->epoch = 1;
+    snap->on_reclaim = on_reclaim;
+
+    if(!alloc.alloc || !alloc.realloc || !alloc.free){
+#ifdef DAST_NO_STDLIB
+        return dast_null;
+#else
+        snap->alloc = DAST_DEFAULT_ALLOCATOR;
+#endif
+    } else snap->alloc = alloc;
+
+    return snap;
+}
+
+/** @brief Initialise a snapmap with no published map.
+ * @param snap snapmap to initialise
+ * @returns the input snapmap on success, and NULL otherwise
+ */
+snapmap_t* snapmap_init(snapmap_t* snap){
+    return snapmap_init_custom(snap, DAST_DEFAULT_ALLOCATOR, dast_null);
+}
+
+/** @brief Frees the published map and every replaced one.
+ * @param snap snapmap
+ */
+void snapmap_uninit(snapmap_t* snap){
+    if (!snap || !snap->epoch) return;
+    for (dast_sz i = 0; i != snap->retired_len; ++i) {
+        snapmap_free_map(snap, snap->retired[i].map);
+    }
+    if (snap->retired) snap->alloc.free(snap->retired);
+    snapmap_free_map(snap, snap->current);
+    *snap = (snapmap_t){0};
+}
+
+/** @brief Allocates and initialises a map to be filled and then published with `snapmap_publish`.
+ * @param snap snapmap
+ * @param config Options of the map
+ * @returns a new map, or NULL on failure
+ */
+hashmap_t* snapmap_new_map(snapmap_t* snap, hashmap_config_t config){
+    if (!snap) return dast_null;
+    if (!config.alloc.alloc || !config.alloc.realloc || !config.alloc.free) config.alloc = snap->alloc;
+
+    hashmap_t* map = snap->alloc.alloc(sizeof(hashmap_t));
+    if (!map) return dast_null;
+    if (!hashmap_init_config(map, config)) {
+        snap->alloc.free(map);
+        return dast_null;
+    }
+    return map;
+}
+
+/** @brief Replaces the map seen by readers. The previous map is freed once every reader has moved on.
+ * @param snap snapmap
+ * @param map map created with `snapmap_new_map`, or NULL
+ * @returns the input snapmap on success, and NULL otherwise
+ */
+snapmap_t* snapmap_publish(snapmap_t* snap, hashmap_t* map){
+    if (!snap) return dast_null;
+    snapmap_lock(snap);
+
+    /* Make room for the replaced map first, so that failing leaves everything as it was */
+    if (snap->retired_len == snap->retired_cap) {
+        dast_sz cap = snap->retired_cap ? snap->retired_cap * 2 : 4;
+        snapmap_retired_t* retired = snap->alloc.realloc(snap->retired, cap * sizeof(snapmap_retired_t));
+        if (!retired) {
+            snapmap_unlock(snap);
+            return dast_null;
+        }
+        snap->retired = retired;
+        snap->retired_cap = cap;
+    }
+
+    /* Readers that see the new epoch also see the new map */
+    hashmap_t* old = snap->current;
+    DAST_ATOMIC_STORE(&snap->current, map);
+    dast_sz epoch = snap->epoch + 1;
+    DAST_ATOMIC_STORE(&snap->epoch, epoch);
+
+    if (old) snap->retired[snap->retired_len++] = (snapmap_retired_t){ old, epoch };
+    snapmap_reclaim_locked(snap);
+    snapmap_unlock(snap);
+    return snap;
+}
+
+/** @brief Frees the replaced maps that no reader can still be using.
+ * @param snap snapmap
+ * @returns the number of replaced maps still waiting for readers
+ */
+dast_sz snapmap_reclaim(snapmap_t* snap){
+    if (!snap) return 0;
+    snapmap_lock(snap);
+    dast_sz left = snapmap_reclaim_locked(snap);
+    snapmap_unlock(snap);
+    return left;
+}
+
+/** @brief Waits until every replaced map has been freed.
+ * @param snap snapmap
+ */
+void snapmap_synchronize(snapmap_t* snap){
+    while (snapmap_reclaim(snap)) {
+#if !defined(DAST_NO_STDLIB) && defined(__unix__)
+        sched_yield();
+#else
+        DAST_CPU_PAUSE();
+#endif
+    }
+}
+
+/** @brief Returns the published map, which must only be read.
+ * @param snap snapmap
+ * @returns the published map, or NULL if none has been published
+ */
+hashmap_t* snapmap_current(snapmap_t* snap){
+    if (!snap) return dast_null;
+    return DAST_ATOMIC_LOAD(&snap->current);
+}
+
+/** @brief Retrieves the data associated with a key in the published map.
+ * @param snap snapmap
+ * @param bkey binary key
+ * @param key_len number of bytes in the key
+ * @returns the value of the key, or NULL if the key or a published map do not exist
+ */
+void* snapmap_getb(snapmap_t* snap, const void* bkey, dast_sz key_len){
+    hashmap_t* map = snapmap_current(snap);
+    if (!map) return dast_null;
+    return hashmap_getb(map, bkey, key_len);
+}
+
+/** @brief Retrieves the data associated with a string key in the published map.
+ * @param snap snapmap
+ * @param key string key
+ * @returns the value of the key, or NULL if the key or a published map do not exist
+ */
+void* snapmap_get(snapmap_t* snap, string_t key){
+    hashmap_t* map = snapmap_current(snap);
+    if (!map) return dast_null;
+    return hashmap_get(map, key);
+}
+
+/** @brief Registers the calling thread as a reader. The reader starts online.
+ * @param snap snapmap
+ * @param reader registration
+ */
+void snapmap_register(snapmap_t* snap, snapmap_reader_t* reader){
+    if (!snap || !reader) return;
+    snapmap_lock(snap);
+    reader->seen = snap->epoch;
+    reader->next = snap->readers;
+    snap->readers = reader;
+    snapmap_unlock(snap);
+}
+
+/** @brief Unregisters a reader.
+ * @param snap snapmap
+ * @param reader registration passed to `snapmap_register`
+ */
+void snapmap_unregister(snapmap_t* snap, snapmap_reader_t* reader){
+    if (!snap || !reader) return;
+    snapmap_lock(snap);
+    for (snapmap_reader_t** link = &snap->readers; *link; link = &(*link)->next) {
+        if (*link == reader) {
+            *link = reader->next;
+            break;
+        }
+    }
+    snapmap_reclaim_locked(snap);
+    snapmap_unlock(snap);
+}
+
+/** @brief Announces that a reader holds no pointers to maps of the snapmap.
+ * @param snap snapmap
+ * @param reader registration of the calling thread
+ */
+void snapmap_quiescent(snapmap_t* snap, snapmap_reader_t* reader){
+    if (!snap || !reader) return;
+    /* Releases every read of the maps made so far */
+    DAST_ATOMIC_STORE(&reader->seen, DAST_ATOMIC_LOAD(&snap->epoch));
+}
+
+/** @brief Marks a reader as offline, so it does not hold back reclamation.
+ * @param snap snapmap
+ * @param reader registration of the calling thread
+ */
+void snapmap_offline(snapmap_t* snap, snapmap_reader_t* reader){
+    if (!snap || !reader) return;
+    DAST_ATOMIC_STORE(&reader->seen, SNAPMAP_OFFLINE);
+}
+
+/** @brief Marks an offline reader as online again.
+ * @param snap snapmap
+ * @param reader registration of the calling thread
+ */
+void snapmap_online(snapmap_t* snap, snapmap_reader_t* reader){
+    if (!snap || !reader) return;
+    DAST_ATOMIC_STORE(&reader->seen, DAST_ATOMIC_LOAD(&snap->epoch));
+    /* Either a writer reclaiming now sees this reader, or the reader sees the map it published */
+    DAST_ATOMIC_FENCE();
+}
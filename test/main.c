@@ -11,6 +11,12 @@
 #include "test_array/test_array.h"
 #include "test_str/test_str.h"
 #include "test_hashmap/test_hashmap.h"
+#include "test_chashmap/test_chashmap.h"
+#include "test_snapmap/test_snapmap.h"
+#include "test_hashimage/test_hashimage.h"
+#include "test_typedmap/test_typedmap.h"
+#include "test_hashset/test_hashset.h"
+#include "test_frozenmap/test_frozenmap.h"
 
 
 int main(int argc, const char* argv[]){
@@ -34,6 +40,12 @@ int main(int argc, const char* argv[]){
         TEST_GROUP_ARRAY,
         TEST_GROUP_STRING,
         TEST_GROUP_HASHMAP
+        TEST_GROUP_CHASHMAP,
+        TEST_GROUP_SNAPMAP,
+        TEST_GROUP_HASHIMAGE,
+        TEST_GROUP_TYPEDMAP,
+        TEST_GROUP_HASHSET,
+        TEST_GROUP_FROZENMAP
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,233 @@
+#include "test_chashmap.h"
+
+#if !defined(DAST_NO_STDLIB) && defined(__unix__)
+    #include <pthread.h>
+    #define TEST_CHASHMAP_THREADS
+#endif
+
+
+/* CONSTANTS */
+
+#define TEST_ALLOCATOR (dast_allocator_t){.alloc=test_malloc_wrapper, .realloc=test_realloc_wrapper, .free=test_free_wrapper}
+
+/* STATIC FUNCTIONS */
+
+static void* test_malloc_wrapper (dast_sz size)             { return test_malloc((size_t)size); }
+static void* test_realloc_wrapper(void* block, dast_sz size){ return test_realloc(block, (size_t)size); }
+static void  test_free_wrapper   (void* block)              {        test_free(block); }
+
+/* PUBLIC FUNCTIONS */
+
+void test_chashmap_init_free(void** state){
+    (void)state;
+    chashmap_t map;
+    void* result = chashmap_init_custom(&map, 100, TEST_ALLOCATOR, dast_null, dast_null);
+
+    assert_non_null(result);
+    assert_non_null(map.table);
+    assert_int_equal(map.table->size, 128); /* Next power of two */
+    assert_int_equal(chashmap_count(&map), 0);
+
+    chashmap_uninit(&map);
+    assert_null(map.table);
+
+    /* Never fewer buckets than stripes */
+    chashmap_init_custom(&map, 0, TEST_ALLOCATOR, dast_null, dast_null);
+    assert_int_equal(map.table->size, CHASHMAP_STRIPES);
+    chashmap_uninit(&map);
+}
+
+void test_chashmap_init_null(void** state){
+    (void)state;
+    assert_null(chashmap_init_custom(dast_null, 10, TEST_ALLOCATOR, dast_null, dast_null));
+    chashmap_uninit(dast_null);
+}
+
+void test_chashmap_setb(void** state){
+    (void)state;
+    chashmap_t map;
+    chashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    int x = 1, y = 2;
+    dast_u64 kx = 10, ky = 20, kz = 30;
+
+    assert_ptr_equal(chashmap_setb(&map, &kx, sizeof(kx), &x), &map);
+    assert_ptr_equal(chashmap_setb(&map, &ky, sizeof(ky), &y), &map);
+    assert_null(chashmap_setb(&map, dast_null, 0, &x));
+
+    assert_ptr_equal(chashmap_getb(&map, &kx, sizeof(kx)), &x);
+    assert_ptr_equal(chashmap_getb(&map, &ky, sizeof(ky)), &y);
+    assert_null(chashmap_getb(&map, &kz, sizeof(kz)));
+    assert_true(chashmap_has_keyb(&map, &kx, sizeof(kx)));
+    assert_false(chashmap_has_keyb(&map, &kz, sizeof(kz)));
+    assert_int_equal(chashmap_count(&map), 2);
+
+    chashmap_uninit(&map);
+}
+
+void test_chashmap_setb_replace(void** state){
+    (void)state;
+    chashmap_t map;
+    chashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    int x = 1, y = 2;
+    dast_u64 k = 5;
+
+    chashmap_setb(&map, &k, sizeof(k), &x);
+    chashmap_setb(&map, &k, sizeof(k), &y);
+    assert_ptr_equal(chashmap_getb(&map, &k, sizeof(k)), &y);
+    assert_int_equal(chashmap_count(&map), 1);
+
+    chashmap_uninit(&map);
+}
+
+void test_chashmap_set_str(void** state){
+    (void)state;
+    chashmap_t map;
+    chashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    int x = 1;
+    string_t key = string_scoped_lit("key");
+
+    chashmap_set(&map, key, &x);
+    assert_ptr_equal(chashmap_get(&map, key), &x);
+    assert_true(chashmap_has_key(&map, key));
+    assert_false(chashmap_has_key(&map, string_scoped_lit("other")));
+    assert_null(chashmap_get(&map, (string_t){0}));
+
+    chashmap_uninit(&map);
+}
+
+void test_chashmap_removeb(void** state){
+    (void)state;
+    chashmap_t map;
+    chashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    const dast_u64 nkeys = 1000;
+
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        chashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+    }
+
+    /* Remove odd keys. Enough entries are retired to be freed while the map is in use */
+    for(dast_u64 i = 1; i < nkeys; i += 2){
+        void* value = dast_null;
+        assert_true(chashmap_removeb(&map, &i, sizeof(i), &value));
+        assert_ptr_equal(value, (void*)(dast_sz)(i + 1));
+        assert_false(chashmap_removeb(&map, &i, sizeof(i), dast_null));
+    }
+    assert_int_equal(chashmap_count(&map), nkeys / 2);
+    assert_true(map.limbo[0].len + map.limbo[1].len < nkeys / 2);
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        assert_int_equal(chashmap_has_keyb(&map, &i, sizeof(i)), i % 2 == 0);
+    }
+
+    /* Removed keys can be added again */
+    dast_u64 k = 1;
+    chashmap_setb(&map, &k, sizeof(k), dast_null);
+    assert_true(chashmap_has_keyb(&map, &k, sizeof(k)));
+
+    chashmap_uninit(&map);
+}
+
+void test_chashmap_remove_str(void** state){
+    (void)state;
+    chashmap_t map;
+    chashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    int x = 1;
+    void* value = dast_null;
+    string_t key = string_scoped_lit("key");
+
+    chashmap_set(&map, key, &x);
+    assert_true(chashmap_remove(&map, key, &value));
+    assert_ptr_equal(value, &x);
+    assert_false(chashmap_has_key(&map, key));
+    assert_false(chashmap_remove(&map, key, dast_null));
+
+    chashmap_uninit(&map);
+}
+
+void test_chashmap_grow(void** state){
+    (void)state;
+    chashmap_t map;
+    chashmap_init_custom(&map, 0, TEST_ALLOCATOR, dast_null, dast_null);
+    const dast_u64 nkeys = 10000;
+
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        chashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+    }
+    assert_int_equal(chashmap_count(&map), nkeys);
+    assert_true(map.table->size >= nkeys);
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        assert_ptr_equal(chashmap_getb(&map, &i, sizeof(i)), (void*)(dast_sz)(i + 1));
+    }
+
+    chashmap_uninit(&map);
+}
+
+#ifdef TEST_CHASHMAP_THREADS
+
+#define TEST_THREADS 4
+#define TEST_THREAD_KEYS 2000
+
+static chashmap_t test_map;
+static volatile int test_writers_done = 0;
+
+/* Adds and removes a range of keys of its own, twice over, forcing the table to grow */
+static void* test_chashmap_writer(void* arg){
+    dast_u64 base = (dast_u64)(dast_sz)arg * TEST_THREAD_KEYS;
+    for(int round = 0; round != 2; ++round){
+        for(dast_u64 k = base; k != base + TEST_THREAD_KEYS; ++k){
+            chashmap_setb(&test_map, &k, sizeof(k), (void*)(dast_sz)(k + 1));
+        }
+        for(dast_u64 k = base; k != base + TEST_THREAD_KEYS; k += 2){
+            chashmap_removeb(&test_map, &k, sizeof(k), dast_null);
+        }
+    }
+    return dast_null;
+}
+
+/* Looks up keys that are never removed, which must always be found with their value */
+static void* test_chashmap_reader(void* arg){
+    (void)arg;
+    dast_sz misses = 0;
+    while(!__atomic_load_n(&test_writers_done, __ATOMIC_ACQUIRE)){
+        for(dast_u64 k = 1; k < TEST_THREAD_KEYS; k += 2){
+            if(chashmap_getb(&test_map, &k, sizeof(k)) != (void*)(dast_sz)(k + 1)) misses++;
+        }
+    }
+    return (void*)misses;
+}
+
+#endif
+
+void test_chashmap_threads(void** state){
+    (void)state;
+#ifdef TEST_CHASHMAP_THREADS
+    pthread_t writers[TEST_THREADS], reader;
+    void* misses;
+
+    /* Thread-safe allocator, unlike the test one */
+    chashmap_init(&test_map, 0);
+    for(dast_u64 k = 1; k < TEST_THREAD_KEYS; k += 2){
+        chashmap_setb(&test_map, &k, sizeof(k), (void*)(dast_sz)(k + 1));
+    }
+    test_writers_done = 0;
+
+    pthread_create(&reader, dast_null, test_chashmap_reader, dast_null);
+    for(dast_sz i = 0; i != TEST_THREADS; ++i){
+        pthread_create(&writers[i], dast_null, test_chashmap_writer, (void*)(i + 1));
+    }
+    for(dast_sz i = 0; i != TEST_THREADS; ++i){
+        pthread_join(writers[i], dast_null);
+    }
+    __atomic_store_n(&test_writers_done, 1, __ATOMIC_RELEASE);
+    pthread_join(reader, &misses);
+
+    assert_null(misses);
+    assert_int_equal(chashmap_count(&test_map), TEST_THREAD_KEYS / 2 * (TEST_THREADS + 1));
+    for(dast_sz i = 1; i != TEST_THREADS + 1; ++i){
+        dast_u64 even = i * TEST_THREAD_KEYS, odd = even + 1;
+        assert_false(chashmap_has_keyb(&test_map, &even, sizeof(even)));
+        assert_ptr_equal(chashmap_getb(&test_map, &odd, sizeof(odd)), (void*)(dast_sz)(odd + 1));
+    }
+
+    chashmap_uninit(&test_map);
+#endif
+}
@@ -0,0 +1,37 @@
+#ifndef TEST_CHASHMAP_H
+#define TEST_CHASHMAP_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "chashmap.h"
+
+
+#define TEST_GROUP_CHASHMAP \
+    cmocka_unit_test(test_chashmap_init_free), \
+    cmocka_unit_test(test_chashmap_init_null), \
+    cmocka_unit_test(test_chashmap_setb), \
+    cmocka_unit_test(test_chashmap_setb_replace), \
+    cmocka_unit_test(test_chashmap_set_str), \
+    cmocka_unit_test(test_chashmap_removeb), \
+    cmocka_unit_test(test_chashmap_remove_str), \
+    cmocka_unit_test(test_chashmap_grow), \
+    cmocka_unit_test(test_chashmap_threads)
+
+
+void test_chashmap_init_free(void** state);
+void test_chashmap_init_null(void** state);
+void test_chashmap_setb(void** state);
+void test_chashmap_setb_replace(void** state);
+void test_chashmap_set_str(void** state);
+void test_chashmap_removeb(void** state);
+void test_chashmap_remove_str(void** state);
+void test_chashmap_grow(void** state);
+void test_chashmap_threads(void** state);
+
+
+#endif /* TEST_CHASHMAP_H */
@@ -0,0 +1,227 @@
+#include "test_frozenmap.h"
+
+
+/* CONSTANTS */
+
+#define N_KEYS 5000
+
+/* Enough sequential integer keys for the default hash to give some of them the same hash */
+#define N_SEQUENTIAL_KEYS 50000
+
+/* Longer than `HASHMAP_SMALL_KEY_SIZE`, so stored outside the entry of the map */
+#define LONG_KEY_SIZE 40
+
+#define TEST_ALLOCATOR (dast_allocator_t){.alloc=test_malloc_wrapper, .realloc=test_realloc_wrapper, .free=test_free_wrapper}
+
+/* STATIC FUNCTIONS */
+
+static void* test_malloc_wrapper (dast_sz size)             { return test_malloc((size_t)size); }
+static void* test_realloc_wrapper(void* block, dast_sz size){ return test_realloc(block, (size_t)size); }
+static void  test_free_wrapper   (void* block)              {        test_free(block); }
+
+/* Number of keys hashed by `test_counting_hash` */
+static dast_sz test_hash_calls = 0;
+
+static dast_hash_t test_counting_hash(const void* data, dast_sz len){
+    test_hash_calls++;
+    return hashmap_wyhash64_hash(data, len);
+}
+
+static dast_hash_t test_constant_hash(const void* data, dast_sz len){
+    (void)data, (void)len;
+    return 7;
+}
+
+/* Every third key is longer than `HASHMAP_SMALL_KEY_SIZE` */
+static dast_sz test_make_key(char* buf, dast_u64 i){
+    dast_sz len = (i % 3 == 0) ? LONG_KEY_SIZE : sizeof(dast_u64) + i % 5;
+    memset(buf, 'k', len);
+    memcpy(buf, &i, sizeof(dast_u64));
+    return len;
+}
+
+/* PUBLIC FUNCTIONS */
+
+void test_frozenmap_freeze_get(void** state){
+    (void)state;
+    static dast_u64 values[N_KEYS];
+    char key[LONG_KEY_SIZE];
+    hashmap_t map;
+    frozenmap_t frozen;
+
+    hashmap_init_custom(&map, 10, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    for (dast_u64 i = 0; i != N_KEYS; ++i) {
+        values[i] = i * 7;
+        hashmap_setb(&map, key, test_make_key(key, i), &values[i]);
+    }
+    hashmap_set(&map, string_scoped_lit("apple"), &values[1]);
+
+    /* The hashes stored in the map are used */
+    test_hash_calls = 0;
+    assert_ptr_equal(hashmap_freeze(&frozen, &map), &frozen);
+    assert_int_equal(test_hash_calls, 0);
+    assert_int_equal(frozenmap_count(&frozen), N_KEYS + 1);
+
+    /* The frozen map has its own copy of the keys */
+    hashmap_uninit(&map);
+
+    for (dast_u64 i = 0; i != N_KEYS; ++i) {
+        dast_sz len = test_make_key(key, i);
+        dast_u64* value = frozenmap_getb(&frozen, key, len);
+        assert_ptr_equal(value, &values[i]);
+        assert_true(frozenmap_has_keyb(&frozen, key, len));
+        /* Same bytes with a different length */
+        assert_null(frozenmap_getb(&frozen, key, len - 1));
+    }
+    for (dast_u64 i = N_KEYS; i != 3 * N_KEYS; ++i) {
+        assert_null(frozenmap_getb(&frozen, key, test_make_key(key, i)));
+        assert_false(frozenmap_has_keyb(&frozen, key, test_make_key(key, i)));
+    }
+
+    assert_ptr_equal(frozenmap_get(&frozen, string_scoped_lit("apple")), &values[1]);
+    assert_true(frozenmap_has_key(&frozen, string_scoped_lit("apple")));
+    assert_false(frozenmap_has_key(&frozen, string_scoped_lit("pear")));
+    assert_null(frozenmap_getb(&frozen, dast_null, 4));
+
+    /* Smaller than the map it was built from */
+    assert_true(frozen.bytes < (N_KEYS + 1) * sizeof(hashmap_entry_t));
+
+    frozenmap_uninit(&frozen);
+    assert_int_equal(frozenmap_count(&frozen), 0);
+    assert_null(frozenmap_get(&frozen, string_scoped_lit("apple")));
+    frozenmap_uninit(&frozen);
+}
+
+void test_frozenmap_values(void** state){
+    (void)state;
+    char key[LONG_KEY_SIZE];
+    hashmap_t map;
+    frozenmap_t frozen;
+
+    /* Values stored inside the entries of the map are copied, with the open engine */
+    hashmap_init_config(&map, (hashmap_config_t){
+        .alloc = TEST_ALLOCATOR, .engine = HASHMAP_ENGINE_OPEN, .value_size = 3 * sizeof(dast_u32)
+    });
+    for (dast_u32 i = 0; i != N_KEYS; ++i) {
+        dast_u32 value[3] = {i, i + 1, i + 2};
+        hashmap_setb(&map, key, test_make_key(key, i), value);
+    }
+
+    assert_ptr_equal(hashmap_freeze(&frozen, &map), &frozen);
+    hashmap_uninit(&map);
+    assert_int_equal(frozen.value_size, 3 * sizeof(dast_u32));
+
+    for (dast_u32 i = 0; i != N_KEYS; ++i) {
+        dast_u32* value = frozenmap_getb(&frozen, key, test_make_key(key, i));
+        assert_non_null(value);
+        assert_int_equal(value[0], i);
+        assert_int_equal(value[1], i + 1);
+        assert_int_equal(value[2], i + 2);
+    }
+    frozenmap_uninit(&frozen);
+}
+
+void test_frozenmap_slots(void** state){
+    (void)state;
+    static dast_u64 values[N_KEYS];
+    char key[LONG_KEY_SIZE];
+    hashmap_t map;
+    frozenmap_t frozen;
+
+    hashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    for (dast_u64 i = 0; i != N_KEYS; ++i) {
+        values[i] = i;
+        hashmap_setb(&map, key, test_make_key(key, i), &values[i]);
+    }
+    assert_non_null(hashmap_freeze(&frozen, &map));
+    hashmap_uninit(&map);
+
+    /* Every slot holds a key, and each key is held by one slot */
+    dast_u8 seen[N_KEYS] = {0};
+    for (dast_sz s = 0; s != frozenmap_count(&frozen); ++s) {
+        dast_sz len;
+        void* value;
+        const char* k = frozenmap_slot(&frozen, s, &len, &value);
+        assert_non_null(k);
+
+        dast_u64 i;
+        memcpy(&i, k, sizeof(i));
+        assert_true(i < N_KEYS);
+        assert_int_equal(len, test_make_key(key, i));
+        assert_memory_equal(k, key, len);
+        assert_ptr_equal(value, &values[i]);
+        assert_false(seen[i]);
+        seen[i] = 1;
+    }
+    assert_null(frozenmap_slot(&frozen, N_KEYS, dast_null, dast_null));
+    frozenmap_uninit(&frozen);
+}
+
+void test_frozenmap_empty(void** state){
+    (void)state;
+    hashmap_t map;
+    frozenmap_t frozen;
+
+    hashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    assert_ptr_equal(hashmap_freeze(&frozen, &map), &frozen);
+    assert_int_equal(frozenmap_count(&frozen), 0);
+    assert_null(frozenmap_get(&frozen, string_scoped_lit("apple")));
+    assert_false(frozenmap_has_key(&frozen, string_scoped_lit("apple")));
+    frozenmap_uninit(&frozen);
+
+    /* A single key */
+    int x = 1;
+    hashmap_set(&map, string_scoped_lit("apple"), &x);
+    assert_ptr_equal(hashmap_freeze(&frozen, &map), &frozen);
+    assert_ptr_equal(frozenmap_get(&frozen, string_scoped_lit("apple")), &x);
+    assert_null(frozenmap_get(&frozen, string_scoped_lit("pear")));
+    frozenmap_uninit(&frozen);
+
+    hashmap_uninit(&map);
+    assert_null(hashmap_freeze(&frozen, &map));
+    assert_null(hashmap_freeze(&frozen, dast_null));
+}
+
+void test_frozenmap_same_hash(void** state){
+    (void)state;
+    int x = 1, y = 2;
+    hashmap_t map;
+    frozenmap_t frozen;
+
+    /* Keys with the same hash are placed by a hash of their bytes */
+    hashmap_init_custom(&map, 10, TEST_ALLOCATOR, test_constant_hash, dast_null);
+    hashmap_set(&map, string_scoped_lit("apple"), &x);
+    hashmap_set(&map, string_scoped_lit("pear"), &y);
+    assert_ptr_equal(hashmap_freeze(&frozen, &map), &frozen);
+    assert_true(frozen.hash_keys);
+    hashmap_uninit(&map);
+
+    assert_int_equal(frozenmap_count(&frozen), 2);
+    assert_ptr_equal(frozenmap_get(&frozen, string_scoped_lit("apple")), &x);
+    assert_ptr_equal(frozenmap_get(&frozen, string_scoped_lit("pear")), &y);
+    assert_null(frozenmap_get(&frozen, string_scoped_lit("plum")));
+    frozenmap_uninit(&frozen);
+}
+
+void test_frozenmap_sequential_keys(void** state){
+    (void)state;
+    hashmap_t map;
+    frozenmap_t frozen;
+
+    /* Sequential integers with the default hash, some of which get the same hash */
+    assert_non_null(hashmap_init_custom(&map, 0, TEST_ALLOCATOR, dast_null, dast_null));
+    for (dast_u64 i = 0; i != N_SEQUENTIAL_KEYS; ++i) {
+        hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+    }
+    assert_ptr_equal(hashmap_freeze(&frozen, &map), &frozen);
+    hashmap_uninit(&map);
+
+    assert_int_equal(frozenmap_count(&frozen), N_SEQUENTIAL_KEYS);
+    for (dast_u64 i = 0; i != N_SEQUENTIAL_KEYS; ++i) {
+        assert_ptr_equal(frozenmap_getb(&frozen, &i, sizeof(i)), (void*)(dast_sz)(i + 1));
+    }
+    for (dast_u64 i = N_SEQUENTIAL_KEYS; i != N_SEQUENTIAL_KEYS + 1000; ++i) {
+        assert_null(frozenmap_getb(&frozen, &i, sizeof(i)));
+    }
+    frozenmap_uninit(&frozen);
+}
@@ -0,0 +1,31 @@
+#ifndef TEST_FROZENMAP_H
+#define TEST_FROZENMAP_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "frozenmap.h"
+
+
+#define TEST_GROUP_FROZENMAP \
+    cmocka_unit_test(test_frozenmap_freeze_get), \
+    cmocka_unit_test(test_frozenmap_values), \
+    cmocka_unit_test(test_frozenmap_slots), \
+    cmocka_unit_test(test_frozenmap_empty), \
+    cmocka_unit_test(test_frozenmap_same_hash), \
+    cmocka_unit_test(test_frozenmap_sequential_keys)
+
+
+void test_frozenmap_freeze_get(void** state);
+void test_frozenmap_values(void** state);
+void test_frozenmap_slots(void** state);
+void test_frozenmap_empty(void** state);
+void test_frozenmap_same_hash(void** state);
+void test_frozenmap_sequential_keys(void** state);
+
+
+#endif /* TEST_FROZENMAP_H */
@@ -0,0 +1,175 @@
+#include "test_hashimage.h"
+
+
+/* CONSTANTS */
+
+#define N_KEYS 1000
+
+#define TEST_ALLOCATOR (dast_allocator_t){.alloc=test_malloc_wrapper, .realloc=test_realloc_wrapper, .free=test_free_wrapper}
+
+/* STATIC FUNCTIONS */
+
+static void* test_malloc_wrapper (dast_sz size)             { return test_malloc((size_t)size); }
+static void* test_realloc_wrapper(void* block, dast_sz size){ return test_realloc(block, (size_t)size); }
+static void  test_free_wrapper   (void* block)              {        test_free(block); }
+
+static dast_sz test_u64_size(const void* value){ (void)value; return sizeof(dast_u64); }
+static dast_sz test_str_size(const void* value){ return strlen(value) + 1; }
+
+/* Image buffer, aligned to 8 bytes */
+static dast_u64 test_buf[16384];
+
+/** Fills a map with keys `0..N_KEYS-1`, each holding a pointer to its own number squared */
+static void test_hashimage_fill(hashmap_t* map, dast_u64* values){
+    for (dast_u64 i = 0; i != N_KEYS; ++i) {
+        values[i] = i * i;
+        hashmap_setb(map, &i, sizeof(i), &values[i]);
+    }
+}
+
+/** Checks that an image holds the keys of `test_hashimage_fill`, and no others */
+static void test_hashimage_check(hashimage_t* image){
+    assert_int_equal(hashimage_count(image), N_KEYS);
+    for (dast_u64 i = 0; i != N_KEYS; ++i) {
+        dast_sz len = 0;
+        const dast_u64* value = hashimage_getb_sized(image, &i, sizeof(i), &len);
+        assert_non_null(value);
+        assert_int_equal(len, sizeof(dast_u64));
+        assert_int_equal(*value, i * i);
+        assert_true(hashimage_has_keyb(image, &i, sizeof(i)));
+    }
+    for (dast_u64 i = N_KEYS; i != 2 * N_KEYS; ++i) {
+        assert_false(hashimage_has_keyb(image, &i, sizeof(i)));
+        assert_null(hashimage_getb(image, &i, sizeof(i)));
+    }
+}
+
+/* PUBLIC FUNCTIONS */
+
+void test_hashimage_write_open(void** state){
+    (void)state;
+    static dast_u64 values[N_KEYS];
+    hashmap_t map;
+    hashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    test_hashimage_fill(&map, values);
+
+    dast_sz size = hashimage_size(&map, test_u64_size);
+    assert_true(size > 0 && size <= sizeof(test_buf));
+    assert_int_equal(hashimage_write(&map, test_u64_size, test_buf, sizeof(test_buf)), size);
+
+    /* Too small a buffer */
+    assert_int_equal(hashimage_write(&map, test_u64_size, test_buf, size - 1), 0);
+    assert_int_equal(hashimage_write(&map, test_u64_size, test_buf, sizeof(test_buf)), size);
+    hashmap_uninit(&map);
+
+    /* The image does not depend on the map */
+    hashimage_t image;
+    assert_ptr_equal(hashimage_open(&image, test_buf, size, dast_null, dast_null), &image);
+    test_hashimage_check(&image);
+    hashimage_close(&image);
+    assert_null(image.data);
+}
+
+void test_hashimage_values(void** state){
+    (void)state;
+    hashmap_t map;
+    hashmap_init_custom(&map, 10, TEST_ALLOCATOR, hashmap_wyhash64_hash, dast_null);
+    hashmap_set(&map, string_scoped_lit("short"), "a");
+    hashmap_set(&map, string_scoped_lit("a key longer than the small key buffer of an entry"), "a longer value");
+    hashmap_set(&map, string_scoped_lit("null"), dast_null);
+
+    dast_sz size = hashimage_write(&map, test_str_size, test_buf, sizeof(test_buf));
+    assert_true(size > 0);
+    hashmap_uninit(&map);
+
+    hashimage_t image;
+    assert_non_null(hashimage_open(&image, test_buf, size, hashmap_wyhash64_hash, dast_null));
+    assert_string_equal((const char*)hashimage_get(&image, string_scoped_lit("short")), "a");
+    assert_string_equal((const char*)hashimage_get(&image, string_scoped_lit("a key longer than the small key buffer of an entry")), "a longer value");
+    assert_true(((dast_sz)hashimage_get(&image, string_scoped_lit("short")) & 7) == 0);
+
+    /* NULL values are kept as keys */
+    assert_true(hashimage_has_key(&image, string_scoped_lit("null")));
+    assert_null(hashimage_get(&image, string_scoped_lit("null")));
+    assert_false(hashimage_has_key(&image, string_scoped_lit("missing")));
+    hashimage_close(&image);
+
+    /* Empty maps */
+    hashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    size = hashimage_write(&map, dast_null, test_buf, sizeof(test_buf));
+    hashmap_uninit(&map);
+    assert_non_null(hashimage_open(&image, test_buf, size, dast_null, dast_null));
+    assert_int_equal(hashimage_count(&image), 0);
+    assert_false(hashimage_has_key(&image, string_scoped_lit("short")));
+}
+
+void test_hashimage_invalid(void** state){
+    (void)state;
+    hashmap_t map;
+    hashimage_t image;
+    hashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    hashmap_set(&map, string_scoped_lit("key"), "value");
+    dast_sz size = hashimage_write(&map, test_str_size, test_buf, sizeof(test_buf));
+    hashmap_uninit(&map);
+
+    assert_null(hashimage_open(dast_null, test_buf, size, dast_null, dast_null));
+    assert_null(hashimage_open(&image, dast_null, size, dast_null, dast_null));
+    assert_null(hashimage_open(&image, test_buf, sizeof(hashimage_header_t) - 1, dast_null, dast_null));
+
+    /* Truncated, or built with another hashing function */
+    assert_null(hashimage_open(&image, test_buf, size - 8, dast_null, dast_null));
+    assert_null(hashimage_open(&image, test_buf, size, hashmap_wyhash64_hash, dast_null));
+
+    /* Corrupted header */
+    hashimage_header_t* header = (hashimage_header_t*)test_buf;
+    header->slots = 3;
+    assert_null(hashimage_open(&image, test_buf, size, dast_null, dast_null));
+    header->slots = (dast_u64)1 << 60;
+    assert_null(hashimage_open(&image, test_buf, size, dast_null, dast_null));
+    header->magic[0] = 'X';
+    assert_null(hashimage_open(&image, test_buf, size, dast_null, dast_null));
+
+    /* Closed views find nothing */
+    assert_null(image.data);
+    assert_null(hashimage_get(&image, string_scoped_lit("key")));
+    hashimage_close(dast_null);
+}
+
+void test_hashimage_open_engine(void** state){
+    (void)state;
+    static dast_u64 values[N_KEYS];
+    hashmap_t map;
+    hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = 10, .alloc = TEST_ALLOCATOR, .engine = HASHMAP_ENGINE_OPEN
+    });
+    test_hashimage_fill(&map, values);
+    dast_sz size = hashimage_write(&map, test_u64_size, test_buf, sizeof(test_buf));
+    assert_true(size > 0);
+    hashmap_uninit(&map);
+
+    hashimage_t image;
+    assert_non_null(hashimage_open(&image, test_buf, size, dast_null, dast_null));
+    test_hashimage_check(&image);
+}
+
+void test_hashimage_file(void** state){
+    (void)state;
+#ifndef DAST_NO_STDLIB
+    static dast_u64 values[N_KEYS];
+    const char* path = "test_hashimage.dat";
+    hashmap_t map;
+    hashmap_init_custom(&map, 10, TEST_ALLOCATOR, dast_null, dast_null);
+    test_hashimage_fill(&map, values);
+    assert_true(hashimage_save(&map, test_u64_size, path));
+    hashmap_uninit(&map);
+
+    hashimage_t image;
+    assert_ptr_equal(hashimage_map(&image, path, dast_null, dast_null), &image);
+    test_hashimage_check(&image);
+    hashimage_close(&image);
+
+    assert_null(hashimage_map(&image, path, hashmap_wyhash64_hash, dast_null));
+    remove(path);
+    assert_null(hashimage_map(&image, path, dast_null, dast_null));
+#endif
+}
@@ -0,0 +1,29 @@
+#ifndef TEST_HASHIMAGE_H
+#define TEST_HASHIMAGE_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "hashimage.h"
+
+
+#define TEST_GROUP_HASHIMAGE \
+    cmocka_unit_test(test_hashimage_write_open), \
+    cmocka_unit_test(test_hashimage_values), \
+    cmocka_unit_test(test_hashimage_invalid), \
+    cmocka_unit_test(test_hashimage_open_engine), \
+    cmocka_unit_test(test_hashimage_file)
+
+
+void test_hashimage_write_open(void** state);
+void test_hashimage_values(void** state);
+void test_hashimage_invalid(void** state);
+void test_hashimage_open_engine(void** state);
+void test_hashimage_file(void** state);
+
+
+#endif /* TEST_HASHIMAGE_H */
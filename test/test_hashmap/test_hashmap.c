@@ -8,6 +8,7 @@
 #define ACTUAL_START_SIZE 13
 
 #define TEST_ALLOCATOR (dast_allocator_t){.alloc=test_malloc_wrapper, .realloc=test_realloc_wrapper, .free=test_free_wrapper}
+#define TEST_COUNTING_ALLOCATOR (dast_allocator_t){.alloc=test_counting_malloc, .realloc=test_realloc_wrapper, .free=test_free_wrapper}
 
 /* STATIC FUNCTIONS */
 
@@ -15,13 +16,36 @@ static void* test_malloc_wrapper (dast_sz size)             { return test_malloc
 static void* test_realloc_wrapper(void* block, dast_sz size){ return test_realloc(block, (size_t)size); }
 static void  test_free_wrapper   (void* block)              {        test_free(block); }
 
-static dast_u64 test_hash_fn(const void* data, dast_sz len){ (void) data, (void) len; return 0; }
+static dast_sz test_alloc_count = 0;
+static void* test_counting_malloc(dast_sz size){ test_alloc_count++; return test_malloc((size_t)size); }
+
+static dast_hash_t test_hash_fn(const void* data, dast_sz len){ (void) data, (void) len; return 0; }
 
 static dast_bool test_key_u64_eq(const void* a, const void* b, dast_sz sz){
     assert_int_equal(sz, sizeof(dast_u64));
     return *(dast_u64*)a == *(dast_u64*)b;
 }
 
+/* Expected value of a built-in 64-bit hashing function, whose halves are xored together with 32-bit hashes */
+#ifdef DAST_HASH_64BIT
+    #define TEST_HASH64(H) ((dast_hash_t)(H))
+#else
+    #define TEST_HASH64(H) ((dast_hash_t)((H) ^ ((H) >> 32)))
+#endif
+
+static dast_sz test_hash_calls = 0;
+static dast_hash_t test_counting_hash_fn(const void* data, dast_sz len){
+    test_hash_calls++;
+    assert_int_equal(len, sizeof(dast_u64));
+    return *(const dast_u64*)data;
+}
+
+static dast_sz test_eq_calls = 0;
+static dast_bool test_counting_eq_fn(const void* a, const void* b, dast_sz len){
+    test_eq_calls++;
+    return dast_memeq(a, b, len);
+}
+
 /* PUBLIC FUNCTIONS */
 
 void test_hashmap_init_free(void** state){
@@ -76,7 +100,7 @@ void test_hashmap_init_custom_default(void** state){
     hashmap_init_custom(&map, START_SIZE, (dast_allocator_t){0}, NULL, NULL);
     
     assert_memory_equal(&map.alloc, &DAST_DEFAULT_ALLOCATOR, sizeof(dast_allocator_t));
-    assert_ptr_equal(map.hash_fn, hashmap_FNV1a64_hash);
+    assert_ptr_equal(map.hash_fn, HASHMAP_DEFAULT_HASH);
     assert_ptr_equal(map.eq_fn, dast_memeq);
     
     hashmap_uninit(&map);
@@ -89,7 +113,7 @@ void test_hashmap_init_custom_alloc(void** state){
     hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, NULL, NULL);
     
     assert_memory_equal(&map.alloc, &TEST_ALLOCATOR, sizeof(dast_allocator_t));
-    assert_ptr_equal(map.hash_fn, hashmap_FNV1a64_hash);
+    assert_ptr_equal(map.hash_fn, HASHMAP_DEFAULT_HASH);
     assert_ptr_equal(map.eq_fn, dast_memeq);
     
     hashmap_uninit(&map);
@@ -329,3 +353,1268 @@ void test_hashmap_iter_str(void** state){
     hashmap_uninit(&map); 
 }
 
+void test_hashmap_open_init(void** state){
+    (void)state;
+    hashmap_t map;
+    void* result = hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .engine = HASHMAP_ENGINE_OPEN
+    });
+
+    assert_non_null(result);
+    assert_int_equal(map.engine, HASHMAP_ENGINE_OPEN);
+    assert_int_equal(map.size, 16); /* Next power of two */
+    assert_non_null(map.ctrl);
+    assert_non_null(map.slots);
+    assert_null(map.table);
+    assert_int_equal(map.entries, 0);
+
+    hashmap_uninit(&map);
+
+    assert_null(map.slots);
+    assert_null(map.ctrl);
+    assert_int_equal(map.size, 0);
+}
+
+void test_hashmap_open_setb_getb(void** state){
+    (void)state;
+    const dast_sz nkeys = 100;
+    int values[100];
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .alloc = TEST_ALLOCATOR, .engine = HASHMAP_ENGINE_OPEN
+    });
+
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        assert_ptr_equal(hashmap_setb(&map, &i, sizeof(i), &values[i]), &map);
+    }
+    assert_int_equal(map.entries, nkeys);
+    assert_true(map.entries * HASHMAP_OPEN_MAX_LOAD_DEN <= map.size * HASHMAP_OPEN_MAX_LOAD_NUM);
+
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        assert_ptr_equal(hashmap_getb(&map, &i, sizeof(i)), &values[i]);
+    }
+    dast_u64 missing = nkeys;
+    assert_false(hashmap_has_keyb(&map, &missing, sizeof(missing)));
+
+    /* Replacing a value does not add an entry */
+    dast_u64 key = 0;
+    hashmap_setb(&map, &key, sizeof(key), &values[1]);
+    assert_ptr_equal(hashmap_getb(&map, &key, sizeof(key)), &values[1]);
+    assert_int_equal(map.entries, nkeys);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_open_collisions(void** state){
+    (void)state;
+    const dast_sz nkeys = 40;
+    hashmap_t map;
+
+    /* Every key has the same hash, and so they all share one probe sequence */
+    hashmap_init_config(&map, (hashmap_config_t){
+        .alloc = TEST_ALLOCATOR, .hash_fn = test_hash_fn, .eq_fn = test_key_u64_eq,
+        .engine = HASHMAP_ENGINE_OPEN
+    });
+
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+    }
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        assert_ptr_equal(hashmap_getb(&map, &i, sizeof(i)), (void*)(dast_sz)(i + 1));
+    }
+    assert_int_equal(map.entries, nkeys);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_open_iterb(void** state){
+    (void)state;
+
+    dast_sz nkeys = 3;
+    const char* keys[] = {"key1", "key2", "key3"};
+    dast_sz key_len = 5;
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .alloc = TEST_ALLOCATOR, .engine = HASHMAP_ENGINE_OPEN
+    });
+    hashmap_setb(&map, keys[2], key_len, NULL);
+    hashmap_setb(&map, keys[1], key_len, NULL);
+    hashmap_setb(&map, keys[0], key_len, NULL);
+
+    char* k = NULL;
+    dast_sz s, counter = 0, seen = 0;
+
+    while( (k = hashmap_iterb(&map, k, &s)) ){
+        assert_int_equal(s, key_len);
+        for(dast_sz i = 0; i != nkeys; ++i){
+            if (memcmp(k, keys[i], key_len) == 0){
+                seen |= (dast_sz)1 << i;
+            }
+        }
+        counter++;
+    }
+    assert_int_equal(counter, nkeys);
+    assert_int_equal(seen, 7);
+    
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_setb_small_key(void** state){
+    (void)state;
+    const char key[HASHMAP_SMALL_KEY_SIZE] = "small key";
+    int data = 99;
+    hashmap_t map;
+
+    hashmap_init_custom(&map, START_SIZE, TEST_COUNTING_ALLOCATOR, dast_null, dast_null);
+
+    /* Entry and key share a single allocation */
+    test_alloc_count = 0;
+    hashmap_setb(&map, key, sizeof(key), &data);
+    assert_int_equal(test_alloc_count, 1);
+
+    assert_ptr_equal(hashmap_getb(&map, key, sizeof(key)), &data);
+    dast_sz len;
+    char* k = hashmap_iterb(&map, dast_null, &len);
+    assert_int_equal(len, sizeof(key));
+    assert_ptr_equal(k, map.table[(dast_sz)(HASHMAP_DEFAULT_HASH(key, sizeof(key)) % (dast_hash_t)map.size)]->small_key);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_setb_long_key(void** state){
+    (void)state;
+    char key[HASHMAP_SMALL_KEY_SIZE * 4];
+    int data = 99;
+    hashmap_t map;
+
+    memset(key, 'k', sizeof(key));
+    hashmap_init_custom(&map, START_SIZE, TEST_COUNTING_ALLOCATOR, dast_null, dast_null);
+
+    test_alloc_count = 0;
+    hashmap_setb(&map, key, sizeof(key), &data);
+    assert_int_equal(test_alloc_count, 2);
+    assert_ptr_equal(hashmap_getb(&map, key, sizeof(key)), &data);
+
+    /* Keys differing only past the inline size are distinct */
+    key[sizeof(key) - 1] = 'x';
+    assert_false(hashmap_has_keyb(&map, key, sizeof(key)));
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_open_keys_survive_growth(void** state){
+    (void)state;
+    char keys[64][HASHMAP_SMALL_KEY_SIZE + 8];
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .alloc = TEST_ALLOCATOR, .engine = HASHMAP_ENGINE_OPEN
+    });
+
+    /* Mix of inline and heap-allocated keys, moved to new slots as the table grows */
+    for(dast_sz i = 0; i != 64; ++i){
+        memset(keys[i], (int)i, sizeof(keys[i]));
+        hashmap_setb(&map, keys[i], (i % 2) ? sizeof(keys[i]) : 8, &keys[i]);
+    }
+    for(dast_sz i = 0; i != 64; ++i){
+        assert_ptr_equal(hashmap_getb(&map, keys[i], (i % 2) ? sizeof(keys[i]) : 8), &keys[i]);
+    }
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_stored_hash(void** state){
+    (void)state;
+    const dast_u64 nkeys = 200;
+    hashmap_t map;
+
+    /* Keys are their own hash, so many of them share a bucket */
+    hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, test_counting_hash_fn, test_counting_eq_fn);
+
+    test_hash_calls = 0;
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        hashmap_setb(&map, &i, sizeof(i), dast_null);
+    }
+    /* One hash per insert, none when resizing */
+    assert_int_equal(test_hash_calls, nkeys);
+    assert_true(map.size > START_SIZE);
+
+    /* Only the matching entry of each chain is compared */
+    test_eq_calls = 0;
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        assert_true(hashmap_has_keyb(&map, &i, sizeof(i)));
+    }
+    assert_int_equal(test_eq_calls, nkeys);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_open_stored_hash(void** state){
+    (void)state;
+    const dast_u64 nkeys = 200;
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .alloc = TEST_ALLOCATOR, .hash_fn = test_counting_hash_fn, .eq_fn = test_counting_eq_fn,
+        .engine = HASHMAP_ENGINE_OPEN
+    });
+
+    test_hash_calls = 0;
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        hashmap_setb(&map, &i, sizeof(i), dast_null);
+    }
+    assert_int_equal(test_hash_calls, nkeys);
+
+    test_eq_calls = 0;
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        assert_true(hashmap_has_keyb(&map, &i, sizeof(i)));
+    }
+    assert_int_equal(test_eq_calls, nkeys);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_incremental_resize(void** state){
+    (void)state;
+    const dast_u64 nkeys = 500;
+    dast_bool migrating = dast_false;
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .rehash_budget = 2
+    });
+    assert_int_equal(map.rehash_budget, 2);
+
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+        migrating |= map.old_table != dast_null;
+
+        /* Keys remain reachable whether or not their bucket has been moved */
+        for(dast_u64 j = 0; j <= i; j += 7){
+            assert_ptr_equal(hashmap_getb(&map, &j, sizeof(j)), (void*)(dast_sz)(j + 1));
+        }
+    }
+    assert_true(migrating);
+    assert_int_equal(map.entries, nkeys);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_incremental_iterb(void** state){
+    (void)state;
+    const dast_u64 nkeys = 100;
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .rehash_budget = 1
+    });
+
+    /* Stop right after a resize has started */
+    dast_u64 i = 0;
+    while(!map.old_table || map.migrated == 0){
+        hashmap_setb(&map, &i, sizeof(i), dast_null);
+        i++;
+    }
+    assert_true(i < nkeys);
+
+    /* Iteration covers both tables */
+    char* k = NULL;
+    dast_sz len, counter = 0;
+    while( (k = hashmap_iterb(&map, k, &len)) ){
+        assert_int_equal(len, sizeof(dast_u64));
+        counter++;
+    }
+    assert_int_equal(counter, i);
+
+    /* Leftover buckets can be moved explicitly */
+    while(hashmap_rehash_step(&map, 1));
+    assert_null(map.old_table);
+    for(dast_u64 j = 0; j != i; ++j){
+        assert_true(hashmap_has_keyb(&map, &j, sizeof(j)));
+    }
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_incremental_uninit(void** state){
+    (void)state;
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .rehash_budget = 1
+    });
+
+    dast_u64 i = 0;
+    while(!map.old_table){
+        hashmap_setb(&map, &i, sizeof(i), dast_null);
+        i++;
+    }
+
+    /* Entries in both tables are freed */
+    hashmap_uninit(&map);
+    assert_null(map.table);
+    assert_null(map.old_table);
+}
+
+void test_hashmap_pow2_init(void** state){
+    (void)state;
+    hashmap_t map;
+    void* result = hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .sizing = HASHMAP_SIZING_POW2
+    });
+
+    assert_non_null(result);
+    assert_int_equal(map.sizing, HASHMAP_SIZING_POW2);
+    assert_int_equal(map.size, 16);
+    assert_non_null(map.table);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_pow2_growth(void** state){
+    (void)state;
+    const dast_u64 nkeys = 1000;
+    const dast_sz budgets[] = { 0, HASHMAP_MIN_REHASH_BUDGET };
+
+    for(dast_sz b = 0; b != 2; ++b){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .alloc = TEST_ALLOCATOR, .sizing = HASHMAP_SIZING_POW2, .rehash_budget = budgets[b]
+        });
+
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+            assert_int_equal(map.size & (map.size - 1), 0);
+        }
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            assert_ptr_equal(hashmap_getb(&map, &i, sizeof(i)), (void*)(dast_sz)(i + 1));
+        }
+
+        char* k = NULL;
+        dast_sz len, counter = 0;
+        while( (k = hashmap_iterb(&map, k, &len)) ) counter++;
+        assert_int_equal(counter, nkeys);
+
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_wyhash64_hash(void** state){
+    (void)state;
+    assert_true(hashmap_wyhash64_hash("", 0) == TEST_HASH64(0xfa303abc2b1d7630));
+    assert_true(hashmap_wyhash64_hash("a", 1) == TEST_HASH64(0xc80a9828e7db8439));
+    assert_true(hashmap_wyhash64_hash("hello world", 11) == TEST_HASH64(0x8307142d36253791));
+    assert_true(hashmap_wyhash64_hash("0123456789abcdefg", 17) == TEST_HASH64(0xd60057c8091c56ea));
+    assert_true(hashmap_wyhash64_hash(
+        "The quick brown fox jumps over the lazy dog, the quick brown fox jumps!", 71
+    ) == TEST_HASH64(0xb13e48e1cab8bd94));
+
+    /* The seeded variant keeps all 64 bits, and a seed of zero gives the unseeded hash */
+    assert_true(hashmap_wyhash64_seeded("hello world", 11, 0) == 0x8307142d36253791);
+    assert_true(hashmap_wyhash64_seeded("hello world", 11, 1) != 0x8307142d36253791);
+}
+
+void test_hashmap_fnv1a32_hash(void** state){
+    (void)state;
+    assert_true(hashmap_FNV1a32_hash("", 0) == 0x811c9dc5);
+    assert_true(hashmap_FNV1a32_hash("a", 1) == 0xe40c292c);
+    assert_true(hashmap_FNV1a32_hash("foobar", 6) == 0xbf9cf968);
+    assert_true(hashmap_FNV1a32_hash("\xff", 1) != hashmap_FNV1a32_hash("\x7f", 1));
+
+#if !defined(DAST_HASH_64BIT) && defined(DAST_64BIT)
+    /* The length packs with the 32-bit hash */
+    assert_int_equal(sizeof(hashmap_entry_t), 64);
+#endif
+}
+
+void test_hashmap_crc32c_hash(void** state){
+    (void)state;
+    /* Same values with and without the hardware instruction */
+    assert_true(hashmap_crc32c_hash("", 0) == TEST_HASH64(0x9e69316645315758));
+    assert_true(hashmap_crc32c_hash("a", 1) == TEST_HASH64(0x72fd4226106789e4));
+    assert_true(hashmap_crc32c_hash("hello world", 11) == TEST_HASH64(0x2a3eb90eb042e2d7));
+    assert_true(hashmap_crc32c_hash("0123456789abcdefg", 17) == TEST_HASH64(0x402862dd97e4a872));
+    assert_true(hashmap_crc32c_hash(
+        "The quick brown fox jumps over the lazy dog, the quick brown fox jumps!", 71
+    ) == TEST_HASH64(0x06c90765e3ec4819));
+}
+
+void test_hashmap_word_hash_lengths(void** state){
+    (void)state;
+    const hashmap_hashfn_t fns[] = { hashmap_wyhash64_hash, hashmap_crc32c_hash };
+    const dast_sz max_len = 64;
+
+    for(dast_sz f = 0; f != 2; ++f){
+        dast_u64 prev = 0;
+        for(dast_sz len = 0; len <= max_len; ++len){
+            /* Exact-size buffers, so reads past the key are caught by sanitizers */
+            char* key = test_malloc(len ? len : 1);
+            memset(key, 'x', len);
+            dast_u64 h = fns[f](key, len);
+            assert_true(len == 0 || h != prev);
+            prev = h;
+
+            /* Flipping any byte changes the hash */
+            for(dast_sz i = 0; i != len; ++i){
+                key[i] ^= 1;
+                assert_true(fns[f](key, len) != h);
+                key[i] ^= 1;
+            }
+            test_free(key);
+        }
+    }
+}
+
+void test_hashmap_word_hash_map(void** state){
+    (void)state;
+    const hashmap_hashfn_t fns[] = { hashmap_wyhash64_hash, hashmap_crc32c_hash };
+    const dast_u64 nkeys = 500;
+
+    for(dast_sz f = 0; f != 2; ++f){
+        hashmap_t map;
+        hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, fns[f], dast_null);
+
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+        }
+        assert_int_equal(map.entries, nkeys);
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            assert_ptr_equal(hashmap_getb(&map, &i, sizeof(i)), (void*)(dast_sz)(i + 1));
+        }
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_cursor(void** state){
+    (void)state;
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    const dast_u64 nkeys = 200;
+
+    for(dast_sz e = 0; e != 2; ++e){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .engine = engines[e]
+        });
+
+        /* Empty map */
+        hashmap_cursor_t cursor = {0};
+        assert_false(hashmap_cursor_next(&map, &cursor));
+
+        dast_u8 seen[200] = {0};
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+        }
+
+        /* Every entry is visited once, with its key and value */
+        dast_sz counter = 0;
+        cursor = (hashmap_cursor_t){0};
+        while( hashmap_cursor_next(&map, &cursor) ){
+            dast_u64 key;
+            assert_int_equal(cursor.len, sizeof(key));
+            memcpy(&key, cursor.key, sizeof(key));
+            assert_true(key < nkeys);
+            assert_false(seen[key]);
+            seen[key] = 1;
+            assert_ptr_equal(cursor.value, (void*)(dast_sz)(key + 1));
+            counter++;
+        }
+        assert_int_equal(counter, nkeys);
+
+        /* Finished cursors stay finished */
+        assert_false(hashmap_cursor_next(&map, &cursor));
+
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_cursor_incremental(void** state){
+    (void)state;
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .rehash_budget = 1
+    });
+
+    /* Stop right after a resize has started */
+    dast_u64 i = 0;
+    while(!map.old_table || map.migrated == 0){
+        hashmap_setb(&map, &i, sizeof(i), dast_null);
+        i++;
+    }
+
+    /* Cursors cover both tables */
+    hashmap_cursor_t cursor = {0};
+    dast_sz counter = 0;
+    while( hashmap_cursor_next(&map, &cursor) ) counter++;
+    assert_int_equal(counter, i);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_getb_many(void** state){
+    (void)state;
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    const dast_u64 nkeys = 50; /* More than one batch */
+
+    for(dast_sz e = 0; e != 2; ++e){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .engine = engines[e]
+        });
+
+        /* Even keys are in the map */
+        dast_u64 keys[50];
+        const void* bkeys[50];
+        dast_sz lens[50];
+        void* values[50];
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            keys[i] = i;
+            bkeys[i] = &keys[i];
+            lens[i] = sizeof(keys[i]);
+            if(i % 2 == 0) hashmap_setb(&map, &keys[i], sizeof(keys[i]), (void*)(dast_sz)(i + 1));
+        }
+        bkeys[10] = NULL;
+
+        dast_sz found = hashmap_getb_many(&map, nkeys, bkeys, lens, values);
+        assert_int_equal(found, nkeys / 2 - 1);
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            if(i % 2 == 0 && i != 10) assert_ptr_equal(values[i], (void*)(dast_sz)(i + 1));
+            else                      assert_null(values[i]);
+        }
+
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_get_many_str(void** state){
+    (void)state;
+    hashmap_t map;
+    int x = 1, y = 2;
+
+    hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, dast_null, dast_null);
+    hashmap_set(&map, string_scoped_lit("one"), &x);
+    hashmap_set(&map, string_scoped_lit("two"), &y);
+
+    string_t keys[] = { string_scoped_lit("two"), string_scoped_lit("three"), string_scoped_lit("one") };
+    void* values[3];
+    assert_int_equal(hashmap_get_many(&map, 3, keys, values), 2);
+    assert_ptr_equal(values[0], &y);
+    assert_null(values[1]);
+    assert_ptr_equal(values[2], &x);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_hashed(void** state){
+    (void)state;
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    const dast_u64 key = 42;
+    int x = 1;
+    hashmap_t maps[2];
+
+    for(dast_sz e = 0; e != 2; ++e){
+        hashmap_init_config(&maps[e], (hashmap_config_t){
+            .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .hash_fn = test_counting_hash_fn, .engine = engines[e]
+        });
+    }
+
+    /* One hash serves every call on both maps */
+    test_hash_calls = 0;
+    dast_hash_t hash = hashmap_hashb(&maps[0], &key, sizeof(key));
+    assert_true(hash == key);
+    for(dast_sz e = 0; e != 2; ++e){
+        assert_false(hashmap_has_keyb_hashed(&maps[e], &key, sizeof(key), hash));
+        assert_non_null(hashmap_setb_hashed(&maps[e], &key, sizeof(key), hash, &x));
+        assert_true(hashmap_has_keyb_hashed(&maps[e], &key, sizeof(key), hash));
+        assert_ptr_equal(hashmap_getb_hashed(&maps[e], &key, sizeof(key), hash), &x);
+    }
+    assert_int_equal(test_hash_calls, 1);
+
+    /* Keys inserted with a precomputed hash are found by regular lookups */
+    for(dast_sz e = 0; e != 2; ++e){
+        assert_ptr_equal(hashmap_getb(&maps[e], &key, sizeof(key)), &x);
+        hashmap_uninit(&maps[e]);
+    }
+}
+
+void test_hashmap_hash_str(void** state){
+    (void)state;
+    hashmap_t map;
+    int x = 1;
+    string_t key = string_scoped_lit("key");
+
+    hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, dast_null, dast_null);
+    dast_hash_t hash = hashmap_hash(&map, key);
+    assert_true(hash == HASHMAP_DEFAULT_HASH(key.str, key.len + 1));
+
+    hashmap_setb_hashed(&map, key.str, key.len + 1, hash, &x);
+    assert_ptr_equal(hashmap_get(&map, key), &x);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_upsertb(void** state){
+    (void)state;
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    const dast_sz budgets[] = { 0, HASHMAP_MIN_REHASH_BUDGET };
+    const dast_u64 nkeys = 100, rounds = 3;
+
+    for(dast_sz c = 0; c != 3; ++c){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .hash_fn = test_counting_hash_fn,
+            .engine = engines[c / 2], .rehash_budget = budgets[c % 2]
+        });
+
+        /* Count each key, growing the map along the way */
+        test_hash_calls = 0;
+        for(dast_u64 r = 0; r != rounds; ++r){
+            for(dast_u64 i = 0; i != nkeys; ++i){
+                dast_bool inserted;
+                void** value = hashmap_upsertb(&map, &i, sizeof(i), &inserted);
+                assert_non_null(value);
+                assert_int_equal(inserted, r == 0);
+                if(inserted) assert_null(*value);
+                *value = (void*)((dast_sz)*value + 1);
+            }
+        }
+        assert_int_equal(test_hash_calls, nkeys * rounds);
+        assert_int_equal(map.entries, nkeys);
+
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            assert_ptr_equal(hashmap_getb(&map, &i, sizeof(i)), (void*)(dast_sz)rounds);
+        }
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_upsert_str(void** state){
+    (void)state;
+    hashmap_t map;
+    int x = 1;
+
+    hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, dast_null, dast_null);
+
+    void** value = hashmap_upsert(&map, string_scoped_lit("key"), dast_null);
+    assert_non_null(value);
+    *value = &x;
+
+    dast_bool inserted = dast_true;
+    assert_ptr_equal(hashmap_upsert(&map, string_scoped_lit("key"), &inserted), value);
+    assert_false(inserted);
+    assert_ptr_equal(hashmap_get(&map, string_scoped_lit("key")), &x);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_removeb(void** state){
+    (void)state;
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    const dast_u64 nkeys = 100;
+
+    for(dast_sz e = 0; e != 2; ++e){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .engine = engines[e]
+        });
+
+        char long_key[HASHMAP_SMALL_KEY_SIZE * 2] = {0};
+        hashmap_setb(&map, long_key, sizeof(long_key), long_key);
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+        }
+
+        /* Remove odd keys */
+        for(dast_u64 i = 1; i < nkeys; i += 2){
+            void* value = dast_null;
+            assert_true(hashmap_removeb(&map, &i, sizeof(i), &value));
+            assert_ptr_equal(value, (void*)(dast_sz)(i + 1));
+            assert_false(hashmap_removeb(&map, &i, sizeof(i), dast_null));
+        }
+        assert_int_equal(map.entries, nkeys / 2 + 1);
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            assert_int_equal(hashmap_has_keyb(&map, &i, sizeof(i)), i % 2 == 0);
+        }
+
+        /* Keys stored outside the entry are freed too */
+        assert_true(hashmap_removeb(&map, long_key, sizeof(long_key), dast_null));
+        assert_false(hashmap_has_keyb(&map, long_key, sizeof(long_key)));
+
+        /* Removed keys can be added again */
+        dast_u64 k = 1;
+        hashmap_setb(&map, &k, sizeof(k), dast_null);
+        assert_true(hashmap_has_keyb(&map, &k, sizeof(k)));
+
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_remove_str(void** state){
+    (void)state;
+    hashmap_t map;
+    int x = 1;
+
+    hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, dast_null, dast_null);
+    hashmap_set(&map, string_scoped_lit("key"), &x);
+
+    void* value = dast_null;
+    assert_false(hashmap_remove(&map, string_scoped_lit("other"), &value));
+    assert_true(hashmap_remove(&map, string_scoped_lit("key"), &value));
+    assert_ptr_equal(value, &x);
+    assert_int_equal(map.entries, 0);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_remove_incremental(void** state){
+    (void)state;
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .rehash_budget = 1
+    });
+
+    /* Stop right after a resize has started */
+    dast_u64 n = 0;
+    while(!map.old_table || map.migrated == 0){
+        hashmap_setb(&map, &n, sizeof(n), dast_null);
+        n++;
+    }
+
+    /* Keys are removed from whichever table holds them */
+    for(dast_u64 i = 0; i != n; ++i){
+        assert_true(hashmap_removeb(&map, &i, sizeof(i), dast_null));
+    }
+    assert_int_equal(map.entries, 0);
+    hashmap_cursor_t cursor = {0};
+    assert_false(hashmap_cursor_next(&map, &cursor));
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_open_remove_churn(void** state){
+    (void)state;
+    hashmap_t map;
+    const dast_u64 live = 40, rounds = 2000;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .alloc = TEST_ALLOCATOR, .engine = HASHMAP_ENGINE_OPEN
+    });
+
+    /* A sliding window of keys: DELETED slots must not pile up */
+    for(dast_u64 i = 0; i != rounds; ++i){
+        hashmap_setb(&map, &i, sizeof(i), dast_null);
+        if(i >= live){
+            dast_u64 old = i - live;
+            assert_true(hashmap_removeb(&map, &old, sizeof(old), dast_null));
+        }
+        assert_true(map.size <= 128);
+        assert_true((map.entries + map.deleted) * HASHMAP_OPEN_MAX_LOAD_DEN <= map.size * HASHMAP_OPEN_MAX_LOAD_NUM);
+    }
+    for(dast_u64 i = 0; i != rounds; ++i){
+        assert_int_equal(hashmap_has_keyb(&map, &i, sizeof(i)), i >= rounds - live);
+    }
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_remove_shrink(void** state){
+    (void)state;
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    const dast_sz budgets[] = { 0, HASHMAP_MIN_REHASH_BUDGET };
+    const dast_u64 nkeys = 1000;
+
+    for(dast_sz c = 0; c != 3; ++c){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR,
+            .engine = engines[c / 2], .rehash_budget = budgets[c % 2]
+        });
+        dast_sz min_size = map.size;
+
+        for(dast_u64 i = 0; i != nkeys; ++i) hashmap_setb(&map, &i, sizeof(i), dast_null);
+        dast_sz full_size = map.size;
+
+        /* Removing most keys gives memory back */
+        for(dast_u64 i = 10; i != nkeys; ++i) hashmap_removeb(&map, &i, sizeof(i), dast_null);
+        while(hashmap_rehash_step(&map, 1));
+        assert_true(map.size < full_size / 8);
+        for(dast_u64 i = 0; i != 10; ++i) assert_true(hashmap_has_keyb(&map, &i, sizeof(i)));
+
+        /* Adding and removing a key at the boundary does not resize every time */
+        dast_sz size = map.size, resizes = 0;
+        for(dast_u64 r = 0; r != 100; ++r){
+            dast_u64 k = nkeys + r;
+            hashmap_setb(&map, &k, sizeof(k), dast_null);
+            resizes += (map.size != size);
+            size = map.size;
+            hashmap_removeb(&map, &k, sizeof(k), dast_null);
+            resizes += (map.size != size);
+            size = map.size;
+        }
+        assert_true(resizes <= 1);
+
+        /* Never below the starting size */
+        for(dast_u64 i = 0; i != 10; ++i) hashmap_removeb(&map, &i, sizeof(i), dast_null);
+        while(hashmap_rehash_step(&map, 1));
+        assert_int_equal(map.entries, 0);
+        assert_int_equal(map.size, min_size);
+
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_pool(void** state){
+    (void)state;
+    const dast_u64 nkeys = 1000, slab = 64;
+    hashmap_t map;
+
+    hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = nkeys * HASHMAP_LOADING_FACTOR * 2, .alloc = TEST_COUNTING_ALLOCATOR, .pool_slab_entries = slab
+    });
+
+    /* Entries are carved from slabs */
+    test_alloc_count = 0;
+    for(dast_u64 i = 0; i != nkeys; ++i){
+        hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+    }
+    assert_int_equal(test_alloc_count, (nkeys + slab - 1) / slab);
+
+    /* Removed entries are reused */
+    for(dast_u64 i = 0; i != 10; ++i) hashmap_removeb(&map, &i, sizeof(i), dast_null);
+    test_alloc_count = 0;
+    for(dast_u64 i = nkeys; i != nkeys + 10; ++i){
+        hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+    }
+    assert_int_equal(test_alloc_count, 0);
+
+    /* Entries survive a resize */
+    hashmap_resize(&map);
+    assert_int_equal(map.pool.slab_entries, slab);
+    for(dast_u64 i = 10; i != nkeys + 10; ++i){
+        assert_ptr_equal(hashmap_getb(&map, &i, sizeof(i)), (void*)(dast_sz)(i + 1));
+    }
+
+    hashmap_uninit(&map);
+    assert_null(map.pool.slabs);
+}
+
+void test_hashmap_key_arena(void** state){
+    (void)state;
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    const dast_u64 nkeys = 100;
+    const dast_sz key_len = HASHMAP_SMALL_KEY_SIZE * 2;
+
+    for(dast_sz e = 0; e != 2; ++e){
+        hashmap_t map;
+        char key[HASHMAP_SMALL_KEY_SIZE * 2] = {0};
+        hashmap_init_config(&map, (hashmap_config_t){
+            .size_hint = nkeys * 4, .alloc = TEST_COUNTING_ALLOCATOR, .engine = engines[e],
+            .pool_slab_entries = nkeys, .key_arena_chunk = key_len * nkeys / 2
+        });
+
+        /* Long keys are packed into chunks */
+        test_alloc_count = 0;
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            memcpy(key, &i, sizeof(i));
+            hashmap_setb(&map, key, key_len, (void*)(dast_sz)(i + 1));
+        }
+        assert_int_equal(test_alloc_count, e == 0 ? 3 : 2); /* Plus one pool slab for chained maps */
+        assert_int_equal(map.arena.live, nkeys * key_len);
+
+        /* Resizing moves keys without copying them */
+        dast_sz len;
+        char* stored = hashmap_iterb(&map, dast_null, &len);
+        hashmap_resize(&map);
+        hashmap_cursor_t cursor = {0};
+        dast_bool found = dast_false;
+        while( hashmap_cursor_next(&map, &cursor) ) found |= (cursor.key == stored);
+        assert_true(found);
+
+        /* Removed keys are reclaimed by compaction */
+        for(dast_u64 i = 0; i != nkeys; i += 2){
+            memcpy(key, &i, sizeof(i));
+            assert_true(hashmap_removeb(&map, key, key_len, dast_null));
+        }
+        assert_int_equal(map.arena.live, nkeys / 2 * key_len);
+        test_alloc_count = 0;
+        assert_non_null(hashmap_compact_keys(&map));
+        assert_int_equal(test_alloc_count, 1);
+        assert_int_equal(map.arena.total, nkeys / 2 * key_len);
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            memcpy(key, &i, sizeof(i));
+            assert_ptr_equal(hashmap_getb(&map, key, key_len), i % 2 ? (void*)(dast_sz)(i + 1) : dast_null);
+        }
+
+        hashmap_uninit(&map);
+        assert_null(map.arena.chunks);
+    }
+}
+
+void test_hashmap_reserve(void** state){
+    (void)state;
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    const hashmap_sizing_t sizings[] = { HASHMAP_SIZING_PRIME, HASHMAP_SIZING_POW2 };
+    const dast_u64 nkeys = 1000;
+
+    for(dast_sz c = 0; c != 3; ++c){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .engine = engines[c / 2], .sizing = sizings[c % 2]
+        });
+        dast_u64 k = 0;
+        hashmap_setb(&map, &k, sizeof(k), dast_null);
+
+        assert_non_null(hashmap_reserve(&map, nkeys));
+        dast_sz size = map.size;
+        assert_true(hashmap_has_keyb(&map, &k, sizeof(k)));
+
+        /* Reserving less does nothing */
+        assert_non_null(hashmap_reserve(&map, 10));
+        assert_int_equal(map.size, size);
+
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            hashmap_setb(&map, &i, sizeof(i), dast_null);
+            assert_int_equal(map.size, size);
+        }
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_setb_many(void** state){
+    (void)state;
+    const hashmap_engine_t engines[] = { HASHMAP_ENGINE_CHAINED, HASHMAP_ENGINE_OPEN };
+    enum { NKEYS = 300 };
+    const dast_sz key_len = HASHMAP_SMALL_KEY_SIZE + 8;
+    static char keys[NKEYS][HASHMAP_SMALL_KEY_SIZE + 8];
+    const void* bkeys[NKEYS];
+    dast_sz lens[NKEYS];
+    void* values[NKEYS];
+
+    for(dast_u64 i = 0; i != NKEYS; ++i){
+        memset(keys[i], 0, key_len);
+        memcpy(keys[i], &i, sizeof(i));
+        bkeys[i] = keys[i];
+        lens[i] = key_len;
+        values[i] = (void*)(dast_sz)(i + 1);
+    }
+
+    for(dast_sz e = 0; e != 2; ++e){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .alloc = TEST_COUNTING_ALLOCATOR, .engine = engines[e], .pool_slab_entries = 16, .key_arena_chunk = 256
+        });
+
+        /* Chained maps: one table, one slab of entries and one chunk of keys.
+           Open maps: control bytes, slots and one chunk of keys */
+        test_alloc_count = 0;
+        assert_non_null(hashmap_setb_many(&map, NKEYS, bkeys, lens, values));
+        assert_int_equal(test_alloc_count, 3);
+        assert_int_equal(map.entries, NKEYS);
+
+        for(dast_u64 i = 0; i != NKEYS; ++i){
+            assert_ptr_equal(hashmap_getb(&map, keys[i], key_len), values[i]);
+        }
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_set_many_str(void** state){
+    (void)state;
+    hashmap_t map;
+    int x = 1, y = 2;
+
+    hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, dast_null, dast_null);
+
+    string_t keys[] = { string_scoped_lit("one"), string_scoped_lit("two") };
+    void* values[] = { &x, &y };
+    assert_non_null(hashmap_set_many(&map, 2, keys, values));
+    assert_ptr_equal(hashmap_get(&map, keys[0]), &x);
+    assert_ptr_equal(hashmap_get(&map, keys[1]), &y);
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_parallel_resize(void** state){
+    (void)state;
+    const hashmap_sizing_t sizings[] = { HASHMAP_SIZING_PRIME, HASHMAP_SIZING_POW2 };
+    const dast_u64 nkeys = HASHMAP_PARALLEL_MIN_ENTRIES * 3;
+
+    for(dast_sz s = 0; s != 2; ++s){
+        hashmap_t map;
+        /* Entries come from the pool, so only the calling thread allocates */
+        hashmap_init_config(&map, (hashmap_config_t){
+            .alloc = TEST_ALLOCATOR, .sizing = sizings[s], .pool_slab_entries = 4096, .threads = 4
+        });
+
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            hashmap_setb(&map, &i, sizeof(i), (void*)(dast_sz)(i + 1));
+        }
+        dast_sz size = map.size;
+        assert_non_null(hashmap_resize(&map));
+        assert_true(map.size > size);
+        assert_null(map.old_table);
+        assert_int_equal(map.entries, nkeys);
+
+        for(dast_u64 i = 0; i != nkeys; ++i){
+            assert_ptr_equal(hashmap_getb(&map, &i, sizeof(i)), (void*)(dast_sz)(i + 1));
+        }
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_setb_many_parallel(void** state){
+    (void)state;
+    enum { NKEYS = HASHMAP_PARALLEL_MIN_ENTRIES * 3, KEY_LEN = HASHMAP_SMALL_KEY_SIZE + 8, EXISTING = 1000 };
+    static char keys[NKEYS][KEY_LEN];
+    static const void* bkeys[NKEYS];
+    static dast_sz lens[NKEYS];
+    static void* values[NKEYS];
+
+    /* Every tenth key is short, and the last thousand repeat earlier ones with new values */
+    for(dast_u64 i = 0; i != NKEYS; ++i){
+        dast_u64 k = i < NKEYS - EXISTING ? i : i - (NKEYS - EXISTING);
+        memset(keys[i], 0, KEY_LEN);
+        memcpy(keys[i], &k, sizeof(k));
+        bkeys[i] = keys[i];
+        lens[i] = (k % 10 == 0) ? sizeof(k) : KEY_LEN;
+        values[i] = (void*)(dast_sz)(i + 1);
+    }
+
+    hashmap_t map;
+    hashmap_init_config(&map, (hashmap_config_t){
+        .alloc = TEST_ALLOCATOR, .pool_slab_entries = 4096, .key_arena_chunk = 4096, .threads = 4
+    });
+
+    /* Keys already in the map have their values replaced */
+    for(dast_u64 i = 0; i != EXISTING; ++i){
+        hashmap_setb(&map, bkeys[i], lens[i], dast_null);
+    }
+    assert_non_null(hashmap_setb_many(&map, NKEYS, bkeys, lens, values));
+    assert_int_equal(map.entries, NKEYS - EXISTING);
+
+    dast_sz live = 0;
+    for(dast_u64 i = 0; i != NKEYS - EXISTING; ++i){
+        dast_sz last = i < EXISTING ? i + NKEYS - EXISTING : i;
+        assert_ptr_equal(hashmap_getb(&map, bkeys[i], lens[i]), values[last]);
+        if(lens[i] > HASHMAP_SMALL_KEY_SIZE) live += lens[i];
+    }
+    assert_int_equal(map.arena.live, live);
+
+#ifndef DAST_NO_STDLIB
+    /* Entries reserved for repeated keys are recycled. Without threads, keys are added one by one instead */
+    dast_sz recycled = 0;
+    for(hashmap_entry_t* entry = map.pool.free_list; entry; entry = entry->next) recycled++;
+    assert_int_equal(recycled, EXISTING * 2);
+#endif
+
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_value_size(void** state){
+    (void)state;
+    typedef struct { dast_u64 a, b; } record_t;
+    const hashmap_config_t configs[] = {
+        { .alloc = TEST_ALLOCATOR, .value_size = sizeof(record_t) },
+        { .alloc = TEST_ALLOCATOR, .value_size = sizeof(record_t), .pool_slab_entries = 64, .rehash_budget = 2 },
+        { .alloc = TEST_ALLOCATOR, .value_size = sizeof(record_t), .engine = HASHMAP_ENGINE_OPEN },
+    };
+
+    for(dast_sz c = 0; c != sizeof(configs)/sizeof(configs[0]); ++c){
+        hashmap_t map;
+        assert_non_null(hashmap_init_config(&map, configs[c]));
+
+        /* Values are copied, so the source can be reused */
+        record_t record;
+        for(dast_u64 i = 0; i != 1000; ++i){
+            record = (record_t){ i, i * i };
+            assert_non_null(hashmap_setb(&map, &i, sizeof(i), &record));
+        }
+        for(dast_u64 i = 0; i != 1000; ++i){
+            record_t* stored = hashmap_getb(&map, &i, sizeof(i));
+            assert_non_null(stored);
+            assert_ptr_not_equal(stored, &record);
+            assert_int_equal((dast_sz)stored & 7, 0);
+            assert_int_equal(stored->a, i);
+            assert_int_equal(stored->b, i * i);
+        }
+
+        /* Replacing a value overwrites the copy */
+        dast_u64 key = 5;
+        record_t* stored = hashmap_getb(&map, &key, sizeof(key));
+        record = (record_t){ 7, 7 };
+        hashmap_setb(&map, &key, sizeof(key), &record);
+        assert_ptr_equal(hashmap_getb(&map, &key, sizeof(key)), stored);
+        assert_int_equal(stored->a, 7);
+
+        /* NULL values are zeroed */
+        key = 2000;
+        hashmap_setb(&map, &key, sizeof(key), dast_null);
+        stored = hashmap_getb(&map, &key, sizeof(key));
+        assert_non_null(stored);
+        assert_int_equal(stored->a, 0);
+        assert_int_equal(stored->b, 0);
+
+        /* Upserts point to the copy, which starts zeroed */
+        key = 3000;
+        dast_bool inserted;
+        ((record_t*)*hashmap_upsertb(&map, &key, sizeof(key), &inserted))->a++;
+        assert_true(inserted);
+        ((record_t*)*hashmap_upsertb(&map, &key, sizeof(key), &inserted))->a++;
+        assert_false(inserted);
+        assert_int_equal(((record_t*)hashmap_getb(&map, &key, sizeof(key)))->a, 2);
+
+        /* Removed values are freed with their entry */
+        void* removed = &record;
+        key = 0;
+        assert_true(hashmap_removeb(&map, &key, sizeof(key), &removed));
+        assert_null(removed);
+
+        hashmap_cursor_t cursor = {0};
+        dast_sz count = 0;
+        while(hashmap_cursor_next(&map, &cursor)){
+            dast_u64 k;
+            memcpy(&k, cursor.key, sizeof(k));
+            if(k < 1000 && k != 5) assert_int_equal(((record_t*)cursor.value)->b, k * k);
+            count++;
+        }
+        assert_int_equal(count, 1001);
+
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_value_size_many(void** state){
+    (void)state;
+    enum { NKEYS = HASHMAP_PARALLEL_MIN_ENTRIES * 2 };
+    static dast_u64 keys[NKEYS];
+    static const void* bkeys[NKEYS];
+    static dast_sz lens[NKEYS];
+    static void* values[NKEYS];
+
+    for(dast_u64 i = 0; i != NKEYS; ++i){
+        keys[i] = i;
+        bkeys[i] = &keys[i];
+        lens[i] = sizeof(dast_u64);
+        values[i] = &keys[NKEYS - 1 - i];
+    }
+
+    /* Bulk loads copy each value into its entry, with or without threads */
+    const dast_sz threads[] = { 1, 2 };
+    for(dast_sz t = 0; t != sizeof(threads)/sizeof(threads[0]); ++t){
+        hashmap_t map;
+        hashmap_init_config(&map, (hashmap_config_t){
+            .alloc = TEST_ALLOCATOR, .pool_slab_entries = 4096, .threads = threads[t], .value_size = sizeof(dast_u64)
+        });
+        assert_non_null(hashmap_setb_many(&map, NKEYS, bkeys, lens, values));
+        assert_int_equal(map.entries, NKEYS);
+        for(dast_u64 i = 0; i != NKEYS; ++i){
+            dast_u64* value = hashmap_getb(&map, &keys[i], sizeof(dast_u64));
+            assert_ptr_not_equal(value, values[i]);
+            assert_int_equal(*value, NKEYS - 1 - i);
+        }
+        hashmap_resize(&map);
+        assert_int_equal(*(dast_u64*)hashmap_getb(&map, &keys[1], sizeof(dast_u64)), NKEYS - 2);
+        hashmap_uninit(&map);
+    }
+}
+
+void test_hashmap_stats(void** state){
+    (void)state;
+    hashmap_t map;
+    hashmap_stats_t stats;
+    char long_key[HASHMAP_SMALL_KEY_SIZE + 8] = {0};
+
+    assert_null(hashmap_stats(dast_null, &stats));
+    assert_null(hashmap_stats(&map, dast_null));
+
+    /* Every key hashes to the same bucket */
+    hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, test_hash_fn, dast_null);
+    for(dast_u64 i = 0; i != 5; ++i) hashmap_setb(&map, &i, sizeof(i), dast_null);
+
+    assert_ptr_equal(hashmap_stats(&map, &stats), &stats);
+    assert_int_equal(stats.entries, 5);
+    assert_int_equal(stats.buckets, ACTUAL_START_SIZE);
+    assert_true(stats.load_factor == 5.0 / ACTUAL_START_SIZE);
+    assert_int_equal(stats.used_buckets, 1);
+    assert_int_equal(stats.max_chain, 5);
+    assert_true(stats.avg_chain == 5.0);
+    assert_int_equal(stats.histogram[0], ACTUAL_START_SIZE - 1);
+    assert_int_equal(stats.histogram[5], 1);
+    assert_int_equal(stats.resizes, 0);
+    assert_int_equal(stats.table_bytes, ACTUAL_START_SIZE * sizeof(hashmap_entry_t*));
+    assert_int_equal(stats.entry_bytes, 5 * map.entry_size);
+    assert_int_equal(stats.key_bytes, 0);
+    assert_int_equal(stats.total_bytes, stats.table_bytes + stats.entry_bytes);
+
+    /* Long keys are allocated on their own, and chains longer than the histogram go to its last bin */
+    hashmap_setb(&map, long_key, sizeof(long_key), dast_null);
+    for(dast_u64 i = 5; i != HASHMAP_STATS_BINS + 5; ++i) hashmap_setb(&map, &i, sizeof(i), dast_null);
+    hashmap_stats(&map, &stats);
+    assert_int_equal(stats.key_bytes, sizeof(long_key));
+    assert_int_equal(stats.histogram[HASHMAP_STATS_BINS - 1], 1);
+    assert_int_equal(stats.max_chain, HASHMAP_STATS_BINS + 6);
+    assert_true(stats.resizes > 0);
+    hashmap_uninit(&map);
+
+    /* Pool slabs and arena chunks are counted whole */
+    hashmap_init_config(&map, (hashmap_config_t){
+        .size_hint = START_SIZE, .alloc = TEST_ALLOCATOR, .pool_slab_entries = 64, .key_arena_chunk = 256
+    });
+    hashmap_setb(&map, long_key, sizeof(long_key), dast_null);
+    hashmap_stats(&map, &stats);
+    assert_true(stats.entry_bytes >= 64 * map.entry_size);
+    assert_true(stats.key_bytes >= 256);
+    assert_int_equal(stats.total_bytes, stats.table_bytes + stats.entry_bytes + stats.key_bytes);
+    hashmap_uninit(&map);
+
+    /* Open addressing: every key is found within `max_chain` groups */
+    hashmap_init_config(&map, (hashmap_config_t){ .alloc = TEST_ALLOCATOR, .engine = HASHMAP_ENGINE_OPEN });
+    for(dast_u64 i = 0; i != 1000; ++i) hashmap_setb(&map, &i, sizeof(i), dast_null);
+    hashmap_stats(&map, &stats);
+    dast_sz keys = 0;
+    for(dast_sz i = 0; i != HASHMAP_STATS_BINS; ++i) keys += stats.histogram[i];
+    assert_int_equal(keys, 1000);
+    assert_int_equal(stats.used_buckets, 1000);
+    assert_int_equal(stats.buckets, map.size);
+    assert_true(stats.max_chain >= 1 && stats.avg_chain >= 1.0 && stats.avg_chain <= (double)stats.max_chain);
+    assert_int_equal(stats.table_bytes, map.size + HASHMAP_GROUP_WIDTH);
+    assert_int_equal(stats.entry_bytes, map.size * map.entry_size);
+    assert_true(stats.resizes > 0);
+    hashmap_uninit(&map);
+}
+
+void test_hashmap_stats_counters(void** state){
+    (void)state;
+    hashmap_t map;
+    hashmap_stats_t stats;
+    dast_u64 missing = 100;
+
+    /* Keys are added to the front of the chain they all share */
+    hashmap_init_custom(&map, START_SIZE, TEST_ALLOCATOR, test_hash_fn, dast_null);
+    for(dast_u64 i = 0; i != 5; ++i) hashmap_setb(&map, &i, sizeof(i), dast_null);
+    hashmap_reset_counters(&map);
+
+    dast_u64 last = 4, first = 0;
+    hashmap_getb(&map, &last, sizeof(last));
+    hashmap_getb(&map, &first, sizeof(first));
+    hashmap_has_keyb(&map, &missing, sizeof(missing));
+    hashmap_stats(&map, &stats);
+
+#ifdef DAST_STATS
+    assert_int_equal(stats.counters.lookups, 3);
+    assert_int_equal(stats.counters.probes, 1 + 5 + 5);
+    assert_int_equal(stats.counters.eq_calls, 1 + 5 + 5);
+#else
+    assert_int_equal(stats.counters.lookups, 0);
+    assert_int_equal(stats.counters.probes, 0);
+    assert_int_equal(stats.counters.eq_calls, 0);
+#endif
+
+    hashmap_reset_counters(&map);
+    hashmap_stats(&map, &stats);
+    assert_int_equal(stats.counters.lookups, 0);
+    hashmap_uninit(&map);
+}
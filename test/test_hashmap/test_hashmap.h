@@ -28,7 +28,50 @@
     cmocka_unit_test(test_hashmap_iterb_empty), \
     cmocka_unit_test(test_hashmap_set_str), \
     cmocka_unit_test(test_hashmap_has_key_str), \
-    cmocka_unit_test(test_hashmap_iter_str), 
+    cmocka_unit_test(test_hashmap_iter_str), \
+    cmocka_unit_test(test_hashmap_open_init), \
+    cmocka_unit_test(test_hashmap_open_setb_getb), \
+    cmocka_unit_test(test_hashmap_open_collisions), \
+    cmocka_unit_test(test_hashmap_open_iterb), \
+    cmocka_unit_test(test_hashmap_setb_small_key), \
+    cmocka_unit_test(test_hashmap_setb_long_key), \
+    cmocka_unit_test(test_hashmap_open_keys_survive_growth), \
+    cmocka_unit_test(test_hashmap_stored_hash), \
+    cmocka_unit_test(test_hashmap_open_stored_hash), \
+    cmocka_unit_test(test_hashmap_incremental_resize), \
+    cmocka_unit_test(test_hashmap_incremental_iterb), \
+    cmocka_unit_test(test_hashmap_incremental_uninit), \
+    cmocka_unit_test(test_hashmap_pow2_init), \
+    cmocka_unit_test(test_hashmap_pow2_growth), \
+    cmocka_unit_test(test_hashmap_wyhash64_hash), \
+    cmocka_unit_test(test_hashmap_fnv1a32_hash), \
+    cmocka_unit_test(test_hashmap_crc32c_hash), \
+    cmocka_unit_test(test_hashmap_word_hash_lengths), \
+    cmocka_unit_test(test_hashmap_word_hash_map), \
+    cmocka_unit_test(test_hashmap_cursor), \
+    cmocka_unit_test(test_hashmap_cursor_incremental), \
+    cmocka_unit_test(test_hashmap_getb_many), \
+    cmocka_unit_test(test_hashmap_get_many_str), \
+    cmocka_unit_test(test_hashmap_hashed), \
+    cmocka_unit_test(test_hashmap_hash_str), \
+    cmocka_unit_test(test_hashmap_upsertb), \
+    cmocka_unit_test(test_hashmap_upsert_str), \
+    cmocka_unit_test(test_hashmap_removeb), \
+    cmocka_unit_test(test_hashmap_remove_str), \
+    cmocka_unit_test(test_hashmap_remove_incremental), \
+    cmocka_unit_test(test_hashmap_open_remove_churn), \
+    cmocka_unit_test(test_hashmap_remove_shrink), \
+    cmocka_unit_test(test_hashmap_pool), \
+    cmocka_unit_test(test_hashmap_key_arena), \
+    cmocka_unit_test(test_hashmap_reserve), \
+    cmocka_unit_test(test_hashmap_setb_many), \
+    cmocka_unit_test(test_hashmap_set_many_str), \
+    cmocka_unit_test(test_hashmap_parallel_resize), \
+    cmocka_unit_test(test_hashmap_setb_many_parallel), \
+    cmocka_unit_test(test_hashmap_value_size), \
+    cmocka_unit_test(test_hashmap_value_size_many), \
+    cmocka_unit_test(test_hashmap_stats), \
+    cmocka_unit_test(test_hashmap_stats_counters), 
     
 
 
@@ -49,6 +92,49 @@ void test_hashmap_iterb_empty(void** state);
 void test_hashmap_set_str(void** state);
 void test_hashmap_has_key_str(void** state);
 void test_hashmap_iter_str(void** state);
+void test_hashmap_open_init(void** state);
+void test_hashmap_open_setb_getb(void** state);
+void test_hashmap_open_collisions(void** state);
+void test_hashmap_open_iterb(void** state);
+void test_hashmap_setb_small_key(void** state);
+void test_hashmap_setb_long_key(void** state);
+void test_hashmap_open_keys_survive_growth(void** state);
+void test_hashmap_stored_hash(void** state);
+void test_hashmap_open_stored_hash(void** state);
+void test_hashmap_incremental_resize(void** state);
+void test_hashmap_incremental_iterb(void** state);
+void test_hashmap_incremental_uninit(void** state);
+void test_hashmap_pow2_init(void** state);
+void test_hashmap_pow2_growth(void** state);
+void test_hashmap_wyhash64_hash(void** state);
+void test_hashmap_fnv1a32_hash(void** state);
+void test_hashmap_crc32c_hash(void** state);
+void test_hashmap_word_hash_lengths(void** state);
+void test_hashmap_word_hash_map(void** state);
+void test_hashmap_cursor(void** state);
+void test_hashmap_cursor_incremental(void** state);
+void test_hashmap_getb_many(void** state);
+void test_hashmap_get_many_str(void** state);
+void test_hashmap_hashed(void** state);
+void test_hashmap_hash_str(void** state);
+void test_hashmap_upsertb(void** state);
+void test_hashmap_upsert_str(void** state);
+void test_hashmap_removeb(void** state);
+void test_hashmap_remove_str(void** state);
+void test_hashmap_remove_incremental(void** state);
+void test_hashmap_open_remove_churn(void** state);
+void test_hashmap_remove_shrink(void** state);
+void test_hashmap_pool(void** state);
+void test_hashmap_key_arena(void** state);
+void test_hashmap_reserve(void** state);
+void test_hashmap_setb_many(void** state);
+void test_hashmap_set_many_str(void** state);
+void test_hashmap_parallel_resize(void** state);
+void test_hashmap_setb_many_parallel(void** state);
+void test_hashmap_value_size(void** state);
+void test_hashmap_value_size_many(void** state);
+void test_hashmap_stats(void** state);
+void test_hashmap_stats_counters(void** state);
 
 
 #endif /* TEST_HASHMAP_H */
@@ -0,0 +1,300 @@
+#include "test_hashset.h"
+
+
+/* CONSTANTS */
+
+#define N_KEYS 1000
+
+/* Longer than `HASHMAP_SMALL_KEY_SIZE`, so stored outside the entry */
+#define LONG_KEY_SIZE 48
+
+#define TEST_ALLOCATOR (dast_allocator_t){.alloc=test_malloc_wrapper, .realloc=test_realloc_wrapper, .free=test_free_wrapper}
+
+/* STATIC FUNCTIONS */
+
+static void* test_malloc_wrapper (dast_sz size)             { return test_malloc((size_t)size); }
+static void* test_realloc_wrapper(void* block, dast_sz size){ return test_realloc(block, (size_t)size); }
+static void  test_free_wrapper   (void* block)              {        test_free(block); }
+
+/* Number of keys hashed by `test_counting_hash` */
+static dast_sz test_hash_calls = 0;
+
+static dast_hash_t test_counting_hash(const void* data, dast_sz len){
+    test_hash_calls++;
+    return HASHMAP_DEFAULT_HASH(data, len);
+}
+
+/* Every odd key is longer than `HASHMAP_SMALL_KEY_SIZE` */
+static dast_sz test_make_key(char* buf, dast_u64 i){
+    dast_sz len = (i & 1) ? LONG_KEY_SIZE : sizeof(dast_u64);
+    memset(buf, 'k', len);
+    memcpy(buf, &i, sizeof(dast_u64));
+    return len;
+}
+
+static void test_insert_range(hashset_t* set, dast_u64 from, dast_u64 to){
+    char key[LONG_KEY_SIZE];
+    for (dast_u64 i = from; i < to; ++i) {
+        assert_ptr_equal(hashset_insertb(set, key, test_make_key(key, i)), set);
+    }
+}
+
+static dast_bool test_has(hashset_t* set, dast_u64 i){
+    char key[LONG_KEY_SIZE];
+    return hashset_containsb(set, key, test_make_key(key, i));
+}
+
+/* PUBLIC FUNCTIONS */
+
+void test_hashset_insert_contains(void** state){
+    (void)state;
+    hashset_t set;
+    assert_non_null(hashset_init_custom(&set, 4, TEST_ALLOCATOR, dast_null, dast_null));
+    assert_int_equal(hashset_count(&set), 0);
+    assert_false(test_has(&set, 0));
+
+    test_insert_range(&set, 0, N_KEYS);
+    assert_int_equal(hashset_count(&set), N_KEYS);
+    assert_true(set.entries * HASHMAP_OPEN_MAX_LOAD_DEN <= set.size * HASHMAP_OPEN_MAX_LOAD_NUM);
+
+    /* Inserting a key again leaves the set as it was */
+    test_insert_range(&set, 0, N_KEYS);
+    assert_int_equal(hashset_count(&set), N_KEYS);
+
+    for (dast_u64 i = 0; i != N_KEYS; ++i) assert_true(test_has(&set, i));
+    for (dast_u64 i = N_KEYS; i != 2 * N_KEYS; ++i) assert_false(test_has(&set, i));
+
+    /* String keys include their null-terminating character */
+    assert_ptr_equal(hashset_insert(&set, string_scoped_lit("apple")), &set);
+    assert_true(hashset_contains(&set, string_scoped_lit("apple")));
+    assert_true(hashset_containsb(&set, "apple", 6));
+    assert_false(hashset_containsb(&set, "apple", 5));
+    assert_false(hashset_contains(&set, string_scoped_lit("pear")));
+
+    assert_null(hashset_insertb(&set, dast_null, 4));
+    assert_null(hashset_insertb(dast_null, "a", 1));
+    assert_false(hashset_containsb(dast_null, "a", 1));
+
+    /* Entries are smaller than those of a map */
+    assert_true(sizeof(hashset_entry_t) < sizeof(hashmap_entry_t));
+
+    hashset_uninit(&set);
+    assert_null(set.slots);
+    assert_int_equal(hashset_count(&set), 0);
+    assert_false(test_has(&set, 0));
+    hashset_uninit(&set);
+}
+
+void test_hashset_remove(void** state){
+    (void)state;
+    hashset_t set;
+    hashset_init_custom(&set, 16, TEST_ALLOCATOR, dast_null, dast_null);
+    test_insert_range(&set, 0, N_KEYS);
+    dast_sz grown = set.size;
+
+    char key[LONG_KEY_SIZE];
+    for (dast_u64 i = 0; i < N_KEYS; i += 2) {
+        assert_true(hashset_removeb(&set, key, test_make_key(key, i)));
+        assert_false(hashset_removeb(&set, key, test_make_key(key, i)));
+    }
+    assert_int_equal(hashset_count(&set), N_KEYS / 2);
+    for (dast_u64 i = 0; i != N_KEYS; ++i) assert_int_equal(test_has(&set, i), i & 1);
+
+    /* Removing most keys shrinks the set, but not below its starting size */
+    for (dast_u64 i = 1; i < N_KEYS; i += 2) assert_true(hashset_removeb(&set, key, test_make_key(key, i)));
+    assert_int_equal(hashset_count(&set), 0);
+    assert_true(set.size < grown);
+    assert_true(set.size >= 16);
+
+    /* Removed slots are reused */
+    test_insert_range(&set, 0, N_KEYS);
+    assert_int_equal(hashset_count(&set), N_KEYS);
+    for (dast_u64 i = 0; i != N_KEYS; ++i) assert_true(test_has(&set, i));
+
+    assert_true(hashset_insert(&set, string_scoped_lit("apple")));
+    assert_true(hashset_remove(&set, string_scoped_lit("apple")));
+    assert_false(hashset_contains(&set, string_scoped_lit("apple")));
+    assert_false(hashset_removeb(&set, dast_null, 1));
+
+    hashset_uninit(&set);
+}
+
+void test_hashset_iterate(void** state){
+    (void)state;
+    hashset_t set;
+    hashset_cursor_t cursor = {0};
+    hashset_init_custom(&set, 0, TEST_ALLOCATOR, dast_null, dast_null);
+    assert_false(hashset_cursor_next(&set, &cursor));
+
+    test_insert_range(&set, 0, N_KEYS);
+
+    /* Every key is visited once */
+    dast_u8 seen[N_KEYS] = {0};
+    dast_sz visited = 0;
+    cursor = (hashset_cursor_t){0};
+    while (hashset_cursor_next(&set, &cursor)) {
+        dast_u64 i;
+        memcpy(&i, cursor.key, sizeof(i));
+        assert_true(i < N_KEYS);
+        assert_int_equal(cursor.len, (i & 1) ? LONG_KEY_SIZE : sizeof(dast_u64));
+        assert_false(seen[i]);
+        seen[i] = 1;
+        visited++;
+    }
+    assert_int_equal(visited, N_KEYS);
+    assert_false(hashset_cursor_next(&set, &cursor));
+
+    /* Keys can be removed while iterating */
+    cursor = (hashset_cursor_t){0};
+    while (hashset_cursor_next(&set, &cursor)) {
+        dast_u64 i;
+        memcpy(&i, cursor.key, sizeof(i));
+        if (i % 3 == 0) {
+            char key[LONG_KEY_SIZE];
+            assert_true(hashset_removeb(&set, key, test_make_key(key, i)));
+        }
+    }
+    for (dast_u64 i = 0; i != N_KEYS; ++i) assert_int_equal(test_has(&set, i), i % 3 != 0);
+
+    hashset_uninit(&set);
+}
+
+void test_hashset_copy(void** state){
+    (void)state;
+    hashset_t set, copy;
+    hashset_init_custom(&set, 0, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    test_insert_range(&set, 0, N_KEYS);
+
+    test_hash_calls = 0;
+    assert_ptr_equal(hashset_copy(&copy, &set), &copy);
+    assert_int_equal(test_hash_calls, 0);
+    assert_int_equal(hashset_count(&copy), N_KEYS);
+
+    /* The copy owns its keys */
+    hashset_uninit(&set);
+    for (dast_u64 i = 0; i != N_KEYS; ++i) assert_true(test_has(&copy, i));
+    assert_false(test_has(&copy, N_KEYS));
+
+    test_insert_range(&copy, N_KEYS, 2 * N_KEYS);
+    assert_int_equal(hashset_count(&copy), 2 * N_KEYS);
+
+    assert_null(hashset_copy(&copy, &copy));
+    assert_null(hashset_copy(&set, dast_null));
+    hashset_uninit(&copy);
+}
+
+void test_hashset_union(void** state){
+    (void)state;
+    hashset_t a, b;
+    hashset_init_custom(&a, 0, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    hashset_init_custom(&b, 0, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    test_insert_range(&a, 0, N_KEYS);
+    test_insert_range(&b, N_KEYS / 2, 2 * N_KEYS);
+
+    /* Keys keep their hashes, and are not hashed again */
+    test_hash_calls = 0;
+    assert_ptr_equal(hashset_union(&a, &b), &a);
+    assert_int_equal(test_hash_calls, 0);
+
+    assert_int_equal(hashset_count(&a), 2 * N_KEYS);
+    assert_int_equal(hashset_count(&b), N_KEYS + N_KEYS / 2);
+    for (dast_u64 i = 0; i != 2 * N_KEYS; ++i) assert_true(test_has(&a, i));
+    assert_false(test_has(&a, 2 * N_KEYS));
+
+    assert_ptr_equal(hashset_union(&a, &a), &a);
+    assert_int_equal(hashset_count(&a), 2 * N_KEYS);
+    assert_null(hashset_union(&a, dast_null));
+
+    hashset_uninit(&a);
+    hashset_uninit(&b);
+}
+
+void test_hashset_intersect(void** state){
+    (void)state;
+    hashset_t a, b;
+    hashset_init_custom(&a, 0, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    hashset_init_custom(&b, 0, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    test_insert_range(&a, 0, N_KEYS);
+    test_insert_range(&b, N_KEYS / 2, 2 * N_KEYS);
+
+    test_hash_calls = 0;
+    assert_ptr_equal(hashset_intersect(&a, &b), &a);
+    assert_int_equal(test_hash_calls, 0);
+
+    assert_int_equal(hashset_count(&a), N_KEYS / 2);
+    for (dast_u64 i = 0; i != 2 * N_KEYS; ++i) assert_int_equal(test_has(&a, i), i >= N_KEYS / 2 && i < N_KEYS);
+
+    /* Intersecting with an empty set empties it, and shrinks it */
+    hashset_t empty;
+    hashset_init_custom(&empty, 0, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    assert_ptr_equal(hashset_intersect(&b, &empty), &b);
+    assert_int_equal(hashset_count(&b), 0);
+    assert_int_equal(b.size, HASHMAP_GROUP_WIDTH);
+    assert_null(hashset_intersect(dast_null, &b));
+
+    hashset_uninit(&a);
+    hashset_uninit(&b);
+    hashset_uninit(&empty);
+}
+
+void test_hashset_difference(void** state){
+    (void)state;
+    hashset_t a, b, small;
+    hashset_init_custom(&a, 0, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    hashset_init_custom(&b, 0, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    hashset_init_custom(&small, 0, TEST_ALLOCATOR, test_counting_hash, dast_null);
+    test_insert_range(&a, 0, N_KEYS);
+    test_insert_range(&b, N_KEYS / 2, 2 * N_KEYS);
+    test_insert_range(&small, 0, 10);
+
+    /* Looks up the keys of `a` in the larger set */
+    test_hash_calls = 0;
+    assert_ptr_equal(hashset_difference(&a, &b), &a);
+    assert_int_equal(test_hash_calls, 0);
+    assert_int_equal(hashset_count(&a), N_KEYS / 2);
+    for (dast_u64 i = 0; i != 2 * N_KEYS; ++i) assert_int_equal(test_has(&a, i), i < N_KEYS / 2);
+
+    /* Looks up the keys of the smaller set in `a` */
+    test_hash_calls = 0;
+    assert_ptr_equal(hashset_difference(&a, &small), &a);
+    assert_int_equal(test_hash_calls, 0);
+    assert_int_equal(hashset_count(&a), N_KEYS / 2 - 10);
+    for (dast_u64 i = 0; i != N_KEYS; ++i) assert_int_equal(test_has(&a, i), i >= 10 && i < N_KEYS / 2);
+
+    assert_ptr_equal(hashset_difference(&b, &b), &b);
+    assert_int_equal(hashset_count(&b), 0);
+    assert_false(test_has(&b, N_KEYS));
+    assert_null(hashset_difference(&a, dast_null));
+
+    hashset_uninit(&a);
+    hashset_uninit(&b);
+    hashset_uninit(&small);
+}
+
+void test_hashset_different_hash(void** state){
+    (void)state;
+    hashset_t a, b;
+    hashset_init_custom(&a, 0, TEST_ALLOCATOR, dast_null, dast_null);
+    hashset_init_custom(&b, 0, TEST_ALLOCATOR, hashmap_wyhash64_hash, dast_null);
+    test_insert_range(&a, 0, N_KEYS);
+    test_insert_range(&b, N_KEYS / 2, 2 * N_KEYS);
+
+    /* Keys are hashed with the function of the set they are looked up in */
+    hashset_t u;
+    hashset_copy(&u, &a);
+    hashset_union(&u, &b);
+    assert_int_equal(hashset_count(&u), 2 * N_KEYS);
+    for (dast_u64 i = 0; i != 2 * N_KEYS; ++i) assert_true(test_has(&u, i));
+
+    hashset_intersect(&b, &a);
+    assert_int_equal(hashset_count(&b), N_KEYS / 2);
+    for (dast_u64 i = 0; i != 2 * N_KEYS; ++i) assert_int_equal(test_has(&b, i), i >= N_KEYS / 2 && i < N_KEYS);
+
+    hashset_difference(&u, &b);
+    assert_int_equal(hashset_count(&u), N_KEYS + N_KEYS / 2);
+    for (dast_u64 i = 0; i != 2 * N_KEYS; ++i) assert_int_equal(test_has(&u, i), i < N_KEYS / 2 || i >= N_KEYS);
+
+    hashset_uninit(&a);
+    hashset_uninit(&b);
+    hashset_uninit(&u);
+}
@@ -0,0 +1,35 @@
+#ifndef TEST_HASHSET_H
+#define TEST_HASHSET_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "hashset.h"
+
+
+#define TEST_GROUP_HASHSET \
+    cmocka_unit_test(test_hashset_insert_contains), \
+    cmocka_unit_test(test_hashset_remove), \
+    cmocka_unit_test(test_hashset_iterate), \
+    cmocka_unit_test(test_hashset_copy), \
+    cmocka_unit_test(test_hashset_union), \
+    cmocka_unit_test(test_hashset_intersect), \
+    cmocka_unit_test(test_hashset_difference), \
+    cmocka_unit_test(test_hashset_different_hash)
+
+
+void test_hashset_insert_contains(void** state);
+void test_hashset_remove(void** state);
+void test_hashset_iterate(void** state);
+void test_hashset_copy(void** state);
+void test_hashset_union(void** state);
+void test_hashset_intersect(void** state);
+void test_hashset_difference(void** state);
+void test_hashset_different_hash(void** state);
+
+
+#endif /* TEST_HASHSET_H */
@@ -0,0 +1,202 @@
+#include "test_snapmap.h"
+
+#if !defined(DAST_NO_STDLIB) && defined(__unix__)
+    #include <pthread.h>
+    #define TEST_SNAPMAP_THREADS
+#endif
+
+
+/* CONSTANTS */
+
+#define TEST_ALLOCATOR (dast_allocator_t){.alloc=test_malloc_wrapper, .realloc=test_realloc_wrapper, .free=test_free_wrapper}
+
+/* STATIC FUNCTIONS */
+
+static void* test_malloc_wrapper (dast_sz size)             { return test_malloc((size_t)size); }
+static void* test_realloc_wrapper(void* block, dast_sz size){ return test_realloc(block, (size_t)size); }
+static void  test_free_wrapper   (void* block)              {        test_free(block); }
+
+static dast_sz test_reclaimed = 0;
+static void test_count_reclaim(hashmap_t* map){ (void)map; test_reclaimed++; }
+
+/** Creates a map holding a single key, whose value is `value` */
+static hashmap_t* test_snapmap_map(snapmap_t* snap, dast_sz value){
+    hashmap_t* map = snapmap_new_map(snap, (hashmap_config_t){.size_hint = 10});
+    assert_non_null(map);
+    hashmap_set(map, string_scoped_lit("key"), (void*)value);
+    return map;
+}
+
+/* PUBLIC FUNCTIONS */
+
+void test_snapmap_init_free(void** state){
+    (void)state;
+    snapmap_t snap;
+    assert_non_null(snapmap_init_custom(&snap, TEST_ALLOCATOR, dast_null));
+    assert_null(snapmap_current(&snap));
+    assert_null(snapmap_get(&snap, string_scoped_lit("key")));
+    snapmap_uninit(&snap);
+
+    assert_null(snapmap_init_custom(dast_null, TEST_ALLOCATOR, dast_null));
+    snapmap_uninit(dast_null);
+}
+
+void test_snapmap_publish(void** state){
+    (void)state;
+    snapmap_t snap;
+    snapmap_init_custom(&snap, TEST_ALLOCATOR, dast_null);
+
+    hashmap_t* first = test_snapmap_map(&snap, 1);
+    assert_ptr_equal(snapmap_publish(&snap, first), &snap);
+    assert_ptr_equal(snapmap_current(&snap), first);
+    assert_ptr_equal(snapmap_get(&snap, string_scoped_lit("key")), (void*)1);
+
+    /* With no readers, the replaced map is freed straight away */
+    snapmap_publish(&snap, test_snapmap_map(&snap, 2));
+    assert_ptr_equal(snapmap_get(&snap, string_scoped_lit("key")), (void*)2);
+    assert_int_equal(snap.retired_len, 0);
+
+    /* Unpublishing */
+    snapmap_publish(&snap, dast_null);
+    assert_null(snapmap_current(&snap));
+
+    snapmap_publish(&snap, test_snapmap_map(&snap, 3));
+    snapmap_uninit(&snap);
+}
+
+void test_snapmap_reclaim(void** state){
+    (void)state;
+    snapmap_t snap;
+    snapmap_reader_t a, b;
+    snapmap_init_custom(&snap, TEST_ALLOCATOR, dast_null);
+    snapmap_publish(&snap, test_snapmap_map(&snap, 1));
+    snapmap_register(&snap, &a);
+    snapmap_register(&snap, &b);
+
+    /* Both readers may still hold the first map */
+    hashmap_t* held = snapmap_current(&snap);
+    snapmap_publish(&snap, test_snapmap_map(&snap, 2));
+    snapmap_publish(&snap, test_snapmap_map(&snap, 3));
+    assert_int_equal(snap.retired_len, 2);
+    assert_ptr_equal(hashmap_get(held, string_scoped_lit("key")), (void*)1);
+
+    /* Kept until every reader has passed a quiescent state */
+    snapmap_quiescent(&snap, &a);
+    assert_int_equal(snapmap_reclaim(&snap), 2);
+    snapmap_quiescent(&snap, &b);
+    assert_int_equal(snapmap_reclaim(&snap), 0);
+    assert_ptr_equal(snapmap_get(&snap, string_scoped_lit("key")), (void*)3);
+
+    /* Unregistered readers hold nothing back */
+    snapmap_publish(&snap, test_snapmap_map(&snap, 4));
+    assert_int_equal(snap.retired_len, 1);
+    snapmap_unregister(&snap, &a);
+    snapmap_unregister(&snap, &b);
+    assert_int_equal(snap.retired_len, 0);
+
+    snapmap_uninit(&snap);
+}
+
+void test_snapmap_offline(void** state){
+    (void)state;
+    snapmap_t snap;
+    snapmap_reader_t reader;
+    snapmap_init_custom(&snap, TEST_ALLOCATOR, dast_null);
+    snapmap_publish(&snap, test_snapmap_map(&snap, 1));
+    snapmap_register(&snap, &reader);
+
+    snapmap_offline(&snap, &reader);
+    snapmap_publish(&snap, test_snapmap_map(&snap, 2));
+    assert_int_equal(snap.retired_len, 0);
+
+    snapmap_online(&snap, &reader);
+    assert_ptr_equal(snapmap_get(&snap, string_scoped_lit("key")), (void*)2);
+    snapmap_publish(&snap, test_snapmap_map(&snap, 3));
+    assert_int_equal(snap.retired_len, 1);
+
+    /* Calls without a reader do nothing */
+    snapmap_quiescent(&snap, dast_null);
+    snapmap_offline(&snap, dast_null);
+    snapmap_online(dast_null, &reader);
+
+    snapmap_unregister(&snap, &reader);
+    snapmap_uninit(&snap);
+}
+
+void test_snapmap_on_reclaim(void** state){
+    (void)state;
+    snapmap_t snap;
+    snapmap_reader_t reader;
+    snapmap_init_custom(&snap, TEST_ALLOCATOR, test_count_reclaim);
+    snapmap_register(&snap, &reader);
+    test_reclaimed = 0;
+
+    snapmap_publish(&snap, test_snapmap_map(&snap, 1));
+    snapmap_publish(&snap, test_snapmap_map(&snap, 2));
+    assert_int_equal(test_reclaimed, 0);
+    snapmap_quiescent(&snap, &reader);
+    snapmap_reclaim(&snap);
+    assert_int_equal(test_reclaimed, 1);
+
+    snapmap_unregister(&snap, &reader);
+    snapmap_uninit(&snap);
+    assert_int_equal(test_reclaimed, 2);
+}
+
+#ifdef TEST_SNAPMAP_THREADS
+
+#define TEST_READERS 3
+#define TEST_PUBLICATIONS 200
+
+static snapmap_t test_snap;
+static volatile int test_publishing_done = 0;
+
+/* Checks that every map seen holds its generation under every key, until told to stop */
+static void* test_snapmap_reader(void* arg){
+    (void)arg;
+    snapmap_reader_t reader;
+    dast_sz errors = 0;
+    snapmap_register(&test_snap, &reader);
+    while(!__atomic_load_n(&test_publishing_done, __ATOMIC_ACQUIRE)){
+        hashmap_t* map = snapmap_current(&test_snap);
+        void* generation = hashmap_getb(map, "gen", 4);
+        for(dast_u64 k = 0; k != 64; ++k){
+            if(hashmap_getb(map, &k, sizeof(k)) != generation) errors++;
+        }
+        snapmap_quiescent(&test_snap, &reader);
+    }
+    snapmap_unregister(&test_snap, &reader);
+    return (void*)errors;
+}
+
+#endif
+
+void test_snapmap_threads(void** state){
+    (void)state;
+#ifdef TEST_SNAPMAP_THREADS
+    pthread_t readers[TEST_READERS];
+
+    snapmap_init(&test_snap);
+    test_publishing_done = 0;
+    for(dast_sz gen = 1; gen != TEST_PUBLICATIONS + 1; ++gen){
+        hashmap_t* map = snapmap_new_map(&test_snap, (hashmap_config_t){0});
+        hashmap_setb(map, "gen", 4, (void*)gen);
+        for(dast_u64 k = 0; k != 64; ++k) hashmap_setb(map, &k, sizeof(k), (void*)gen);
+        snapmap_publish(&test_snap, map);
+
+        if(gen == 1){
+            for(dast_sz i = 0; i != TEST_READERS; ++i) pthread_create(&readers[i], dast_null, test_snapmap_reader, dast_null);
+        }
+    }
+    snapmap_synchronize(&test_snap);
+    assert_int_equal(test_snap.retired_len, 0);
+
+    __atomic_store_n(&test_publishing_done, 1, __ATOMIC_RELEASE);
+    for(dast_sz i = 0; i != TEST_READERS; ++i){
+        void* errors;
+        pthread_join(readers[i], &errors);
+        assert_null(errors);
+    }
+    snapmap_uninit(&test_snap);
+#endif
+}
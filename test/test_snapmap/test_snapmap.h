@@ -0,0 +1,31 @@
+#ifndef TEST_SNAPMAP_H
+#define TEST_SNAPMAP_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "snapmap.h"
+
+
+#define TEST_GROUP_SNAPMAP \
+    cmocka_unit_test(test_snapmap_init_free), \
+    cmocka_unit_test(test_snapmap_publish), \
+    cmocka_unit_test(test_snapmap_reclaim), \
+    cmocka_unit_test(test_snapmap_offline), \
+    cmocka_unit_test(test_snapmap_on_reclaim), \
+    cmocka_unit_test(test_snapmap_threads)
+
+
+void test_snapmap_init_free(void** state);
+void test_snapmap_publish(void** state);
+void test_snapmap_reclaim(void** state);
+void test_snapmap_offline(void** state);
+void test_snapmap_on_reclaim(void** state);
+void test_snapmap_threads(void** state);
+
+
+#endif /* TEST_SNAPMAP_H */
@@ -0,0 +1,189 @@
+#include "test_typedmap.h"
+
+
+/* CONSTANTS */
+
+#define N_KEYS 1000
+
+#define TEST_ALLOCATOR (dast_allocator_t){.alloc=test_malloc_wrapper, .realloc=test_realloc_wrapper, .free=test_free_wrapper}
+
+/* STATIC FUNCTIONS */
+
+static void* test_malloc_wrapper (dast_sz size)             { return test_malloc((size_t)size); }
+static void* test_realloc_wrapper(void* block, dast_sz size){ return test_realloc(block, (size_t)size); }
+static void  test_free_wrapper   (void* block)              {        test_free(block); }
+
+typedef struct test_point {
+    dast_i32 x, y;
+} test_point_t;
+
+static dast_u64 test_point_hash(test_point_t p){ return ((dast_u64)(dast_u32)p.x << 32) | (dast_u32)p.y; }
+static dast_bool test_point_eq(test_point_t a, test_point_t b){ return a.x == b.x && a.y == b.y; }
+
+/* Every key hashes the same, so that all of them share one probe sequence */
+#define test_collide_hash(KEY) ((void)(KEY), (dast_u64)7)
+
+DAST_HASHMAP_DEFINE(test_intmap, dast_u64, dast_u64, typedmap_hash_u64, typedmap_eq)
+DAST_HASHMAP_DEFINE(test_pointmap, test_point_t, double, test_point_hash, test_point_eq)
+DAST_HASHMAP_DEFINE(test_collidemap, dast_u32, dast_u32, test_collide_hash, typedmap_eq)
+
+/* PUBLIC FUNCTIONS */
+
+void test_typedmap_set_get(void** state){
+    (void)state;
+    test_intmap_t map;
+    assert_non_null(test_intmap_init_custom(&map, 0, TEST_ALLOCATOR));
+    assert_int_equal(test_intmap_count(&map), 0);
+    assert_null(test_intmap_get(&map, 0));
+
+    for (dast_u64 i = 0; i != N_KEYS; ++i) {
+        assert_ptr_equal(test_intmap_set(&map, i * 3, i), &map);
+    }
+    assert_int_equal(test_intmap_count(&map), N_KEYS);
+    assert_true(map.entries * TYPEDMAP_MAX_LOAD_DEN <= map.size * TYPEDMAP_MAX_LOAD_NUM);
+
+    for (dast_u64 i = 0; i != N_KEYS; ++i) {
+        dast_u64* value = test_intmap_get(&map, i * 3);
+        assert_non_null(value);
+        assert_int_equal(*value, i);
+        assert_false(test_intmap_has(&map, i * 3 + 1));
+    }
+
+    /* Replacing keeps the count */
+    test_intmap_set(&map, 0, 99);
+    assert_int_equal(*test_intmap_get(&map, 0), 99);
+    assert_int_equal(test_intmap_count(&map), N_KEYS);
+
+    test_intmap_uninit(&map);
+    assert_null(map.slots);
+    assert_int_equal(test_intmap_count(&map), 0);
+    assert_null(test_intmap_get(&map, 0));
+
+    /* Missing allocator functions */
+    assert_null(test_intmap_init_custom(&map, 0, (dast_allocator_t){0}));
+}
+
+void test_typedmap_upsert(void** state){
+    (void)state;
+    test_intmap_t map;
+    dast_bool inserted = dast_false;
+    test_intmap_init_custom(&map, N_KEYS, TEST_ALLOCATOR);
+    dast_sz size = map.size;
+
+    /* Count occurrences of each key modulo 10 */
+    for (dast_u64 i = 0; i != N_KEYS; ++i) {
+        dast_u64* counter = test_intmap_upsert(&map, i % 10, &inserted);
+        assert_non_null(counter);
+        assert_int_equal(inserted, i < 10);
+        if (inserted) assert_int_equal(*counter, 0);
+        (*counter)++;
+    }
+    assert_int_equal(test_intmap_count(&map), 10);
+    for (dast_u64 i = 0; i != 10; ++i) {
+        assert_int_equal(*test_intmap_get(&map, i), N_KEYS / 10);
+    }
+
+    /* Reserved maps do not grow */
+    for (dast_u64 i = 10; i != N_KEYS; ++i) test_intmap_set(&map, i, i);
+    assert_int_equal(map.size, size);
+
+    assert_ptr_equal(test_intmap_reserve(&map, 10 * N_KEYS), &map);
+    assert_true(map.size > size);
+    for (dast_u64 i = 10; i != N_KEYS; ++i) assert_int_equal(*test_intmap_get(&map, i), i);
+
+    test_intmap_uninit(&map);
+}
+
+void test_typedmap_remove(void** state){
+    (void)state;
+    test_intmap_t map;
+    dast_u64 value = 0;
+    test_intmap_init_custom(&map, 0, TEST_ALLOCATOR);
+    for (dast_u64 i = 0; i != N_KEYS; ++i) test_intmap_set(&map, i, i + 1);
+
+    for (dast_u64 i = 0; i < N_KEYS; i += 2) {
+        assert_true(test_intmap_remove(&map, i, &value));
+        assert_int_equal(value, i + 1);
+        assert_false(test_intmap_remove(&map, i, dast_null));
+    }
+    assert_int_equal(test_intmap_count(&map), N_KEYS / 2);
+    for (dast_u64 i = 0; i != N_KEYS; ++i) {
+        assert_int_equal(test_intmap_has(&map, i), i % 2 == 1);
+    }
+
+    /* Churn through many more keys than the map holds at once, which must reuse deleted slots instead of growing */
+    dast_sz size = map.size;
+    for (dast_u64 i = N_KEYS; i != 20 * N_KEYS; ++i) {
+        test_intmap_set(&map, i, i);
+        assert_true(test_intmap_remove(&map, i, dast_null));
+    }
+    assert_int_equal(map.size, size);
+    assert_int_equal(test_intmap_count(&map), N_KEYS / 2);
+    for (dast_u64 i = 1; i < N_KEYS; i += 2) assert_int_equal(*test_intmap_get(&map, i), i + 1);
+
+    test_intmap_uninit(&map);
+
+    /* Removing from a single probe sequence keeps the keys after the removed one */
+    test_collidemap_t collide;
+    test_collidemap_init_custom(&collide, 0, TEST_ALLOCATOR);
+    for (dast_u32 i = 0; i != 5; ++i) test_collidemap_set(&collide, i, i);
+    assert_true(test_collidemap_remove(&collide, 1, dast_null));
+    assert_true(test_collidemap_remove(&collide, 4, dast_null));
+    for (dast_u32 i = 0; i != 5; ++i) {
+        assert_int_equal(test_collidemap_has(&collide, i), i != 1 && i != 4);
+    }
+    test_collidemap_set(&collide, 1, 10);
+    assert_int_equal(*test_collidemap_get(&collide, 1), 10);
+    assert_int_equal(test_collidemap_count(&collide), 4);
+    test_collidemap_uninit(&collide);
+}
+
+void test_typedmap_iterate(void** state){
+    (void)state;
+    test_intmap_t map;
+    static dast_u8 seen[N_KEYS];
+    dast_sz cursor = 0, visited = 0;
+    dast_u64 *key, *value;
+
+    test_intmap_init_custom(&map, 0, TEST_ALLOCATOR);
+    assert_false(test_intmap_next(&map, &cursor, &key, &value));
+    for (dast_u64 i = 0; i != N_KEYS; ++i) test_intmap_set(&map, i, 2 * i);
+    for (dast_u64 i = 0; i < N_KEYS; i += 3) test_intmap_remove(&map, i, dast_null);
+
+    memset(seen, 0, sizeof(seen));
+    cursor = 0;
+    while (test_intmap_next(&map, &cursor, &key, &value)) {
+        assert_true(*key < N_KEYS);
+        assert_int_equal(*value, 2 * *key);
+        assert_int_equal(seen[*key], 0);
+        seen[*key] = 1;
+        visited++;
+    }
+    assert_int_equal(visited, test_intmap_count(&map));
+    for (dast_u64 i = 0; i != N_KEYS; ++i) assert_int_equal(seen[i], i % 3 != 0);
+
+    test_intmap_uninit(&map);
+}
+
+void test_typedmap_struct_key(void** state){
+    (void)state;
+    test_pointmap_t map;
+    test_pointmap_init_custom(&map, 0, TEST_ALLOCATOR);
+
+    for (dast_i32 x = -10; x != 10; ++x) {
+        for (dast_i32 y = -10; y != 10; ++y) {
+            test_pointmap_set(&map, (test_point_t){x, y}, x * 0.5 + y);
+        }
+    }
+    assert_int_equal(test_pointmap_count(&map), 400);
+    for (dast_i32 x = -10; x != 10; ++x) {
+        for (dast_i32 y = -10; y != 10; ++y) {
+            double* value = test_pointmap_get(&map, (test_point_t){x, y});
+            assert_non_null(value);
+            assert_true(*value == x * 0.5 + y);
+        }
+    }
+    assert_false(test_pointmap_has(&map, (test_point_t){10, 0}));
+
+    test_pointmap_uninit(&map);
+}
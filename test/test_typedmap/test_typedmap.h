@@ -0,0 +1,29 @@
+#ifndef TEST_TYPEDMAP_H
+#define TEST_TYPEDMAP_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "typedmap.h"
+
+
+#define TEST_GROUP_TYPEDMAP \
+    cmocka_unit_test(test_typedmap_set_get), \
+    cmocka_unit_test(test_typedmap_upsert), \
+    cmocka_unit_test(test_typedmap_remove), \
+    cmocka_unit_test(test_typedmap_iterate), \
+    cmocka_unit_test(test_typedmap_struct_key)
+
+
+void test_typedmap_set_get(void** state);
+void test_typedmap_upsert(void** state);
+void test_typedmap_remove(void** state);
+void test_typedmap_iterate(void** state);
+void test_typedmap_struct_key(void** state);
+
+
+#endif /* TEST_TYPEDMAP_H */